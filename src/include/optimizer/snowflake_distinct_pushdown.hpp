@@ -0,0 +1,34 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+class LogicalDistinct;
+class LogicalFilter;
+class LogicalGet;
+
+namespace snowflake {
+struct SnowflakeScanBindData;
+
+//! SnowflakeDistinctPushdown sends deduplication over a Snowflake scan to Snowflake, so only the surviving rows cross
+//! the wire: a DISTINCT becomes SELECT DISTINCT, and a filter keeping the first rows of a ROW_NUMBER, RANK or
+//! DENSE_RANK window (the "latest row per key" pattern) becomes a QUALIFY clause. The local operators stay in the
+//! plan and reduce the rows they receive to the same result.
+class SnowflakeDistinctPushdown {
+public:
+	explicit SnowflakeDistinctPushdown(ClientContext &context);
+
+	void Optimize(unique_ptr<LogicalOperator> &op);
+
+private:
+	//! Returns the Snowflake scan below child and projections, if nothing else is pushed into it yet
+	optional_ptr<SnowflakeScanBindData> GetScan(LogicalOperator &child, optional_ptr<LogicalGet> &get);
+	bool TryPushdownDistinct(LogicalDistinct &distinct);
+	bool TryPushdownQualify(LogicalFilter &filter);
+
+private:
+	ClientContext &context;
+};
+
+} // namespace snowflake
+} // namespace duckdb
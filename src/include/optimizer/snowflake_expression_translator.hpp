@@ -0,0 +1,50 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/planner/column_binding.hpp"
+
+#include <functional>
+
+namespace duckdb {
+class Expression;
+class BoundComparisonExpression;
+class BoundFunctionExpression;
+class TableFilter;
+
+namespace snowflake {
+
+//! SnowflakeExpressionTranslator renders bound DuckDB expressions as Snowflake SQL. Functions are translated through
+//! a mapping table; an expression without a known Snowflake equivalent fails to translate, so the caller keeps it
+//! local. Comparisons of date_trunc on a column with a constant become ranges on the column, which Snowflake can
+//! prune micro-partitions with.
+class SnowflakeExpressionTranslator {
+public:
+	//! Resolves a column binding to Snowflake SQL; returns false if Snowflake cannot compute the column
+	using column_resolver_t = std::function<bool(const ColumnBinding &binding, string &result)>;
+
+	explicit SnowflakeExpressionTranslator(column_resolver_t resolve_column);
+
+	bool Translate(const Expression &expr, string &result);
+	static bool TranslateConstant(const Value &value, string &result);
+	//! Renders a pushed-down table filter on column (Snowflake SQL) as a predicate
+	static bool TranslateFilter(const TableFilter &filter, const string &column, string &result);
+	//! Whether a table filter is only a hint the scan may ignore (optional and dynamic filters)
+	static bool IsOptionalFilter(const TableFilter &filter);
+	//! Whether DuckDB turns a filter expression into table filters: comparisons of a single column with constants,
+	//! IS [NOT] NULL, IN lists and conjunctions of these
+	static bool IsTableFilterCandidate(const Expression &expr);
+
+private:
+	bool TranslateChildren(const vector<unique_ptr<Expression>> &children, vector<string> &result);
+	bool TranslateFunction(const BoundFunctionExpression &function, string &result);
+	//! Translates date_trunc and date_part, whose part must be one Snowflake interprets the same way
+	bool TranslateDatePartFunction(const BoundFunctionExpression &function, string &result);
+	//! Translates comparisons of date_trunc on a column with a constant into a range on the column
+	bool TranslateTruncComparison(const BoundComparisonExpression &comparison, string &result);
+
+private:
+	column_resolver_t resolve_column;
+};
+
+} // namespace snowflake
+} // namespace duckdb
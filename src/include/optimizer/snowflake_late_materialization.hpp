@@ -0,0 +1,32 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+class Binder;
+
+namespace snowflake {
+
+//! SnowflakeLateMaterialization splits a scan of an attached table whose rows are filtered locally into two scans
+//! joined on the table's primary key. The first fetches the key and the columns the filter reads; the second fetches
+//! the remaining, wider columns only for the keys that pass the filter, which are shipped to Snowflake like the keys
+//! of a semi-join pushdown, and reads the table as of the first scan's query. Wide values of rows the filter drops are
+//! never transferred.
+class SnowflakeLateMaterialization {
+public:
+	SnowflakeLateMaterialization(ClientContext &context, Binder &binder);
+
+	void Optimize(unique_ptr<LogicalOperator> &op);
+
+private:
+	bool TryRewrite(unique_ptr<LogicalOperator> &op);
+
+private:
+	ClientContext &context;
+	Binder &binder;
+	//! Most keys the second scan is restricted to (snowflake_semi_join_max_keys)
+	idx_t max_keys = 10000000;
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+class LogicalAggregate;
+
+namespace snowflake {
+
+//! SnowflakeMetadataAggregates answers ungrouped COUNT(*), COUNT(col), MIN(col) and MAX(col) over an unfiltered
+//! attached table without scanning it. Snowflake computes these from micro-partition metadata, so the scan's query
+//! is replaced by the aggregate query, which returns one row and does not resume a suspended warehouse. Counts are
+//! always asked from Snowflake rather than taken from cached statistics, which may be out of date.
+class SnowflakeMetadataAggregates {
+public:
+	explicit SnowflakeMetadataAggregates(ClientContext &context);
+
+	void Optimize(unique_ptr<LogicalOperator> &op);
+
+private:
+	bool TryRewrite(unique_ptr<LogicalOperator> &op);
+
+private:
+	ClientContext &context;
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+
+namespace duckdb {
+class LogicalGet;
+
+namespace snowflake {
+struct SnowflakeScanBindData;
+
+//! SnowflakeOptimizer rewrites plans over Snowflake scans so that more of the work happens inside Snowflake. It runs
+//! after DuckDB's own optimizers, so the scans it sees already have their final projections.
+class SnowflakeOptimizer {
+public:
+	static OptimizerExtension GetExtension();
+	static void Optimize(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan);
+
+	//! Returns the bind data of op if it is a Snowflake scan that queries Snowflake, nullptr otherwise
+	static optional_ptr<SnowflakeScanBindData> GetScanBindData(LogicalOperator &op);
+	//! Whether Snowflake evaluates every filter DuckDB pushed into get, so no row it returns is dropped locally; needed
+	//! before pushing operators that must see the filtered rows, like a limit
+	static bool EvaluatesAllFilters(LogicalGet &get, const SnowflakeScanBindData &bind_data);
+	//! Whether type is a string type with a DuckDB collation, whose values Snowflake compares under its own rules
+	static bool IsCollated(const LogicalType &type);
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/planner/column_binding.hpp"
+
+namespace duckdb {
+class LogicalGet;
+
+namespace snowflake {
+struct SnowflakeScanBindData;
+
+//! One step of a path into a semi-structured value: an object key or an array index
+struct SnowflakePathElement {
+	string key;
+	idx_t index = 0;
+	bool is_index = false;
+};
+
+//! SnowflakePathPushdown replaces struct_extract, list element and json_extract chains over semi-structured columns
+//! of Snowflake scans by columns Snowflake computes itself (col:path), so only the extracted values cross the wire
+//! instead of the whole documents
+class SnowflakePathPushdown {
+public:
+	explicit SnowflakePathPushdown(ClientContext &context);
+
+	void Optimize(unique_ptr<LogicalOperator> &plan);
+
+	//! Parses a DuckDB JSON path ("$.a.b[0]" or a plain key); returns false for paths Snowflake cannot express
+	static bool ParseJSONPath(const string &path, vector<SnowflakePathElement> &result);
+
+private:
+	struct PathColumn {
+		string expression;
+		string name;
+		LogicalType type;
+		//! Position of the column in the scan's column ids once assigned
+		idx_t position = 0;
+	};
+	struct ScanColumn {
+		//! Whether the plan uses the whole value and not just paths into it
+		bool raw_use = false;
+		vector<PathColumn> paths;
+	};
+	struct ScanInfo {
+		LogicalGet &get;
+		SnowflakeScanBindData &bind_data;
+		//! The scan's column ids before any path took over a slot
+		vector<column_t> column_ids;
+		vector<ScanColumn> columns;
+	};
+
+	void FindScans(LogicalOperator &op);
+	void VisitOperator(LogicalOperator &op, bool rewrite);
+	void VisitExpression(unique_ptr<Expression> &expr, bool rewrite);
+	void AssignColumns(ScanInfo &scan);
+	bool IsPathColumn(const ColumnBinding &binding);
+	bool MatchPath(Expression &expr, ColumnBinding &binding, vector<SnowflakePathElement> &path);
+	PathColumn CreatePathColumn(const ColumnBinding &binding, const vector<SnowflakePathElement> &path,
+	                            const LogicalType &type);
+
+private:
+	ClientContext &context;
+	unordered_map<idx_t, ScanInfo> scans;
+};
+
+} // namespace snowflake
+} // namespace duckdb
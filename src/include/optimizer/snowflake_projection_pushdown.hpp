@@ -0,0 +1,28 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+class LogicalProjection;
+
+namespace snowflake {
+
+//! SnowflakeProjectionPushdown moves scalar expressions of a projection directly over a Snowflake scan into the
+//! SELECT list Snowflake evaluates, e.g. UPPER("NAME") or "AMOUNT" * "FX_RATE", through the expression translator's
+//! function mapping. Expressions are only pushed when the scan can then stop fetching the columns they read and the
+//! computed columns are no wider than the columns they replace, so less data crosses the wire.
+class SnowflakeProjectionPushdown {
+public:
+	explicit SnowflakeProjectionPushdown(ClientContext &context);
+
+	void Optimize(unique_ptr<LogicalOperator> &op);
+
+private:
+	void TryPushdown(LogicalProjection &projection);
+
+private:
+	ClientContext &context;
+};
+
+} // namespace snowflake
+} // namespace duckdb
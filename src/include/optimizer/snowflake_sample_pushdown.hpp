@@ -0,0 +1,25 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+//! SnowflakeSamplePushdown turns USING SAMPLE and TABLESAMPLE over a Snowflake scan into a SAMPLE clause of the scan's
+//! query, so Snowflake only returns the sampled rows: system samples become SAMPLE BLOCK (p), other percentages
+//! SAMPLE BERNOULLI (p) and row counts SAMPLE (n ROWS). The local sample is removed.
+class SnowflakeSamplePushdown {
+public:
+	explicit SnowflakeSamplePushdown(ClientContext &context);
+
+	void Optimize(unique_ptr<LogicalOperator> &op);
+
+private:
+	bool TryPushdown(unique_ptr<LogicalOperator> &op);
+
+private:
+	ClientContext &context;
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+namespace snowflake {
+struct SnowflakeScanBindData;
+
+//! SnowflakeScanSpooling marks the Snowflake scans whose query the plan runs more than once, so that the query is
+//! only sent once: scans identical to another scan (e.g. of a CTE referenced twice and inlined) and scans in the
+//! recursive part of a recursive CTE, which is re-executed on every iteration
+class SnowflakeScanSpooling {
+public:
+	void Optimize(unique_ptr<LogicalOperator> &op);
+
+private:
+	void CollectScans(LogicalOperator &op, bool repeated);
+
+private:
+	//! Scans by the query they send, together with the filters they evaluate
+	unordered_map<string, vector<reference<SnowflakeScanBindData>>> scans;
+};
+
+} // namespace snowflake
+} // namespace duckdb
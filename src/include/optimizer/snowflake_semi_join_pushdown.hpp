@@ -0,0 +1,31 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+class LogicalComparisonJoin;
+
+namespace snowflake {
+
+//! SnowflakeSemiJoinPushdown restricts a Snowflake scan probing a join to the keys of the join's local build side,
+//! so Snowflake only returns rows that can match. A key collector materializes the build side and hands its distinct
+//! keys to the scan, which sends them as an IN list or ships them into a temporary table to semi-join against.
+//! The rewrite is only chosen when the Snowflake side is estimated to be much larger than the local side
+//! (snowflake_semi_join_ratio) and the local side has few enough keys (snowflake_semi_join_max_keys).
+class SnowflakeSemiJoinPushdown {
+public:
+	explicit SnowflakeSemiJoinPushdown(ClientContext &context);
+
+	void Optimize(unique_ptr<LogicalOperator> &op);
+
+private:
+	void TryPushdown(LogicalComparisonJoin &join);
+
+private:
+	ClientContext &context;
+	idx_t ratio = 100;
+	idx_t max_keys = 10000000;
+};
+
+} // namespace snowflake
+} // namespace duckdb
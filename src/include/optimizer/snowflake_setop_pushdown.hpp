@@ -0,0 +1,29 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+class LogicalSetOperation;
+
+namespace snowflake {
+
+//! SnowflakeSetOperationPushdown sends UNION [ALL], INTERSECT and EXCEPT over Snowflake scans of the same connection
+//! to Snowflake as one statement, e.g. when unioning monthly tables or diffing two snapshots, so only the combined
+//! result crosses the wire. Every branch must be a scan (below projections of plain columns) whose filters translate;
+//! the set operation is replaced by a single scan of the combined query.
+class SnowflakeSetOperationPushdown {
+public:
+	explicit SnowflakeSetOperationPushdown(ClientContext &context);
+
+	void Optimize(unique_ptr<LogicalOperator> &op);
+
+private:
+	//! Returns the scan replacing the set operation, or nullptr if it cannot be pushed
+	unique_ptr<LogicalOperator> TryPushdown(LogicalSetOperation &set_operation);
+
+private:
+	ClientContext &context;
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+class LogicalOrder;
+class LogicalTopN;
+struct BoundOrderByNode;
+
+namespace snowflake {
+struct SnowflakeScanBindData;
+
+//! SnowflakeTopNPushdown sends ORDER BY ... LIMIT k over a Snowflake scan to Snowflake, so only the top k rows cross
+//! the wire. Vector similarity orderings (array_cosine_similarity and friends) become VECTOR_COSINE_SIMILARITY etc.
+//! The top-N itself stays in the plan and orders the rows it receives.
+//! A plain ORDER BY over a scan that orders the query result, or the rows a LIMIT picks from, is sent to Snowflake as
+//! well and the local sort is removed: the scan hands out its units with batch indices in stream order, so with
+//! insertion order preserved the rows stay sorted. Both only apply to keys DuckDB and Snowflake sort alike.
+class SnowflakeTopNPushdown {
+public:
+	explicit SnowflakeTopNPushdown(ClientContext &context);
+
+	void Optimize(unique_ptr<LogicalOperator> &op);
+
+private:
+	//! ordered_output is set if the order of op's rows is the order of the query result or of a LIMIT's input
+	void Optimize(unique_ptr<LogicalOperator> &op, bool ordered_output);
+	//! Translates orderings over child, a Snowflake scan below projections, into ORDER BY terms and returns the
+	//! scan's bind data. Only keys DuckDB and Snowflake are known to sort alike are accepted.
+	optional_ptr<SnowflakeScanBindData> TranslateOrders(LogicalOperator &child, const vector<BoundOrderByNode> &orders,
+	                                                    vector<string> &order_by);
+	bool TryPushdown(LogicalTopN &top_n);
+	bool TryPushdownOrder(LogicalOrder &order);
+
+private:
+	ClientContext &context;
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+//! SnowflakeUnionPrefetch marks the Snowflake scans of the branches of a UNION ALL that is not sent as one statement.
+//! DuckDB runs such branches one after the other while insertion order is preserved; the marked scans let the first
+//! branch to start execute the queries of the later ones ahead, each on a pooled connection, so Snowflake runs them
+//! concurrently (see SnowflakeScanPrefetches). Branches are scans below projections and filters; nested UNION ALLs
+//! are one list of branches. A UNION ALL under a LIMIT or TOP N is left alone, as its later branches may not be read.
+class SnowflakeUnionPrefetch {
+public:
+	void Optimize(unique_ptr<LogicalOperator> &op);
+
+private:
+	//! limited: whether a LIMIT or TOP N above op may stop reading its result early
+	void Optimize(unique_ptr<LogicalOperator> &op, bool limited);
+	void CollectBranches(unique_ptr<LogicalOperator> &op, vector<reference<unique_ptr<LogicalOperator>>> &branches);
+};
+
+} // namespace snowflake
+} // namespace duckdb
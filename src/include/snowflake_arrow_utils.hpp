@@ -22,6 +22,13 @@ struct SnowflakeArrowStreamFactory {
 	AdbcStatement statement;
 	bool statement_initialized = false;
 
+	// Whether to execute on the client's tracked connection and record the ID Snowflake assigns to the query
+	bool track_query_id = false;
+	std::string query_id;
+
+	// Connection of the client's pool to execute on instead, returned to the pool with the factory
+	AdbcConnection *pooled_connection = nullptr;
+
 	SnowflakeArrowStreamFactory(shared_ptr<snowflake::SnowflakeClient> conn, const std::string &query_str)
 	    : connection(conn), query(query_str) {
 		std::memset(&statement, 0, sizeof(statement));
@@ -33,6 +40,9 @@ struct SnowflakeArrowStreamFactory {
 			AdbcError error;
 			AdbcStatementRelease(&statement, &error);
 		}
+		if (pooled_connection) {
+			connection->ReleasePooledConnection(pooled_connection);
+		}
 	}
 };
 
@@ -13,6 +13,25 @@ struct SnowflakeColumn {
 	string name;
 	LogicalType type;
 	bool is_nullable;
+	//! COLLATION_NAME of a string column, e.g. en-ci; empty when Snowflake compares its values bytewise
+	string collation;
+};
+
+//! A table as listed in INFORMATION_SCHEMA.TABLES, with the size Snowflake keeps track of
+struct SnowflakeTableMetadata {
+	string name;
+	//! Invalid for views and other relations without tracked sizes
+	optional_idx row_count;
+	optional_idx bytes;
+	//! LAST_ALTERED as text, compared to detect changes
+	string last_altered;
+	//! TABLE_TYPE, e.g. BASE TABLE or VIEW
+	string table_type;
+
+	//! Whether the table stores its rows itself; views, external tables and the like compute or fetch them
+	bool IsBaseTable() const {
+		return table_type == "BASE TABLE";
+	}
 };
 
 class SnowflakeClient {
@@ -32,20 +51,55 @@ public:
 	}
 	const SnowflakeConfig &GetConfig() const;
 
+	//! A second connection for statements whose query ID is needed. The caller keeps guard locked while it executes
+	//! a statement and calls GetLastQueryId, so no other statement can run on the session in between.
+	AdbcConnection *GetTrackedConnection(unique_lock<mutex> &guard);
+	//! ID of the last query executed on the tracked connection; requires holding its lock
+	string GetLastQueryId();
+	//! Takes a connection of the pool kept for queries that run alongside the scans of the main connection, opening
+	//! one if none is idle. It is returned with ReleasePooledConnection once its statement has been released.
+	AdbcConnection *AcquirePooledConnection();
+	void ReleasePooledConnection(AdbcConnection *adbc_connection);
+
 	vector<string> ListSchemas(ClientContext &context);
-	vector<string> ListTables(ClientContext &context, const string &schema);
+	vector<SnowflakeTableMetadata> ListTables(ClientContext &context, const string &schema);
+	//! Current LAST_ALTERED of a table, formatted like SnowflakeTableMetadata::last_altered
+	string GetLastAltered(ClientContext &context, const string &schema, const string &table_name);
+	//! Same, on a connection taken from the pool
+	string GetLastAltered(AdbcConnection &adbc_connection, const string &schema, const string &table_name);
+	//! Whether change tracking is enabled on a table; throws if there is no such table
+	bool HasChangeTracking(ClientContext &context, const string &schema, const string &table_name);
+	//! Column names of the primary key declared on a table, in key order; empty without one
+	vector<string> GetPrimaryKey(ClientContext &context, const string &schema, const string &table_name);
+	//! Columns of a table as listed in INFORMATION_SCHEMA.COLUMNS, in order
 	vector<SnowflakeColumn> GetTableInfo(ClientContext &context, const string &schema, const string &table_name);
 
+	//! Runs a query whose result columns are all strings and returns them column by column (NULLs become "")
+	vector<vector<string>> ExecuteAndGetStrings(ClientContext &context, const string &query,
+	                                            const vector<string> &expected_col_names);
+	//! Same, on a connection taken from the pool
+	vector<vector<string>> ExecuteAndGetStrings(AdbcConnection &adbc_connection, const string &query,
+	                                            const vector<string> &expected_col_names);
+	//! Appends the rows of stream to an existing table through ADBC bulk ingestion, on the connection scans run on, so
+	//! the session's temporary tables can be targeted. Takes ownership of the stream.
+	void Ingest(const string &table_name, ArrowArrayStream &stream);
+
 private:
 	SnowflakeConfig config;
 	AdbcDatabase database;
 	AdbcConnection connection;
 	bool connected = false;
 
-	vector<vector<string>> ExecuteAndGetStrings(ClientContext &context, const string &query,
-	                                            const vector<string> &expected_col_names);
+	mutex tracked_lock;
+	AdbcConnection tracked_connection;
+	bool tracked_connected = false;
+
+	mutex pool_lock;
+	vector<unique_ptr<AdbcConnection>> pooled_connections;
+	vector<AdbcConnection *> idle_connections;
+
 	void InitializeDatabase(const SnowflakeConfig &config);
-	void InitializeConnection();
+	void InitializeConnection(AdbcConnection &adbc_connection);
 	void CheckError(const AdbcStatusCode status, const std::string &operation, AdbcError *error);
 };
 
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/arrow/arrow_wrapper.hpp"
+
+#include <deque>
+
+namespace duckdb {
+namespace snowflake {
+
+//! The decoder used to turn one Arrow column of a Snowflake record batch into a DuckDB vector
+enum class SnowflakeDecoderKind : uint8_t {
+	INT8,
+	INT16,
+	INT32,
+	INT64,
+	FLOAT,
+	DOUBLE,
+	BOOLEAN,
+	UTF8,
+	LARGE_UTF8,
+	//! VECTOR columns arriving as Arrow fixed-size lists, imported without copying where possible
+	FLOAT_ARRAY,
+	INT32_ARRAY,
+	//! Anything the specialized decoders do not cover goes through DuckDB's generic Arrow conversion
+	GENERIC
+};
+
+//! Picks the decoder for an Arrow column given the DuckDB type it is scanned into
+SnowflakeDecoderKind GetSnowflakeDecoderKind(const ArrowSchema &schema, const LogicalType &type);
+
+//! A contiguous run of rows taken from a single Snowflake record batch
+struct SnowflakeBatchSegment {
+	shared_ptr<ArrowArrayWrapper> batch;
+	idx_t offset;
+	idx_t count;
+	//! Whether the segment makes up its whole unit, which lets decoders reference the batch memory directly
+	bool whole_unit = false;
+};
+
+//! A unit of scan work holding at most STANDARD_VECTOR_SIZE rows, made up of one or more batch segments
+struct SnowflakeScanUnit {
+	vector<SnowflakeBatchSegment> segments;
+	//! Position of the unit within the result stream, used to preserve insertion order
+	idx_t batch_index = 0;
+	idx_t count = 0;
+};
+
+//! Snowflake returns record batches of irregular size (often a few rows, sometimes hundreds of thousands).
+//! SnowflakeBatchAligner splits large batches and coalesces small ones into STANDARD_VECTOR_SIZE-aligned units.
+class SnowflakeBatchAligner {
+public:
+	//! can_coalesce must be false when any column uses the generic decoder, which can only read a single batch
+	explicit SnowflakeBatchAligner(bool can_coalesce = true) : can_coalesce(can_coalesce) {
+	}
+
+	//! Adds a record batch, appending every completed unit to result
+	void Append(shared_ptr<ArrowArrayWrapper> batch, std::deque<SnowflakeScanUnit> &result);
+	//! Flushes the last, partially filled unit
+	void Finalize(std::deque<SnowflakeScanUnit> &result);
+	//! Number of units emitted so far
+	idx_t UnitCount() const {
+		return next_batch_index;
+	}
+
+private:
+	void EmitPending(std::deque<SnowflakeScanUnit> &result);
+
+private:
+	bool can_coalesce;
+	idx_t next_batch_index = 0;
+	SnowflakeScanUnit pending;
+};
+
+//! Decodes the rows of a segment for the batch column at stream_idx into out, starting at row out_offset.
+//! kind must not be GENERIC.
+void SnowflakeDecodeColumn(SnowflakeDecoderKind kind, const SnowflakeBatchSegment &segment, idx_t stream_idx,
+                           Vector &out, idx_t out_offset);
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+//! SnowflakeJSONReader converts the JSON text Snowflake returns for VARIANT/OBJECT/ARRAY values directly into
+//! DuckDB vectors, so nested values do not have to be re-parsed with the json functions on every access
+class SnowflakeJSONReader {
+public:
+	//! Parses count JSON documents from source (a VARCHAR vector) into result, which may be of any STRUCT, LIST,
+	//! MAP, ARRAY or scalar type. Missing object fields and values of a mismatching kind become NULL.
+	static void Convert(Vector &source, Vector &result, idx_t count);
+
+	//! Infers a nested type from sample documents. Returns LogicalType::JSON() when the samples have no
+	//! consistent structure.
+	static LogicalType InferType(const vector<string> &documents);
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -11,6 +11,13 @@ struct SnowflakeOptions {
 	//! How to handle database access (READ_ONLY or READ_WRITE)
 	AccessMode access_mode = AccessMode::READ_WRITE;
 
+	//! Tables with at most this many rows and bytes (0: no limit on that measure, both 0: off) are copied into
+	//! memory on their first scan and scanned locally from then on
+	idx_t replicate_max_rows = 0;
+	idx_t replicate_max_bytes = 0;
+	//! Seconds a local copy is used before its LAST_ALTERED is checked against Snowflake again
+	idx_t replicate_ttl_seconds = 300;
+
 	//! Whether to treat table and column names from Snowflake as case-sensitive.
 	//! If false (default), names will be converted to lowercase to match DuckDB's typical behavior.
 	// bool case_sensitive_names = false;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+//! A column Snowflake computes on top of the scanned relation, e.g. a pushed-down VARIANT path
+struct SnowflakePushedColumn {
+	string name;
+	//! Snowflake SQL expression over the columns of the scanned relation
+	string expression;
+	LogicalType type;
+};
+
+//! SnowflakeQueryBuilder generates the SQL a scan sends to Snowflake from the scanned relation and the columns the
+//! plan actually needs
+struct SnowflakeQueryBuilder {
+	//! The scanned relation: a table name or a parenthesized query
+	string source;
+	//! Columns of the scanned relation as Snowflake names them
+	vector<string> column_names;
+	//! Columns computed by Snowflake, addressed by column ids following the relation's own columns
+	vector<SnowflakePushedColumn> pushed_columns;
+	//! SAMPLE clause applied to the scanned relation, before any predicate, e.g. "BERNOULLI (1.0) SEED (42)" or
+	//! "(100 ROWS)"; empty without sampling
+	string sample;
+	//! Fraction of the rows a percentage sample keeps and row count of a fixed-size sample, for cardinality estimates
+	double sample_fraction = 1;
+	optional_idx sample_rows;
+	//! Filter expressions pushed down by the optimizer, as Snowflake SQL predicates every scan applies
+	vector<string> predicates;
+	//! Set when a DISTINCT above the scan is pushed down: Snowflake removes duplicate rows of the returned columns
+	bool distinct = false;
+	//! QUALIFY predicate pushed down from a ranking window filter above the scan, e.g. keeping the latest row per key
+	string qualify;
+	//! ORDER BY terms and row limit pushed down from a top-N above the scan
+	vector<string> order_by;
+	optional_idx limit;
+
+	static string QuoteIdentifier(const string &identifier);
+	static string QuoteString(const string &str);
+
+	//! Adds a pushed column and returns its column id; identical expressions share a column
+	idx_t AddPushedColumn(SnowflakePushedColumn column);
+	//! Name of the column a column id refers to
+	const string &GetColumnName(column_t column_id) const;
+	//! Snowflake SQL computing the column a column id refers to
+	string GetColumnExpression(column_t column_id) const;
+
+	//! The scanned relation as it appears in the FROM clause, with its sample
+	string GetRelation() const;
+	//! Sets a sample of percentage (0-100) of the rows, drawn by blocks of rows with block_sampling
+	void SetPercentageSample(double percentage, bool block_sampling, optional_idx seed);
+	//! Sets a sample of a fixed number of rows, at most MAX_SAMPLE_ROWS
+	void SetRowSample(idx_t rows);
+	//! Largest fixed-size sample Snowflake draws
+	static constexpr idx_t MAX_SAMPLE_ROWS = 1000000;
+
+	//! Builds the query returning the given columns in order, restricted to rows matching the pushed-down predicates
+	//! and all given predicates
+	string Build(const vector<column_t> &column_ids, const vector<string> &predicates = vector<string>()) const;
+};
+
+} // namespace snowflake
+} // namespace duckdb
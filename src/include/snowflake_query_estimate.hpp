@@ -0,0 +1,47 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+namespace snowflake {
+class SnowflakeClient;
+
+//! What Snowflake's compiler expects a query to read, from the GlobalStats of EXPLAIN USING JSON
+struct SnowflakeQueryEstimate {
+	idx_t partitions_total = 0;
+	idx_t partitions_assigned = 0;
+	idx_t bytes_assigned = 0;
+	//! Whether the plan only scans (and possibly filters) a single table, so its result rows are rows read
+	bool plain_scan = false;
+	//! Row count of the table a plain scan reads, if Snowflake tracks it
+	optional_idx table_rows;
+	uint64_t explained_at = 0;
+
+	//! Rough row count of the result: Snowflake's plans carry no row counts, so the table's row count is scaled by
+	//! the fraction of its partitions the plan assigns. Filters that do not prune partitions are not accounted for.
+	//! Returns an invalid index unless the plan is a plain scan of a table with a known row count, as joins and
+	//! aggregates produce rows unrelated to what they read.
+	optional_idx EstimateRows() const;
+};
+
+//! SnowflakeQueryEstimates explains snowflake_scan queries at bind time, so DuckDB gets a cardinality estimate and
+//! queries reading more than snowflake_max_bytes_scanned can be flagged before they run. Explaining only compiles the
+//! query, it does not need a running warehouse. Estimates are cached by query text.
+class SnowflakeQueryEstimates {
+public:
+	static SnowflakeQueryEstimates &Get();
+
+	//! Explains query on connection, or returns its cached estimate. Returns false if estimates are disabled or the
+	//! query cannot be explained (e.g. SHOW or CALL statements).
+	bool GetEstimate(ClientContext &context, SnowflakeClient &connection, const string &query,
+	                 SnowflakeQueryEstimate &result);
+	//! Warns about or refuses a query whose estimate exceeds snowflake_max_bytes_scanned
+	static void CheckBytesScanned(ClientContext &context, const SnowflakeQueryEstimate &estimate);
+
+private:
+	mutex lock;
+	unordered_map<string, SnowflakeQueryEstimate> estimates;
+};
+
+} // namespace snowflake
+} // namespace duckdb
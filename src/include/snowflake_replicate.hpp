@@ -0,0 +1,15 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/function/table_function.hpp"
+
+namespace duckdb {
+
+//! snowflake_replicate('catalog.schema.table', 'local_table') copies a table of an attached Snowflake database into
+//! a local DuckDB table and records the Snowflake timestamp of the copy
+TableFunction GetSnowflakeReplicateFunction();
+//! snowflake_refresh_replica('local_table') applies the inserts, updates and deletes made in Snowflake since the
+//! recorded timestamp, read with the CHANGES clause, and advances the timestamp
+TableFunction GetSnowflakeRefreshReplicaFunction();
+
+} // namespace duckdb
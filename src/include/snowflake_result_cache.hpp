@@ -0,0 +1,49 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/arrow/arrow_wrapper.hpp"
+#include "snowflake_config.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+struct SnowflakeResultCacheOptions {
+	string directory;
+	//! Entries older than this many seconds are not served and get evicted
+	idx_t ttl_seconds = 3600;
+	//! Upper bound for the total size of the cache directory; larger results are not cached
+	idx_t max_bytes = 1ULL << 30;
+
+	//! Reads the snowflake_result_cache* settings; returns false when the cache is disabled
+	static bool FromSettings(ClientContext &context, SnowflakeResultCacheOptions &result);
+};
+
+//! SnowflakeResultCache keeps complete query results on disk so that identical queries are served locally.
+//! Entries store the raw Arrow buffers of the record batches and are memory-mapped on a hit, so the scan decodes
+//! straight from the page cache without copying. Entries are written to a temporary file and renamed into place
+//! once the result has been read to the end, which lets concurrent processes share one cache directory.
+class SnowflakeResultCache {
+public:
+	explicit SnowflakeResultCache(SnowflakeResultCacheOptions options);
+
+	//! The cache key of a query: its normalized SQL plus everything in the config that affects the result
+	static string GetKey(const SnowflakeConfig &config, const string &query);
+	//! Collapses whitespace outside of literals and quoted identifiers
+	static string NormalizeQuery(const string &query);
+
+	//! Returns a stream over the cached result of key, or nullptr if there is no fresh entry
+	unique_ptr<ArrowArrayStreamWrapper> Lookup(const string &key);
+	//! Wraps a Snowflake result stream so that its batches are written to the cache as they are read
+	unique_ptr<ArrowArrayStreamWrapper> Populate(const string &key, unique_ptr<ArrowArrayStreamWrapper> stream);
+	//! Removes expired entries and, least recently used first, entries exceeding the byte budget
+	void Evict();
+
+private:
+	string GetPath(const string &key) const;
+
+private:
+	SnowflakeResultCacheOptions options;
+};
+
+} // namespace snowflake
+} // namespace duckdb
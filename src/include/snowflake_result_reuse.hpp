@@ -0,0 +1,39 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+//! A query Snowflake executed for a scan; Snowflake keeps its result for 24 hours
+struct SnowflakeExecutedQuery {
+	string query_id;
+	uint64_t executed_at = 0;
+	//! LAST_ALTERED of the scanned table as known before the query ran
+	string last_altered;
+};
+
+//! SnowflakeResultReuse remembers the query IDs of attached-table scans, so that running the same scan again while
+//! the table is unchanged reads the stored result with RESULT_SCAN instead of executing the query on a warehouse
+class SnowflakeResultReuse {
+public:
+	static SnowflakeResultReuse &Get();
+
+	//! Reads the snowflake_result_reuse settings; returns false when reuse is disabled
+	static bool IsEnabled(ClientContext &context, idx_t &window_seconds);
+	//! The query reading the stored result of query_id
+	static string GetResultScanQuery(const string &query_id);
+
+	//! Finds an execution of the query identified by key that is at most window_seconds old
+	bool Find(const string &key, idx_t window_seconds, SnowflakeExecutedQuery &result);
+	//! Records an execution, dropping executions older than window_seconds
+	void Record(const string &key, SnowflakeExecutedQuery query, idx_t window_seconds);
+	void Forget(const string &key);
+
+private:
+	mutex lock;
+	unordered_map<string, SnowflakeExecutedQuery> queries;
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -1,14 +1,102 @@
+#pragma once
+
 #include "duckdb.hpp"
+#include "duckdb/function/table/arrow.hpp"
 #include "snowflake_arrow_utils.hpp"
+#include "snowflake_decoder.hpp"
+#include "snowflake_query_builder.hpp"
+#include "snowflake_query_estimate.hpp"
+#include "snowflake_result_cache.hpp"
+#include "snowflake_result_reuse.hpp"
+#include "snowflake_scan_prefetch.hpp"
+#include "snowflake_scan_spool.hpp"
+#include "snowflake_shared_scan.hpp"
+#include "snowflake_semantic_cache.hpp"
+#include "snowflake_semi_join.hpp"
+#include "snowflake_statistics.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <thread>
 
 namespace duckdb {
 namespace snowflake {
+struct SnowflakeScanBindData;
+
+//! SnowflakeTableReplica is the local copy of a small attached table (see the replicate_max_rows ATTACH option). It
+//! is fetched by the first scan of the table that executes, not when the scan is bound, and shared by later scans.
+class SnowflakeTableReplica {
+public:
+	//! Returns the copy, fetching every column of the table with bind_data's query if no scan has done so yet
+	shared_ptr<SnowflakeSemanticCacheEntry> GetData(ClientContext &context, const SnowflakeScanBindData &bind_data);
+	//! Rows in the copy, if it has been fetched
+	optional_idx GetCount();
+
+private:
+	mutex lock;
+	shared_ptr<SnowflakeSemanticCacheEntry> data;
+};
+
+//! SnowflakeScanSnapshot passes the ID of the query one scan runs to a later scan of the same table that has to read
+//! the table as it was when that query ran, e.g. the lookup of a late materialization
+class SnowflakeScanSnapshot {
+public:
+	//! Records the ID of the query of the current execution, empty if the scan ran none
+	void SetQueryId(string query_id);
+	string GetQueryId();
+
+private:
+	mutex lock;
+	string query_id;
+};
 
 // SnowflakeScanBindData inherits from ArrowScanFunctionData to leverage DuckDB's native Arrow integration
-// This allows us to use all of DuckDB's Arrow scanning infrastructure without reimplementing it
+// This allows us to reuse DuckDB's Arrow schema handling and type mapping without reimplementing it
 struct SnowflakeScanBindData : public ArrowScanFunctionData {
 	// The factory holds the ADBC connection and statement, keeping them alive during the scan
 	unique_ptr<SnowflakeArrowStreamFactory> factory;
+	// Generates the query each scan sends, restricted to the columns the plan needs
+	SnowflakeQueryBuilder query;
+	// Identifies the scanned table in the semantic cache; empty for snowflake_scan queries, which are not cached
+	string semantic_cache_source;
+	// Schema, name and catalog-listed LAST_ALTERED of the scanned table; empty for snowflake_scan queries, whose
+	// results are not reused since the tables they read are unknown
+	string table_schema;
+	string table_name;
+	string table_last_altered;
+	// Whether the scanned table is a base table; views and external tables compute or fetch their rows on every
+	// query, so their results are not reused
+	bool is_base_table = false;
+	// Row count of the scanned table as listed by the catalog or, for snowflake_scan queries, estimated from the
+	// bytes Snowflake expects the query to read, if known
+	optional_idx estimated_cardinality;
+	// Column statistics of the scanned table, if it is an attached table
+	shared_ptr<SnowflakeTableStatistics> statistics;
+	// Names of the columns of the scanned table that Snowflake compares under a collation, e.g. case-insensitively,
+	// if it is an attached table
+	case_insensitive_set_t collated_columns;
+	// Columns of the scanned table's declared primary key, if it is an attached table and late materialization is
+	// enabled; Snowflake does not enforce primary keys, so they are trusted to be unique
+	vector<string> primary_key;
+	// Local copy of a small attached table (see the replicate_max_rows ATTACH option); when set, the scan reads
+	// it instead of querying Snowflake, fetching it first if it is empty
+	shared_ptr<SnowflakeTableReplica> replica;
+	// Set by the optimizer when the plan runs the same query more than once, e.g. for a CTE referenced twice; the
+	// first scan spools its result and later ones replay it
+	bool spool = false;
+	// Set by the optimizer when the scan probes a join whose local side is much smaller: the keys of the local side,
+	// collected before the scan starts, and the scanned column they must match
+	shared_ptr<SnowflakeSemiJoinKeys> semi_join_keys;
+	column_t semi_join_column = 0;
+	// Set by the optimizer on the scans of the branches of a UNION ALL, which DuckDB runs one after the other: the
+	// queries the branch scans on this connection send, in branch order. The first branch to start executes the
+	// later ones ahead (see SnowflakeScanPrefetches).
+	vector<string> prefetch_queries;
+	// Set by the optimizer on the two scans of a late materialization: the first records the ID of the query it runs,
+	// and the second reads the table as of that query with AT(STATEMENT => <id>), so both see the same rows
+	shared_ptr<SnowflakeScanSnapshot> record_snapshot;
+	shared_ptr<SnowflakeScanSnapshot> read_snapshot;
 
 	SnowflakeScanBindData(unique_ptr<SnowflakeArrowStreamFactory> factory_p)
 	    : ArrowScanFunctionData(SnowflakeProduceArrowScan, reinterpret_cast<uintptr_t>(factory_p.get())),
@@ -17,8 +105,129 @@ struct SnowflakeScanBindData : public ArrowScanFunctionData {
 		// 1. A function pointer to produce ArrowArrayStreamWrapper instances
 		// 2. A pointer to the factory that will be passed to that function
 	}
+
+	//! Whether filters on a column can be evaluated by Snowflake: semi-structured values are converted by the scan
+	//! and compare differently in Snowflake, and so do the values of collated columns
+	bool CanPushFilter(column_t column_id) const;
+	//! Whether Snowflake compares the values of a table column under a collation
+	bool IsCollated(column_t column_id) const;
 };
 
+//! SnowflakeScanBatches owns the result stream of a scan and splits its record batches into
+//! STANDARD_VECTOR_SIZE-aligned units. With parallel decode, a fetcher thread pulls the batches and shares this
+//! object with the scan: a scan ending early, e.g. because the query is cancelled, stops the fetcher without waiting
+//! for a fetch still on the network, and the fetcher releases the stream once that fetch returns.
+struct SnowflakeScanBatches : public enable_shared_from_this<SnowflakeScanBatches> {
+	//! Statement of the query sent for this scan, which only returns the projected columns
+	unique_ptr<SnowflakeArrowStreamFactory> factory;
+	//! Result cache the stream is written to while it is read, if the cache missed
+	unique_ptr<SnowflakeResultCache> cache;
+	//! The Arrow stream returned by Snowflake or by the result cache
+	unique_ptr<ArrowArrayStreamWrapper> stream;
+
+	SnowflakeBatchAligner aligner;
+
+	//! Starts the fetcher thread, which keeps up to max_ready_units units ahead of the decoders
+	void StartFetcher(idx_t max_ready_units);
+	//! Stops the fetcher without waiting for it
+	void StopFetcher();
+	//! Fetches the next unit of work, returns false once the stream is exhausted. Waiting for the fetcher ends
+	//! with an InterruptException when the query is interrupted.
+	bool NextUnit(ClientContext &context, SnowflakeScanUnit &unit);
+	//! Number of units the stream has been split into so far
+	idx_t UnitCount();
+
+private:
+	//! Splits a batch into units, or flushes the last unit at the end of the stream; requires the lock
+	void AddBatch(unique_ptr<ArrowArrayWrapper> batch);
+	void FetchBatches();
+
+	mutex lock;
+	std::deque<SnowflakeScanUnit> ready_units;
+	bool done = false;
+
+	std::thread fetcher;
+	bool fetcher_active = false;
+	bool cancelled = false;
+	idx_t max_ready_units = 0;
+	std::condition_variable units_available;
+	std::condition_variable space_available;
+	ErrorData fetch_error;
+};
+
+//! SnowflakeScanGlobalState hands out the units of the result stream, or the chunks of a cached result, to the threads
+struct SnowflakeScanGlobalState : public GlobalTableFunctionState {
+	shared_ptr<SnowflakeScanBatches> batches = make_shared_ptr<SnowflakeScanBatches>();
+	//! Pushed-down filters Snowflake does not evaluate, applied to the decoded chunks
+	unique_ptr<Expression> local_filter;
+	//! Set when the scan is answered from the semantic cache, together with the entry column of every output
+	//! column (invalid for row ids); chunks of the entry are handed out in order
+	shared_ptr<SnowflakeSemanticCacheEntry> cache_entry;
+	vector<optional_idx> cache_columns;
+	atomic<idx_t> next_cache_chunk {0};
+	//! Spool the decoded units are added to, if this scan fills one
+	shared_ptr<SnowflakeScanSpool> spool;
+	//! Learns column statistics from the decoded units, if this is a full scan of an attached table
+	unique_ptr<SnowflakeStatisticsCollector> statistics_collector;
+	//! Schema and Arrow types of the record batches as they actually arrive
+	ArrowSchemaWrapper stream_schema;
+	ArrowTableType stream_types;
+
+	//! For every output column: the index of its child array within the record batches and how to decode it
+	//! (the query returns exactly the projected columns, so this is the output column index)
+	vector<idx_t> stream_column_ids;
+	vector<SnowflakeDecoderKind> decoders;
+	//! Output columns that go through DuckDB's generic Arrow conversion
+	vector<idx_t> generic_columns;
+	vector<LogicalType> generic_types;
+	//! Output columns whose type differs from the stream type (e.g. VARIANT exposed as STRUCT): they are decoded
+	//! into a staging chunk and converted from there
+	vector<optional_idx> staging_index;
+	vector<LogicalType> staging_types;
+
+	idx_t max_threads = 1;
+
+	~SnowflakeScanGlobalState() override;
+
+	idx_t MaxThreads() const override {
+		return max_threads;
+	}
+};
+
+//! SnowflakeScanLocalState derives from ArrowScanLocalState so columns without a specialized decoder can be
+//! converted through ArrowTableFunction::ArrowToDuckDB
+struct SnowflakeScanLocalState : public ArrowScanLocalState {
+	explicit SnowflakeScanLocalState(ClientContext &context)
+	    : ArrowScanLocalState(make_shared_ptr<ArrowArrayWrapper>(), context) {
+	}
+
+	SnowflakeScanUnit unit;
+	//! Intermediate chunk holding the generically converted columns
+	DataChunk generic_chunk;
+	//! Intermediate chunk holding the columns that still need a type conversion
+	DataChunk staging_chunk;
+	//! Evaluates the global state's local filter
+	unique_ptr<ExpressionExecutor> filter_executor;
+	SelectionVector filter_sel;
+	//! Chunk of the semantic cache entry being scanned
+	DataChunk cache_chunk;
+};
+
+//! Resolves the result schema of the scanned relation (source is a table name or a parenthesized query).
+//! Semi-structured columns are exposed as JSON or nested types; when inference_rows is non-zero, untyped
+//! VARIANT/OBJECT/ARRAY columns get a type inferred from a result sample
+void SnowflakeBindSchema(ClientContext &context, SnowflakeScanBindData &bind_data, const string &source,
+                         vector<string> &names, vector<LogicalType> &return_types, idx_t inference_rows);
+
+//! Runs query, which returns the columns column_ids of a bound scan in order, and passes the decoded chunks to
+//! callback in the order Snowflake returns the rows in
+void SnowflakeScanQuery(ClientContext &context, const SnowflakeScanBindData &bind_data, const string &query,
+                        const vector<column_t> &column_ids, const std::function<void(DataChunk &)> &callback);
+
+//! Decodes a unit of work into the output chunk
+void SnowflakeDecodeUnit(const SnowflakeScanGlobalState &global_state, SnowflakeScanLocalState &local_state,
+                         DataChunk &output);
+
 static unique_ptr<FunctionData> SnowflakeScanBind(ClientContext &context, TableFunctionBindInput &input,
                                                   vector<LogicalType> &return_types, vector<string> &names);
 
@@ -26,4 +235,4 @@ static unique_ptr<FunctionData> SnowflakeScanBind(ClientContext &context, TableF
 
 TableFunction GetSnowflakeScanFunction();
 
-} // namespace duckdb
\ No newline at end of file
+} // namespace duckdb
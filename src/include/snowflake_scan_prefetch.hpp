@@ -0,0 +1,65 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/arrow/arrow_wrapper.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "snowflake_arrow_utils.hpp"
+
+#include <condition_variable>
+#include <thread>
+
+namespace duckdb {
+namespace snowflake {
+
+//! A query executed ahead of the scan that sends it, on a pooled connection
+struct SnowflakePrefetchedQuery {
+	unique_ptr<SnowflakeArrowStreamFactory> factory;
+	unique_ptr<ArrowArrayStreamWrapper> stream;
+	bool done = false;
+	//! Set when the DuckDB query ends before a scan picked the result up; the execution is cancelled
+	bool cancelled = false;
+	mutex lock;
+	std::condition_variable executed;
+};
+
+//! SnowflakeScanPrefetches holds the queries of the running DuckDB query executed ahead of their scans. The branches
+//! of a UNION ALL run one after the other when insertion order is preserved; the first branch scan to start executes
+//! the queries of the later ones (see SnowflakeScanBindData::prefetch_queries), each on its own pooled connection, so
+//! Snowflake runs them while the earlier branches are read. When the query ends, executions no scan picked up are
+//! cancelled and the threads running them are joined, so none outlives the query.
+class SnowflakeScanPrefetches : public ClientContextState {
+public:
+	~SnowflakeScanPrefetches() override;
+
+	static SnowflakeScanPrefetches &Get(ClientContext &context);
+	//! Most queries executed ahead at a time (snowflake_union_prefetch); 0 disables the prefetch
+	static idx_t GetMaxQueries(ClientContext &context);
+
+	//! Returns the stream of query if it was executed ahead, waiting for the execution to finish; nullptr if it was
+	//! not, or if it failed. The query is not executed ahead afterwards. Throws if the query is interrupted while
+	//! waiting.
+	unique_ptr<ArrowArrayStreamWrapper> Take(ClientContext &context, const shared_ptr<SnowflakeClient> &connection,
+	                                         const string &query, unique_ptr<SnowflakeArrowStreamFactory> &factory);
+	//! Executes the queries not taken or executed yet in the background, in order, while fewer than max_queries
+	//! results are pending
+	void Start(const shared_ptr<SnowflakeClient> &connection, const vector<string> &queries, idx_t max_queries);
+
+	void QueryEnd() override;
+
+private:
+	//! Cancels the executions no scan picked up, waits for all threads and forgets the query's executions
+	void CancelAll();
+
+	mutex lock;
+	//! Executions no scan has picked up yet, keyed like the result cache
+	unordered_map<string, shared_ptr<SnowflakePrefetchedQuery>> pending;
+	//! Keys of the queries executed ahead or taken by their scan during this query
+	unordered_set<string> seen;
+	//! Every execution started during this query, cancelled when it ends unless done
+	vector<shared_ptr<SnowflakePrefetchedQuery>> started;
+	//! Threads executing queries ahead, joined when the query ends
+	vector<std::thread> threads;
+};
+
+} // namespace snowflake
+} // namespace duckdb
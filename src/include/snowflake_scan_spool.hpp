@@ -0,0 +1,57 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+#include "snowflake_semantic_cache.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+//! SnowflakeScanSpool keeps the decoded result of a Snowflake query for the rest of the running DuckDB query, in
+//! buffer-managed memory that can spill to disk. Units are added in stream order, whatever order the threads
+//! decode them in, so a spool can be replayed in place of the query.
+class SnowflakeScanSpool {
+public:
+	SnowflakeScanSpool(ClientContext &context, const vector<LogicalType> &types);
+
+	//! Adds the decoded unit with the given batch index
+	void Append(idx_t batch_index, DataChunk &chunk);
+	//! Called once the stream is exhausted, with the number of units it was split into
+	void SetUnitCount(idx_t unit_count);
+	//! The complete result, or nullptr while units are missing
+	shared_ptr<SnowflakeSemanticCacheEntry> GetResult();
+
+private:
+	void AppendInOrder(DataChunk &chunk);
+
+private:
+	BufferManager &buffer_manager;
+	mutex lock;
+	shared_ptr<SnowflakeSemanticCacheEntry> result;
+	ColumnDataAppendState append_state;
+	idx_t next_batch_index = 0;
+	optional_idx unit_count;
+	//! Units decoded ahead of the next one in stream order, buffer-managed like the result as a slow unit can hold
+	//! back many others
+	map<idx_t, unique_ptr<ColumnDataCollection>> pending;
+};
+
+//! SnowflakeScanSpools holds the spools of the running query, keyed on the SQL of the spooled query
+class SnowflakeScanSpools : public ClientContextState {
+public:
+	static SnowflakeScanSpools &Get(ClientContext &context);
+
+	//! Returns the spool of key; created is set if no scan spooled key before and the caller has to fill it
+	shared_ptr<SnowflakeScanSpool> GetOrCreate(ClientContext &context, const string &key,
+	                                           const vector<LogicalType> &types, bool &created);
+
+	void QueryEnd() override;
+
+private:
+	mutex lock;
+	unordered_map<string, shared_ptr<SnowflakeScanSpool>> spools;
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/types/column/column_data_collection.hpp"
+
+namespace duckdb {
+class TableFilter;
+
+namespace snowflake {
+
+//! The range a predicate restricts one column to. Bounds are NULL when the column is unbounded on that side.
+struct SnowflakeColumnRange {
+	Value lower;
+	bool lower_inclusive = false;
+	Value upper;
+	bool upper_inclusive = false;
+	bool not_null = false;
+
+	//! Narrows the range by a table filter; returns false if the filter is not a (conjunction of) comparisons
+	bool Intersect(const TableFilter &filter);
+	//! Whether every value inside other is inside this range as well
+	bool Contains(const SnowflakeColumnRange &other) const;
+};
+
+//! SnowflakeCachePredicate describes the rows of a scan as a conjunction of column ranges, which the cache can
+//! compare, and of other Snowflake SQL terms, which are only matched textually
+struct SnowflakeCachePredicate {
+	//! Keyed by the Snowflake SQL of the column
+	map<string, SnowflakeColumnRange> ranges;
+	set<string> terms;
+
+	//! Adds a filter on column; sql is its Snowflake translation, used when the filter is not a range
+	void AddFilter(const string &column, const TableFilter &filter, const string &sql);
+	//! Whether every row matching this predicate also matches other
+	bool Implies(const SnowflakeCachePredicate &other) const;
+};
+
+//! A cached scan result: some columns of a table, fetched under a predicate
+struct SnowflakeSemanticCacheEntry {
+	//! Snowflake SQL and type of every column of data
+	vector<string> columns;
+	vector<LogicalType> types;
+	//! The predicate the rows were fetched under, as the cache compares it and as it was sent to Snowflake
+	SnowflakeCachePredicate predicate;
+	vector<string> remote_predicates;
+	unique_ptr<ColumnDataCollection> data;
+	//! LAST_ALTERED of the table, read before the rows were fetched; the entry is stale once it changes
+	string last_altered;
+	uint64_t created_at = 0;
+	atomic<uint64_t> last_used {0};
+
+	optional_idx GetColumn(const string &column, const LogicalType &type) const;
+};
+
+//! SnowflakeSemanticCache keeps the results of attached-table scans in memory, column by column, together with the
+//! predicate they were fetched under. A scan whose predicate implies the cached one is answered from the cache and
+//! filtered locally; if the entry lacks columns, its rows are fetched again with all of them and replace it.
+class SnowflakeSemanticCache {
+public:
+	static SnowflakeSemanticCache &Get();
+
+	//! Finds the entry for source that best covers a scan of columns under predicate: one containing all columns,
+	//! or else the entry containing the most. Entries older than ttl_seconds or fetched before the table was last
+	//! altered are dropped.
+	shared_ptr<SnowflakeSemanticCacheEntry> Find(const string &source, const vector<string> &columns,
+	                                             const vector<LogicalType> &types,
+	                                             const SnowflakeCachePredicate &predicate, const string &last_altered,
+	                                             idx_t ttl_seconds);
+	//! Adds an entry, replacing old if given, and evicts least recently used entries beyond max_bytes
+	void Insert(const string &source, shared_ptr<SnowflakeSemanticCacheEntry> entry,
+	            optional_ptr<SnowflakeSemanticCacheEntry> old, idx_t max_bytes);
+
+	static uint64_t CurrentTime();
+
+private:
+	mutex lock;
+	unordered_map<string, vector<shared_ptr<SnowflakeSemanticCacheEntry>>> entries;
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/types/value_map.hpp"
+#include "duckdb/execution/physical_operator.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "duckdb/planner/operator/logical_extension_operator.hpp"
+
+namespace duckdb {
+namespace snowflake {
+class SnowflakeClient;
+
+//! SnowflakeSemiJoinKeys carries the distinct join keys of the local side of a join to the Snowflake scan on the
+//! other side. The keys are collected while the join's build side is materialized; when the scan starts afterwards,
+//! it restricts its query to rows matching them: with an IN list for a few keys, otherwise with a semi-join against
+//! a temporary table the keys are bulk-ingested into through ADBC, on the session the scan's query runs on.
+class SnowflakeSemiJoinKeys {
+public:
+	SnowflakeSemiJoinKeys(LogicalType type, idx_t max_keys);
+
+	//! Whether join keys of type can be shipped: types whose equality means the same in Snowflake
+	static bool IsSupportedType(const LogicalType &type);
+
+	const LogicalType &GetType() const {
+		return type;
+	}
+	idx_t GetMaxKeys() const {
+		return max_keys;
+	}
+
+	//! Forgets the keys of a previous execution of the plan
+	void Reset();
+	//! Records the complete set of keys; without keys, the local side had more than max_keys of them
+	void SetKeys(value_set_t keys);
+	void SetOverflow();
+
+	//! Predicate restricting column (Snowflake SQL) to the keys, shipping them to Snowflake on client if needed.
+	//! Returns an empty string if the keys are not complete yet, there are too many or they could not be shipped.
+	string GetPredicate(ClientContext &context, const shared_ptr<SnowflakeClient> &client, const string &column);
+
+private:
+	//! Creates a temporary table on client, ingests the keys into it and returns its name; requires the lock
+	string ShipKeys(ClientContext &context, const shared_ptr<SnowflakeClient> &client);
+
+	LogicalType type;
+	idx_t max_keys;
+
+	mutex lock;
+	bool complete = false;
+	bool overflow = false;
+	vector<Value> keys;
+	//! Temporary table holding the keys once shipped, empty before
+	string table_name;
+	bool ship_failed = false;
+};
+
+//! SnowflakeSemiJoinTables drops the temporary key tables created for a query once it ends
+class SnowflakeSemiJoinTables : public ClientContextState {
+public:
+	static SnowflakeSemiJoinTables &Get(ClientContext &context);
+
+	void Add(shared_ptr<SnowflakeClient> client, string table_name);
+	void QueryEnd(ClientContext &context) override;
+
+private:
+	mutex lock;
+	vector<pair<shared_ptr<SnowflakeClient>, string>> tables;
+};
+
+//! LogicalSnowflakeKeyCollector sits on the local side of a join whose other side is a Snowflake scan and passes
+//! its input through, collecting the distinct values of its only expression, the local join key
+class LogicalSnowflakeKeyCollector : public LogicalExtensionOperator {
+public:
+	LogicalSnowflakeKeyCollector(shared_ptr<SnowflakeSemiJoinKeys> keys, unique_ptr<Expression> key);
+
+	shared_ptr<SnowflakeSemiJoinKeys> keys;
+
+	vector<ColumnBinding> GetColumnBindings() override;
+	PhysicalOperator &CreatePlan(ClientContext &context, PhysicalPlanGenerator &planner) override;
+	string GetExtensionName() const override;
+
+protected:
+	void ResolveTypes() override;
+};
+
+//! PhysicalSnowflakeKeyCollector materializes its input while collecting the keys, hands the complete key set to
+//! the scan in Finalize and then emits the materialized rows. Being a sink guarantees the keys are complete before
+//! the join's build side, and therefore the Snowflake scan probing it, continues.
+class PhysicalSnowflakeKeyCollector : public PhysicalOperator {
+public:
+	static constexpr const PhysicalOperatorType TYPE = PhysicalOperatorType::EXTENSION;
+
+	PhysicalSnowflakeKeyCollector(PhysicalPlan &physical_plan, vector<LogicalType> types, unique_ptr<Expression> key,
+	                              shared_ptr<SnowflakeSemiJoinKeys> keys, idx_t estimated_cardinality);
+
+	unique_ptr<Expression> key;
+	shared_ptr<SnowflakeSemiJoinKeys> keys;
+
+public:
+	// Source interface
+	unique_ptr<GlobalSourceState> GetGlobalSourceState(ClientContext &context) const override;
+	SourceResultType GetData(ExecutionContext &context, DataChunk &chunk, OperatorSourceInput &input) const override;
+	bool IsSource() const override {
+		return true;
+	}
+
+public:
+	// Sink interface
+	unique_ptr<GlobalSinkState> GetGlobalSinkState(ClientContext &context) const override;
+	unique_ptr<LocalSinkState> GetLocalSinkState(ExecutionContext &context) const override;
+	SinkResultType Sink(ExecutionContext &context, DataChunk &chunk, OperatorSinkInput &input) const override;
+	SinkCombineResultType Combine(ExecutionContext &context, OperatorSinkCombineInput &input) const override;
+	SinkFinalizeType Finalize(Pipeline &pipeline, Event &event, ClientContext &context,
+	                          OperatorSinkFinalizeInput &input) const override;
+	bool IsSink() const override {
+		return true;
+	}
+	bool ParallelSink() const override {
+		return true;
+	}
+
+	string GetName() const override;
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/arrow/arrow_wrapper.hpp"
+#include "snowflake_arrow_utils.hpp"
+
+#include <condition_variable>
+
+namespace duckdb {
+namespace snowflake {
+
+//! A Snowflake query in flight whose record batches are handed to several consumers
+struct SnowflakeSharedScan {
+	string key;
+	mutex lock;
+	unique_ptr<SnowflakeArrowStreamFactory> factory;
+	unique_ptr<ArrowArrayStreamWrapper> source;
+	//! Batches read from the source so far; released once no consumer needs them and no new one can join
+	vector<shared_ptr<ArrowArrayWrapper>> batches;
+	idx_t released_batches = 0;
+	idx_t buffered_rows = 0;
+	//! Rows of the batches not released yet
+	idx_t retained_rows = 0;
+	idx_t max_buffered_rows = 0;
+	//! Whether consumers ahead wait for lagging ones rather than retain more than max_buffered_rows; cleared if a
+	//! lagging consumer stops reading
+	bool capped = true;
+	//! Set while a consumer reads the next batch from the source, which happens without holding the lock
+	bool fetching = false;
+	//! Signalled when a batch was read or released, or the source is exhausted
+	std::condition_variable changed;
+	bool finished = false;
+	//! Whether consumers can still join, which requires every batch to be buffered
+	bool joinable = true;
+	string error;
+	//! Index of the next batch of every consumer
+	unordered_map<idx_t, idx_t> positions;
+	idx_t next_consumer = 0;
+
+	//! Releases the batches every consumer has read, once no consumer can join anymore
+	void ReleaseReadBatches();
+};
+
+//! SnowflakeSharedScans lets identical queries (same config and SQL) that run at the same time, e.g. from many
+//! connections opening the same report, share one execution. The first query runs in Snowflake; queries arriving
+//! while it is in flight attach to it, replay the batches read so far and then read along. Every consumer gets the
+//! same batches, without copies.
+class SnowflakeSharedScans {
+public:
+	static SnowflakeSharedScans &Get();
+
+	//! Reads the snowflake_shared_scans settings; returns false when sharing is disabled
+	static bool IsEnabled(ClientContext &context, idx_t &max_buffered_rows);
+
+	//! Returns a stream over the result of query, attached to an identical query in flight if there is one. Returns
+	//! nullptr if the matching query already dropped batches a new consumer would need. If this call executes the
+	//! query and track_query_id is set, executed_query_id receives its Snowflake query ID.
+	unique_ptr<ArrowArrayStreamWrapper> Open(shared_ptr<SnowflakeClient> connection, const string &key,
+	                                         const string &query, idx_t max_buffered_rows, bool track_query_id,
+	                                         string &executed_query_id);
+	//! Stops new consumers from joining scan; requires holding its lock
+	void Close(SnowflakeSharedScan &scan);
+
+private:
+	mutex lock;
+	unordered_map<string, weak_ptr<SnowflakeSharedScan>> scans;
+};
+
+} // namespace snowflake
+} // namespace duckdb
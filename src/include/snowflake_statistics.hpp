@@ -0,0 +1,140 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/types/hyperloglog.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "duckdb/storage/statistics/base_statistics.hpp"
+#include <arrow-adbc/adbc.h>
+
+#include <thread>
+
+namespace duckdb {
+namespace snowflake {
+class SnowflakeClient;
+
+//! SnowflakeTableStatistics keeps the column statistics of one attached table. They are learned from full scans of
+//! the table (see SnowflakeStatisticsCollector) or gathered for all columns at once with a single aggregate query
+//! (COUNT, APPROX_COUNT_DISTINCT and, for numeric and date columns, MIN and MAX, which Snowflake mostly answers from
+//! micro-partition metadata) on a background thread, so planning does not wait for it. The thread belongs to the
+//! statistics and runs on a pooled Snowflake connection without a DuckDB connection, so it does not keep the database
+//! alive; dropping the statistics, e.g. when the database is detached or closed, cancels the query and joins the
+//! thread. Once the TTL has passed, the
+//! table's LAST_ALTERED is checked and all statistics are dropped if the table changed. DuckDB prunes filters and
+//! NULL handling with column statistics, so they are only handed out after LAST_ALTERED was confirmed during the
+//! running query.
+class SnowflakeTableStatistics {
+public:
+	SnowflakeTableStatistics(shared_ptr<SnowflakeClient> client, string schema, string table_name);
+	~SnowflakeTableStatistics();
+
+	//! Reads the snowflake_statistics settings: whether statistics are gathered with queries and whether they are
+	//! learned from scans. Returns false when neither is enabled.
+	static bool IsEnabled(ClientContext &context, bool &gather, bool &learn, idx_t &ttl_seconds);
+	//! Whether Snowflake orders values of type like DuckDB does, so their MIN and MAX carry over
+	static bool HasMinMax(const LogicalType &type);
+
+	//! Statistics of column column_index of the table, whose columns are given by their Snowflake names and DuckDB
+	//! types. Returns nullptr if statistics are disabled or the column has none yet, in which case gathering them
+	//! starts in the background.
+	unique_ptr<BaseStatistics> GetColumn(ClientContext &context, const vector<string> &names,
+	                                     const vector<LogicalType> &types, idx_t column_index);
+	//! Number of rows of the table when the statistics were taken, if known
+	optional_idx GetRowCount();
+
+	//! Whether a scan of the named columns should learn their statistics
+	bool NeedsLearning(const vector<string> &names);
+	//! LAST_ALTERED of the table as known before a scan starts: the one the statistics were taken at, or listed
+	string GetLastAltered(const string &listed_last_altered);
+	//! Records the statistics of a full scan that started when the table's LAST_ALTERED was last_altered
+	void Learn(const string &last_altered, vector<string> names, vector<unique_ptr<BaseStatistics>> stats,
+	           idx_t row_count);
+
+private:
+	//! Drops all statistics if LAST_ALTERED changed, checking it once the TTL has passed; requires holding the lock
+	void Validate(ClientContext &context, idx_t ttl_seconds);
+	void Reset(string current_last_altered);
+	//! Runs Gather on the background thread; requires holding the lock
+	void StartGather(const vector<string> &names, const vector<LogicalType> &types);
+	//! Runs the aggregate query on a pooled connection and records its statistics; takes the lock only to publish
+	//! the connection and once the query returned
+	void Gather(const vector<string> &names, const vector<LogicalType> &types);
+
+	shared_ptr<SnowflakeClient> client;
+	string schema;
+	string table_name;
+
+	mutex lock;
+	//! Statistics by Snowflake column name; each carries the type it was taken for
+	unordered_map<string, unique_ptr<BaseStatistics>> columns;
+	optional_idx row_count;
+	//! Whether the aggregate query ran since the table last changed, is running, or when it last failed
+	bool gathered = false;
+	bool gathering = false;
+	uint64_t failed_at = 0;
+	//! LAST_ALTERED the statistics were taken after (empty while unknown), and when it was last confirmed
+	string last_altered;
+	uint64_t checked_at = 0;
+	//! Thread running Gather, and the pooled connection its query runs on while it does
+	std::thread gatherer;
+	AdbcConnection *gather_connection = nullptr;
+	bool shutting_down = false;
+};
+
+//! SnowflakeConfirmedStatistics records the tables whose LAST_ALTERED was checked during the running query, so it is
+//! checked at most once per table and query
+class SnowflakeConfirmedStatistics : public ClientContextState {
+public:
+	static SnowflakeConfirmedStatistics &Get(ClientContext &context);
+
+	//! Returns true if statistics were not confirmed during the running query yet, and marks them as confirmed
+	bool Confirm(const SnowflakeTableStatistics &statistics);
+
+	void QueryEnd() override;
+
+private:
+	mutex lock;
+	unordered_set<const SnowflakeTableStatistics *> confirmed;
+};
+
+//! SnowflakeStatisticsCollector learns the statistics of the columns of a full table scan from the decoded chunks:
+//! exact row, null and min/max values, and HyperLogLog sketches for distinct counts. Threads update it as they decode
+//! units; once every unit of the stream has been seen, the statistics are handed to the table.
+class SnowflakeStatisticsCollector {
+public:
+	//! names has the Snowflake column name of every output column of the scan, or an empty name for output columns
+	//! that are not learned
+	SnowflakeStatisticsCollector(shared_ptr<SnowflakeTableStatistics> statistics, string last_altered,
+	                             const vector<string> &names, const vector<LogicalType> &types);
+
+	//! Adds the decoded chunk of one unit
+	void Update(DataChunk &chunk);
+	//! Called once the stream is exhausted, with the number of units it was split into
+	void SetUnitCount(idx_t unit_count);
+
+private:
+	struct LearnedColumn {
+		idx_t output_index;
+		string name;
+		LogicalType type;
+		idx_t valid_count = 0;
+		Value min;
+		Value max;
+		HyperLogLog distinct;
+	};
+
+	//! Hands the statistics to the table once all units have been seen; requires holding the lock
+	void PublishIfComplete();
+
+	shared_ptr<SnowflakeTableStatistics> statistics;
+	string last_altered;
+
+	mutex lock;
+	vector<LearnedColumn> columns;
+	idx_t row_count = 0;
+	idx_t units_seen = 0;
+	optional_idx unit_count;
+	bool published = false;
+};
+
+} // namespace snowflake
+} // namespace duckdb
@@ -11,7 +11,7 @@ namespace snowflake {
 class SnowflakeCatalog : public Catalog {
 public:
 	// Constructor - connection info
-	SnowflakeCatalog(AttachedDatabase &db_p, const SnowflakeConfig &config);
+	SnowflakeCatalog(AttachedDatabase &db_p, const SnowflakeConfig &config, const SnowflakeOptions &options);
 
 	~SnowflakeCatalog();
 
@@ -40,6 +40,14 @@ public:
 
 	DatabaseSize GetDatabaseSize(ClientContext &context) override;
 
+	shared_ptr<SnowflakeClient> GetClient() const {
+		return client;
+	}
+
+	const SnowflakeOptions &GetOptions() const {
+		return options;
+	}
+
 	bool InMemory() override;
 
 	string GetDBPath() override;
@@ -56,6 +64,7 @@ public:
 
 private:
 	shared_ptr<SnowflakeClient> client;
+	SnowflakeOptions options;
 	SnowflakeSchemaSet schemas;
 };
 } // namespace snowflake
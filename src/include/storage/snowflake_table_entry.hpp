@@ -3,9 +3,13 @@
 #include "duckdb/catalog/catalog_entry/table_catalog_entry.hpp"
 #include "snowflake_config.hpp"
 #include "snowflake_client.hpp"
+#include "snowflake_semantic_cache.hpp"
+#include "snowflake_statistics.hpp"
 
 namespace duckdb {
 namespace snowflake {
+struct SnowflakeScanBindData;
+class SnowflakeTableReplica;
 
 //! SnowflakeTableBindData contains metadata for a snowflake table and informs the scan function the structure of the
 //! data it should receive
@@ -42,8 +46,10 @@ struct SnowflakeTableBindData : public FunctionData {
 class SnowflakeTableEntry : public TableCatalogEntry {
 public:
 	SnowflakeTableEntry(Catalog &catalog, SchemaCatalogEntry &schema, CreateTableInfo &info,
-	                    shared_ptr<SnowflakeClient> client)
-	    : TableCatalogEntry(catalog, schema, info), client(client) {};
+	                    shared_ptr<SnowflakeClient> client, SnowflakeTableMetadata metadata)
+	    : TableCatalogEntry(catalog, schema, info), client(client), metadata(std::move(metadata)),
+	      statistics(make_shared_ptr<SnowflakeTableStatistics>(client, schema.name, info.table)),
+	      replica_last_altered(this->metadata.last_altered) {};
 
 	string GetFullyQualifiedName() const {
 		return catalog.GetName() + "." + schema.name + "." + name;
@@ -60,8 +66,36 @@ public:
 	TableStorageInfo GetStorageInfo(ClientContext &context) override;
 
 private:
+	//! Whether the table is small enough to be scanned from a local copy, per the ATTACH options
+	bool IsReplicated() const;
+	//! Returns the local copy, replaced by an empty one if LAST_ALTERED changed once the TTL has passed; nullptr if
+	//! LAST_ALTERED could not be checked
+	shared_ptr<SnowflakeTableReplica> GetReplica(ClientContext &context);
+	//! Column names of the table's primary key, looked up on first use
+	vector<string> GetPrimaryKey(ClientContext &context);
+	//! Names of the columns Snowflake compares under a collation, looked up on first use
+	case_insensitive_set_t GetCollatedColumns(ClientContext &context);
+
 	shared_ptr<SnowflakeClient> client;
+	SnowflakeTableMetadata metadata;
 	bool columns_loaded = false;
+	//! Column statistics, shared with the scans of the table
+	shared_ptr<SnowflakeTableStatistics> statistics;
+
+	mutex replica_lock;
+	//! The local copy of a replicated table, filled by the first scan that reads it
+	shared_ptr<SnowflakeTableReplica> replica;
+	//! LAST_ALTERED the copy was taken after, and when it was last confirmed
+	string replica_last_altered;
+	uint64_t replica_checked_at = 0;
+
+	mutex primary_key_lock;
+	bool primary_key_loaded = false;
+	vector<string> primary_key;
+
+	mutex collation_lock;
+	bool collations_loaded = false;
+	case_insensitive_set_t collated_columns;
 };
 } // namespace snowflake
 } // namespace duckdb
\ No newline at end of file
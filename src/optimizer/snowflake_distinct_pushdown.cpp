@@ -0,0 +1,247 @@
+#include "optimizer/snowflake_distinct_pushdown.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
+#include "optimizer/snowflake_expression_translator.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_comparison_expression.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
+#include "duckdb/planner/expression/bound_window_expression.hpp"
+#include "duckdb/planner/operator/logical_distinct.hpp"
+#include "duckdb/planner/operator/logical_filter.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/planner/operator/logical_projection.hpp"
+#include "duckdb/planner/operator/logical_window.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakeDistinctPushdown::SnowflakeDistinctPushdown(ClientContext &context) : context(context) {
+}
+
+optional_ptr<SnowflakeScanBindData> SnowflakeDistinctPushdown::GetScan(LogicalOperator &child,
+                                                                       optional_ptr<LogicalGet> &get) {
+	reference<LogicalOperator> current = child;
+	while (current.get().type == LogicalOperatorType::LOGICAL_PROJECTION) {
+		current = *current.get().children[0];
+	}
+	auto bind_data = SnowflakeOptimizer::GetScanBindData(current.get());
+	if (!bind_data) {
+		return nullptr;
+	}
+	// Deduplication applies to the rows the scan produces, before any ordering, limit or join restriction
+	auto &query = bind_data->query;
+	if (query.distinct || !query.qualify.empty() || !query.order_by.empty() || query.limit.IsValid() ||
+	    bind_data->semi_join_keys) {
+		return nullptr;
+	}
+	get = current.get().Cast<LogicalGet>();
+	return bind_data;
+}
+
+bool SnowflakeDistinctPushdown::TryPushdownDistinct(LogicalDistinct &distinct) {
+	if (distinct.distinct_type != DistinctType::DISTINCT || distinct.order_by) {
+		return false;
+	}
+	optional_ptr<LogicalGet> get;
+	auto bind_data = GetScan(*distinct.children[0], get);
+	if (!bind_data) {
+		return false;
+	}
+	// Snowflake removes rows that are equal in every returned column, which include everything the DISTINCT looks
+	// at; filters evaluated locally only read returned columns as well, so they drop whole groups of equal rows. Row
+	// ids are not returned by Snowflake, and semi-structured values, values converted locally and strings collated
+	// in DuckDB or in Snowflake (see CanPushFilter) are equal under different rules there.
+	for (auto &column_index : get->GetColumnIds()) {
+		if (column_index.IsRowIdColumn()) {
+			return false;
+		}
+		auto column_id = column_index.GetPrimaryIndex();
+		if (!bind_data->CanPushFilter(column_id) || SnowflakeOptimizer::IsCollated(bind_data->all_types[column_id])) {
+			return false;
+		}
+	}
+	bind_data->query.distinct = true;
+	DPRINT("SnowflakeDistinctPushdown: pushed DISTINCT\n");
+	return true;
+}
+
+// Largest rank a filter conjunct keeps, if it keeps exactly the first ranks, e.g. rn = 1 or rn <= 3
+static optional_idx GetRankLimit(const Expression &expr, const ColumnBinding &rank_binding) {
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_COMPARISON) {
+		return optional_idx();
+	}
+	auto &comparison = expr.Cast<BoundComparisonExpression>();
+	auto comparison_type = comparison.GetExpressionType();
+	reference<const Expression> rank = *comparison.left;
+	reference<const Expression> bound = *comparison.right;
+	if (bound.get().GetExpressionClass() == ExpressionClass::BOUND_COLUMN_REF) {
+		std::swap(rank, bound);
+		comparison_type = FlipComparisonExpression(comparison_type);
+	}
+	if (rank.get().GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF ||
+	    !(rank.get().Cast<BoundColumnRefExpression>().binding == rank_binding) ||
+	    bound.get().GetExpressionClass() != ExpressionClass::BOUND_CONSTANT) {
+		return optional_idx();
+	}
+	auto &value = bound.get().Cast<BoundConstantExpression>().value;
+	if (value.IsNull() || !value.type().IsIntegral()) {
+		return optional_idx();
+	}
+	auto limit = value.GetValue<int64_t>();
+	// Other comparisons keep rows whose rank changes once the rows before them are gone
+	switch (comparison_type) {
+	case ExpressionType::COMPARE_EQUAL:
+		return limit == 1 ? optional_idx(1) : optional_idx();
+	case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+		return limit >= 1 ? optional_idx(NumericCast<idx_t>(limit)) : optional_idx();
+	case ExpressionType::COMPARE_LESSTHAN:
+		return limit >= 2 ? optional_idx(NumericCast<idx_t>(limit - 1)) : optional_idx();
+	default:
+		return optional_idx();
+	}
+}
+
+bool SnowflakeDistinctPushdown::TryPushdownQualify(LogicalFilter &filter) {
+	if (filter.children[0]->type != LogicalOperatorType::LOGICAL_WINDOW) {
+		return false;
+	}
+	auto &window = filter.children[0]->Cast<LogicalWindow>();
+	// Further window expressions would be computed over the surviving rows only
+	if (window.expressions.size() != 1) {
+		return false;
+	}
+	auto &window_expr = window.expressions[0]->Cast<BoundWindowExpression>();
+	string function_name;
+	switch (window_expr.GetExpressionType()) {
+	case ExpressionType::WINDOW_ROW_NUMBER:
+		function_name = "ROW_NUMBER()";
+		break;
+	case ExpressionType::WINDOW_RANK:
+		function_name = "RANK()";
+		break;
+	case ExpressionType::WINDOW_RANK_DENSE:
+		function_name = "DENSE_RANK()";
+		break;
+	default:
+		return false;
+	}
+	if (window_expr.filter_expr || !window_expr.arg_orders.empty() || window_expr.distinct) {
+		return false;
+	}
+	optional_idx limit;
+	ColumnBinding rank_binding(window.window_index, 0);
+	for (auto &expr : filter.expressions) {
+		auto conjunct_limit = GetRankLimit(*expr, rank_binding);
+		if (conjunct_limit.IsValid() && (!limit.IsValid() || conjunct_limit.GetIndex() < limit.GetIndex())) {
+			limit = conjunct_limit;
+		}
+	}
+	if (!limit.IsValid()) {
+		return false;
+	}
+
+	optional_ptr<LogicalGet> get;
+	auto bind_data = GetScan(*window.children[0], get);
+	// The ranks are computed over the filtered rows, so Snowflake has to evaluate all filters
+	if (!bind_data || !SnowflakeOptimizer::EvaluatesAllFilters(*get, *bind_data)) {
+		return false;
+	}
+	auto &query = bind_data->query;
+
+	vector<reference<LogicalProjection>> projections;
+	reference<LogicalOperator> current = *window.children[0];
+	while (current.get().type == LogicalOperatorType::LOGICAL_PROJECTION) {
+		projections.push_back(current.get().Cast<LogicalProjection>());
+		current = *current.get().children[0];
+	}
+	optional_ptr<SnowflakeExpressionTranslator> translator;
+	SnowflakeExpressionTranslator expression_translator([&](const ColumnBinding &binding, string &result) {
+		if (binding.table_index == get->table_index) {
+			auto position =
+			    get->projection_ids.empty() ? binding.column_index : get->projection_ids[binding.column_index];
+			auto &column_index = get->GetColumnIds()[position];
+			if (column_index.IsRowIdColumn() || !bind_data->CanPushFilter(column_index.GetPrimaryIndex())) {
+				return false;
+			}
+			result = query.GetColumnExpression(column_index.GetPrimaryIndex());
+			return true;
+		}
+		for (auto &projection : projections) {
+			if (projection.get().table_index == binding.table_index) {
+				return translator->Translate(*projection.get().expressions[binding.column_index], result);
+			}
+		}
+		return false;
+	});
+	translator = &expression_translator;
+
+	vector<string> partitions;
+	for (auto &partition : window_expr.partitions) {
+		// Semi-structured values and collated strings are equal under different rules in Snowflake; columns Snowflake
+		// collates are rejected by the translator
+		auto &partition_type = partition->return_type;
+		if (partition_type.IsJSONType() || partition_type.IsNested() ||
+		    SnowflakeOptimizer::IsCollated(partition_type)) {
+			return false;
+		}
+		string expression;
+		if (!expression_translator.Translate(*partition, expression)) {
+			return false;
+		}
+		partitions.push_back(std::move(expression));
+	}
+	vector<string> orders;
+	for (auto &order : window_expr.orders) {
+		// Only keys DuckDB and Snowflake sort alike decide which rows come first
+		if (!SnowflakeTableStatistics::HasMinMax(order.expression->return_type)) {
+			return false;
+		}
+		string expression;
+		if (!expression_translator.Translate(*order.expression, expression)) {
+			return false;
+		}
+		if (order.type == OrderType::ASCENDING) {
+			expression += " ASC";
+		} else if (order.type == OrderType::DESCENDING) {
+			expression += " DESC";
+		} else {
+			return false;
+		}
+		if (order.null_order == OrderByNullType::NULLS_FIRST) {
+			expression += " NULLS FIRST";
+		} else if (order.null_order == OrderByNullType::NULLS_LAST) {
+			expression += " NULLS LAST";
+		} else {
+			return false;
+		}
+		orders.push_back(std::move(expression));
+	}
+
+	string over;
+	if (!partitions.empty()) {
+		over += "PARTITION BY " + StringUtil::Join(partitions, ", ");
+	}
+	if (!orders.empty()) {
+		over += (over.empty() ? "" : " ") + string("ORDER BY ") + StringUtil::Join(orders, ", ");
+	}
+	// The window and filter stay local: ranks recomputed over the surviving rows keep them all
+	query.qualify = function_name + " OVER (" + over + ") <= " + to_string(limit.GetIndex());
+	DPRINT("SnowflakeDistinctPushdown: pushed QUALIFY %s\n", query.qualify.c_str());
+	return true;
+}
+
+void SnowflakeDistinctPushdown::Optimize(unique_ptr<LogicalOperator> &op) {
+	if (op->type == LogicalOperatorType::LOGICAL_DISTINCT) {
+		TryPushdownDistinct(op->Cast<LogicalDistinct>());
+	} else if (op->type == LogicalOperatorType::LOGICAL_FILTER) {
+		TryPushdownQualify(op->Cast<LogicalFilter>());
+	}
+	for (auto &child : op->children) {
+		Optimize(child);
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
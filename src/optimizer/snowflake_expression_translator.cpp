@@ -0,0 +1,578 @@
+#include "optimizer/snowflake_expression_translator.hpp"
+#include "snowflake_query_builder.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/function/cast_rules.hpp"
+#include "duckdb/planner/expression/bound_between_expression.hpp"
+#include "duckdb/planner/expression/bound_cast_expression.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_comparison_expression.hpp"
+#include "duckdb/planner/expression/bound_conjunction_expression.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/planner/expression/bound_operator_expression.hpp"
+#include "duckdb/planner/filter/conjunction_filter.hpp"
+#include "duckdb/planner/filter/constant_filter.hpp"
+#include "duckdb/planner/filter/in_filter.hpp"
+#include "duckdb/planner/table_filter.hpp"
+
+#include <cmath>
+
+namespace duckdb {
+namespace snowflake {
+
+//! Argument types a mapping accepts, to tell e.g. string functions from list functions of the same name
+enum class SnowflakeArgumentType : uint8_t { ANY, VARCHAR, NUMERIC, LOCAL_DATE_TIME };
+
+struct SnowflakeFunctionMapping {
+	const char *duckdb_name;
+	idx_t argument_count;
+	//! Snowflake SQL with {0}, {1}, ... standing for the translated arguments
+	const char *snowflake_template;
+	//! Type the first argument must have for the mapping to apply; NUMERIC applies to every argument and the result
+	SnowflakeArgumentType argument_type = SnowflakeArgumentType::ANY;
+};
+
+// Functions that behave the same in both systems. date_trunc and date_part depend on their part argument and are
+// translated by TranslateDatePartFunction instead.
+static const SnowflakeFunctionMapping SNOWFLAKE_FUNCTION_MAPPINGS[] = {
+    // Vector similarity
+    {"array_cosine_similarity", 2, "VECTOR_COSINE_SIMILARITY({0}, {1})"},
+    {"array_cosine_distance", 2, "(1 - VECTOR_COSINE_SIMILARITY({0}, {1}))"},
+    {"array_inner_product", 2, "VECTOR_INNER_PRODUCT({0}, {1})"},
+    {"array_negative_inner_product", 2, "(-VECTOR_INNER_PRODUCT({0}, {1}))"},
+    {"array_distance", 2, "VECTOR_L2_DISTANCE({0}, {1})"},
+    // Strings
+    {"lower", 1, "LOWER({0})", SnowflakeArgumentType::VARCHAR},
+    {"upper", 1, "UPPER({0})", SnowflakeArgumentType::VARCHAR},
+    {"length", 1, "LENGTH({0})", SnowflakeArgumentType::VARCHAR},
+    {"trim", 1, "TRIM({0})", SnowflakeArgumentType::VARCHAR},
+    {"ltrim", 1, "LTRIM({0})", SnowflakeArgumentType::VARCHAR},
+    {"rtrim", 1, "RTRIM({0})", SnowflakeArgumentType::VARCHAR},
+    {"substring", 3, "SUBSTR({0}, {1}, {2})", SnowflakeArgumentType::VARCHAR},
+    {"||", 2, "({0} || {1})", SnowflakeArgumentType::VARCHAR},
+    {"prefix", 2, "STARTSWITH({0}, {1})", SnowflakeArgumentType::VARCHAR},
+    {"starts_with", 2, "STARTSWITH({0}, {1})", SnowflakeArgumentType::VARCHAR},
+    {"^@", 2, "STARTSWITH({0}, {1})", SnowflakeArgumentType::VARCHAR},
+    {"suffix", 2, "ENDSWITH({0}, {1})", SnowflakeArgumentType::VARCHAR},
+    {"ends_with", 2, "ENDSWITH({0}, {1})", SnowflakeArgumentType::VARCHAR},
+    {"contains", 2, "CONTAINS({0}, {1})", SnowflakeArgumentType::VARCHAR},
+    // LIKE has no default escape character in either system
+    {"~~", 2, "({0} LIKE {1})", SnowflakeArgumentType::VARCHAR},
+    {"!~~", 2, "({0} NOT LIKE {1})", SnowflakeArgumentType::VARCHAR},
+    {"~~*", 2, "({0} ILIKE {1})", SnowflakeArgumentType::VARCHAR},
+    {"!~~*", 2, "({0} NOT ILIKE {1})", SnowflakeArgumentType::VARCHAR},
+    // regexp_matches finds a match anywhere, REGEXP_LIKE would have to match the whole string
+    {"regexp_matches", 2, "(REGEXP_INSTR({0}, {1}) > 0)", SnowflakeArgumentType::VARCHAR},
+    // Dates and times, without time zones: Snowflake extracts parts in the session time zone
+    {"year", 1, "YEAR({0})", SnowflakeArgumentType::LOCAL_DATE_TIME},
+    {"month", 1, "MONTH({0})", SnowflakeArgumentType::LOCAL_DATE_TIME},
+    {"day", 1, "DAY({0})", SnowflakeArgumentType::LOCAL_DATE_TIME},
+    {"hour", 1, "HOUR({0})", SnowflakeArgumentType::LOCAL_DATE_TIME},
+    {"minute", 1, "MINUTE({0})", SnowflakeArgumentType::LOCAL_DATE_TIME},
+    // Arithmetic on numbers only, in every argument and the result: date and interval arithmetic differs, e.g.
+    // integer + date. DuckDB's / divides integers as doubles, so it stays local.
+    {"+", 2, "({0} + {1})", SnowflakeArgumentType::NUMERIC},
+    {"-", 2, "({0} - {1})", SnowflakeArgumentType::NUMERIC},
+    {"-", 1, "(-{0})", SnowflakeArgumentType::NUMERIC},
+    {"*", 2, "({0} * {1})", SnowflakeArgumentType::NUMERIC},
+    {"abs", 1, "ABS({0})", SnowflakeArgumentType::NUMERIC},
+};
+
+// Parts date_trunc and date_part accept that mean the same in Snowflake; weeks and days of the week depend on
+// Snowflake's WEEK_START parameter
+static const char *SNOWFLAKE_DATE_PARTS[] = {"year", "quarter", "month", "day", "hour", "minute", "second"};
+
+static bool GetDatePart(const Expression &expr, string &result) {
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_CONSTANT) {
+		return false;
+	}
+	auto &value = expr.Cast<BoundConstantExpression>().value;
+	if (value.IsNull() || value.type().id() != LogicalTypeId::VARCHAR) {
+		return false;
+	}
+	auto part = StringUtil::Lower(StringValue::Get(value));
+	for (auto &date_part : SNOWFLAKE_DATE_PARTS) {
+		if (part == date_part) {
+			result = StringUtil::Upper(part);
+			return true;
+		}
+	}
+	return false;
+}
+
+// date_trunc and date_part only agree on dates and time zone-less timestamps
+static bool IsLocalDateTime(const LogicalType &type) {
+	return type.id() == LogicalTypeId::DATE || type.id() == LogicalTypeId::TIMESTAMP;
+}
+
+static bool MatchesArgumentType(SnowflakeArgumentType argument_type, const LogicalType &type) {
+	switch (argument_type) {
+	case SnowflakeArgumentType::VARCHAR:
+		return type.id() == LogicalTypeId::VARCHAR;
+	case SnowflakeArgumentType::NUMERIC:
+		return type.IsNumeric();
+	case SnowflakeArgumentType::LOCAL_DATE_TIME:
+		return IsLocalDateTime(type);
+	default:
+		return true;
+	}
+}
+
+// Whether expr is a constant integer of at least minimum
+static bool IsConstantAtLeast(const Expression &expr, int64_t minimum) {
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_CONSTANT || !expr.return_type.IsIntegral()) {
+		return false;
+	}
+	Value value;
+	auto &constant = expr.Cast<BoundConstantExpression>().value;
+	return !constant.IsNull() && constant.DefaultTryCastAs(LogicalType::BIGINT, value) &&
+	       BigIntValue::Get(value) >= minimum;
+}
+
+static string FormatTemplate(const char *snowflake_template, const vector<string> &arguments) {
+	string result;
+	for (auto ptr = snowflake_template; *ptr; ptr++) {
+		if (*ptr == '{' && StringUtil::CharacterIsDigit(ptr[1]) && ptr[2] == '}') {
+			result += arguments[idx_t(ptr[1] - '0')];
+			ptr += 2;
+		} else {
+			result += *ptr;
+		}
+	}
+	return result;
+}
+
+SnowflakeExpressionTranslator::SnowflakeExpressionTranslator(column_resolver_t resolve_column_p)
+    : resolve_column(std::move(resolve_column_p)) {
+}
+
+bool SnowflakeExpressionTranslator::TranslateConstant(const Value &value, string &result) {
+	if (value.IsNull()) {
+		result = "NULL";
+		return true;
+	}
+	auto &type = value.type();
+	switch (type.id()) {
+	case LogicalTypeId::BOOLEAN:
+		result = BooleanValue::Get(value) ? "TRUE" : "FALSE";
+		return true;
+	case LogicalTypeId::TINYINT:
+	case LogicalTypeId::SMALLINT:
+	case LogicalTypeId::INTEGER:
+	case LogicalTypeId::BIGINT:
+	case LogicalTypeId::UTINYINT:
+	case LogicalTypeId::USMALLINT:
+	case LogicalTypeId::UINTEGER:
+	case LogicalTypeId::DECIMAL:
+		result = value.ToString();
+		return true;
+	case LogicalTypeId::FLOAT:
+	case LogicalTypeId::DOUBLE: {
+		auto number = value.GetValue<double>();
+		if (!std::isfinite(number)) {
+			return false;
+		}
+		result = value.ToString();
+		return true;
+	}
+	case LogicalTypeId::VARCHAR:
+		result = SnowflakeQueryBuilder::QuoteString(StringValue::Get(value));
+		return true;
+	case LogicalTypeId::DATE:
+		result = SnowflakeQueryBuilder::QuoteString(value.ToString()) + "::DATE";
+		return true;
+	case LogicalTypeId::TIME:
+		result = SnowflakeQueryBuilder::QuoteString(value.ToString()) + "::TIME";
+		return true;
+	case LogicalTypeId::TIMESTAMP:
+		result = SnowflakeQueryBuilder::QuoteString(value.ToString()) + "::TIMESTAMP_NTZ";
+		return true;
+	case LogicalTypeId::TIMESTAMP_TZ:
+		result = SnowflakeQueryBuilder::QuoteString(value.ToString()) + "::TIMESTAMP_TZ";
+		return true;
+	case LogicalTypeId::ARRAY: {
+		// Fixed-size arrays of numbers are Snowflake vectors
+		auto &child_type = ArrayType::GetChildType(type);
+		string element_type;
+		if (child_type.id() == LogicalTypeId::FLOAT) {
+			element_type = "FLOAT";
+		} else if (child_type.id() == LogicalTypeId::INTEGER) {
+			element_type = "INT";
+		} else {
+			return false;
+		}
+		vector<string> elements;
+		for (auto &child : ArrayValue::GetChildren(value)) {
+			string element;
+			if (child.IsNull() || !TranslateConstant(child, element)) {
+				return false;
+			}
+			elements.push_back(std::move(element));
+		}
+		result = "[" + StringUtil::Join(elements, ", ") + "]::VECTOR(" + element_type + ", " +
+		         to_string(ArrayType::GetSize(type)) + ")";
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+static const char *GetComparisonOperator(ExpressionType type) {
+	switch (type) {
+	case ExpressionType::COMPARE_EQUAL:
+		return "=";
+	case ExpressionType::COMPARE_NOTEQUAL:
+		return "<>";
+	case ExpressionType::COMPARE_LESSTHAN:
+		return "<";
+	case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+		return "<=";
+	case ExpressionType::COMPARE_GREATERTHAN:
+		return ">";
+	case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+		return ">=";
+	default:
+		return nullptr;
+	}
+}
+
+bool SnowflakeExpressionTranslator::IsOptionalFilter(const TableFilter &filter) {
+	return filter.filter_type == TableFilterType::OPTIONAL_FILTER ||
+	       filter.filter_type == TableFilterType::DYNAMIC_FILTER;
+}
+
+bool SnowflakeExpressionTranslator::TranslateFilter(const TableFilter &filter, const string &column, string &result) {
+	switch (filter.filter_type) {
+	case TableFilterType::CONSTANT_COMPARISON: {
+		auto &constant_filter = filter.Cast<ConstantFilter>();
+		auto comparison = GetComparisonOperator(constant_filter.comparison_type);
+		string constant;
+		if (!comparison || !TranslateConstant(constant_filter.constant, constant)) {
+			return false;
+		}
+		result = column + " " + comparison + " " + constant;
+		return true;
+	}
+	case TableFilterType::IS_NULL:
+		result = column + " IS NULL";
+		return true;
+	case TableFilterType::IS_NOT_NULL:
+		result = column + " IS NOT NULL";
+		return true;
+	case TableFilterType::IN_FILTER: {
+		vector<string> values;
+		for (auto &value : filter.Cast<InFilter>().values) {
+			string constant;
+			if (!TranslateConstant(value, constant)) {
+				return false;
+			}
+			values.push_back(std::move(constant));
+		}
+		result = column + " IN (" + StringUtil::Join(values, ", ") + ")";
+		return true;
+	}
+	case TableFilterType::CONJUNCTION_AND:
+	case TableFilterType::CONJUNCTION_OR: {
+		auto &conjunction = filter.Cast<ConjunctionFilter>();
+		vector<string> children;
+		for (auto &child_filter : conjunction.child_filters) {
+			string child;
+			if (!TranslateFilter(*child_filter, column, child)) {
+				return false;
+			}
+			children.push_back(std::move(child));
+		}
+		auto separator = filter.filter_type == TableFilterType::CONJUNCTION_AND ? " AND " : " OR ";
+		result = "(" + StringUtil::Join(children, separator) + ")";
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+bool SnowflakeExpressionTranslator::TranslateDatePartFunction(const BoundFunctionExpression &function,
+                                                              string &result) {
+	auto &name = function.function.name;
+	if ((name != "date_trunc" && name != "date_part") || function.children.size() != 2 ||
+	    !IsLocalDateTime(function.children[1]->return_type)) {
+		return false;
+	}
+	string part;
+	string argument;
+	if (!GetDatePart(*function.children[0], part) || !Translate(*function.children[1], argument)) {
+		return false;
+	}
+	result = (name == "date_trunc" ? "DATE_TRUNC(" : "DATE_PART(") + part + ", " + argument + ")";
+	return true;
+}
+
+bool SnowflakeExpressionTranslator::TranslateFunction(const BoundFunctionExpression &function, string &result) {
+	if (TranslateDatePartFunction(function, result)) {
+		return true;
+	}
+	for (auto &mapping : SNOWFLAKE_FUNCTION_MAPPINGS) {
+		if (function.function.name != mapping.duckdb_name || function.children.size() != mapping.argument_count) {
+			continue;
+		}
+		if (!MatchesArgumentType(mapping.argument_type, function.children[0]->return_type)) {
+			continue;
+		}
+		if (mapping.argument_type == SnowflakeArgumentType::NUMERIC) {
+			if (!function.return_type.IsNumeric()) {
+				return false;
+			}
+			for (auto &child : function.children) {
+				if (!child->return_type.IsNumeric()) {
+					return false;
+				}
+			}
+		}
+		// DuckDB counts a start below 1 from the end of the string and takes a negative length to the left of it,
+		// Snowflake does neither
+		if (function.function.name == "substring" &&
+		    (!IsConstantAtLeast(*function.children[1], 1) || !IsConstantAtLeast(*function.children[2], 0))) {
+			return false;
+		}
+		vector<string> arguments;
+		for (auto &child : function.children) {
+			string argument;
+			if (!Translate(*child, argument)) {
+				return false;
+			}
+			arguments.push_back(std::move(argument));
+		}
+		result = FormatTemplate(mapping.snowflake_template, arguments);
+		return true;
+	}
+	return false;
+}
+
+bool SnowflakeExpressionTranslator::TranslateChildren(const vector<unique_ptr<Expression>> &children,
+                                                      vector<string> &result) {
+	for (auto &child : children) {
+		string translated;
+		if (!Translate(*child, translated)) {
+			return false;
+		}
+		result.push_back(std::move(translated));
+	}
+	return true;
+}
+
+// Rewrites date_trunc(part, col) <op> constant into a range on col, which Snowflake can prune micro-partitions
+// with. T is the constant truncated to the part and N the start of the following part: date_trunc(col) >= C holds
+// from C on if C is a part boundary and from N on otherwise, date_trunc(col) > C holds from N on, and so on.
+bool SnowflakeExpressionTranslator::TranslateTruncComparison(const BoundComparisonExpression &comparison,
+                                                             string &result) {
+	auto comparison_type = comparison.GetExpressionType();
+	reference<const Expression> function_expr = *comparison.left;
+	reference<const Expression> constant_expr = *comparison.right;
+	if (constant_expr.get().GetExpressionClass() != ExpressionClass::BOUND_CONSTANT) {
+		std::swap(function_expr, constant_expr);
+		comparison_type = FlipComparisonExpression(comparison_type);
+	}
+	if (function_expr.get().GetExpressionClass() != ExpressionClass::BOUND_FUNCTION ||
+	    constant_expr.get().GetExpressionClass() != ExpressionClass::BOUND_CONSTANT) {
+		return false;
+	}
+	auto &function = function_expr.get().Cast<BoundFunctionExpression>();
+	if (function.function.name != "date_trunc" || function.children.size() != 2 ||
+	    function.children[1]->GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF ||
+	    !IsLocalDateTime(function.children[1]->return_type)) {
+		return false;
+	}
+	string part;
+	string column;
+	string constant;
+	if (!GetDatePart(*function.children[0], part) || !Translate(*function.children[1], column) ||
+	    !Translate(constant_expr.get(), constant) || constant == "NULL") {
+		return false;
+	}
+	auto truncated = "DATE_TRUNC(" + part + ", " + constant + ")";
+	auto next = "DATEADD(" + part + ", 1, " + truncated + ")";
+	auto first_from = "IFF(" + truncated + " = " + constant + ", " + truncated + ", " + next + ")";
+	switch (comparison_type) {
+	case ExpressionType::COMPARE_EQUAL:
+		result = "(" + truncated + " = " + constant + " AND " + column + " >= " + truncated + " AND " + column +
+		         " < " + next + ")";
+		return true;
+	case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+		result = column + " >= " + first_from;
+		return true;
+	case ExpressionType::COMPARE_GREATERTHAN:
+		result = column + " >= " + next;
+		return true;
+	case ExpressionType::COMPARE_LESSTHAN:
+		result = column + " < " + first_from;
+		return true;
+	case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+		result = column + " < " + next;
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool SnowflakeExpressionTranslator::Translate(const Expression &expr, string &result) {
+	switch (expr.GetExpressionClass()) {
+	case ExpressionClass::BOUND_COLUMN_REF: {
+		auto &colref = expr.Cast<BoundColumnRefExpression>();
+		return colref.depth == 0 && resolve_column(colref.binding, result);
+	}
+	case ExpressionClass::BOUND_CONSTANT:
+		return TranslateConstant(expr.Cast<BoundConstantExpression>().value, result);
+	case ExpressionClass::BOUND_FUNCTION:
+		return TranslateFunction(expr.Cast<BoundFunctionExpression>(), result);
+	case ExpressionClass::BOUND_COMPARISON: {
+		auto &comparison = expr.Cast<BoundComparisonExpression>();
+		if (TranslateTruncComparison(comparison, result)) {
+			return true;
+		}
+		string left;
+		string right;
+		if (expr.GetExpressionType() == ExpressionType::COMPARE_DISTINCT_FROM ||
+		    expr.GetExpressionType() == ExpressionType::COMPARE_NOT_DISTINCT_FROM) {
+			if (!Translate(*comparison.left, left) || !Translate(*comparison.right, right)) {
+				return false;
+			}
+			auto distinct = expr.GetExpressionType() == ExpressionType::COMPARE_DISTINCT_FROM;
+			result = "(" + left + (distinct ? " IS DISTINCT FROM " : " IS NOT DISTINCT FROM ") + right + ")";
+			return true;
+		}
+		auto comparison_operator = GetComparisonOperator(expr.GetExpressionType());
+		if (!comparison_operator || !Translate(*comparison.left, left) || !Translate(*comparison.right, right)) {
+			return false;
+		}
+		result = "(" + left + " " + comparison_operator + " " + right + ")";
+		return true;
+	}
+	case ExpressionClass::BOUND_CONJUNCTION: {
+		vector<string> children;
+		if (!TranslateChildren(expr.Cast<BoundConjunctionExpression>().children, children)) {
+			return false;
+		}
+		auto separator = expr.GetExpressionType() == ExpressionType::CONJUNCTION_AND ? " AND " : " OR ";
+		result = "(" + StringUtil::Join(children, separator) + ")";
+		return true;
+	}
+	case ExpressionClass::BOUND_OPERATOR: {
+		vector<string> children;
+		if (!TranslateChildren(expr.Cast<BoundOperatorExpression>().children, children)) {
+			return false;
+		}
+		switch (expr.GetExpressionType()) {
+		case ExpressionType::OPERATOR_NOT:
+			result = "(NOT " + children[0] + ")";
+			return true;
+		case ExpressionType::OPERATOR_IS_NULL:
+			result = "(" + children[0] + " IS NULL)";
+			return true;
+		case ExpressionType::OPERATOR_IS_NOT_NULL:
+			result = "(" + children[0] + " IS NOT NULL)";
+			return true;
+		case ExpressionType::COMPARE_IN:
+		case ExpressionType::COMPARE_NOT_IN: {
+			auto values = vector<string>(children.begin() + 1, children.end());
+			auto in = expr.GetExpressionType() == ExpressionType::COMPARE_IN ? " IN (" : " NOT IN (";
+			result = "(" + children[0] + in + StringUtil::Join(values, ", ") + "))";
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+	case ExpressionClass::BOUND_BETWEEN: {
+		auto &between = expr.Cast<BoundBetweenExpression>();
+		string input;
+		string lower;
+		string upper;
+		if (!Translate(*between.input, input) || !Translate(*between.lower, lower) ||
+		    !Translate(*between.upper, upper)) {
+			return false;
+		}
+		result = "(" + input + (between.lower_inclusive ? " >= " : " > ") + lower + " AND " + input +
+		         (between.upper_inclusive ? " <= " : " < ") + upper + ")";
+		return true;
+	}
+	case ExpressionClass::BOUND_CAST: {
+		// Snowflake has a single NUMBER type, so widening numeric casts need no counterpart
+		auto &cast = expr.Cast<BoundCastExpression>();
+		auto &source_type = cast.child->return_type;
+		// DuckDB only casts implicitly where no value changes
+		if (cast.try_cast || !(source_type.IsIntegral() || source_type.id() == LogicalTypeId::DECIMAL) ||
+		    !(cast.return_type.IsIntegral() || cast.return_type.id() == LogicalTypeId::DECIMAL) ||
+		    CastRules::ImplicitCast(source_type, cast.return_type) < 0) {
+			return false;
+		}
+		return Translate(*cast.child, result);
+	}
+	default:
+		return false;
+	}
+}
+
+bool SnowflakeExpressionTranslator::IsTableFilterCandidate(const Expression &expr) {
+	optional_idx column_table;
+	optional_idx column_index;
+	// Whether expr is a reference to the one column the whole filter is on
+	auto is_column = [&](const Expression &child) {
+		if (child.GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF) {
+			return false;
+		}
+		auto &binding = child.Cast<BoundColumnRefExpression>().binding;
+		if (!column_table.IsValid()) {
+			column_table = binding.table_index;
+			column_index = binding.column_index;
+		}
+		return binding.table_index == column_table.GetIndex() && binding.column_index == column_index.GetIndex();
+	};
+	auto is_constant = [](const Expression &child) {
+		return child.GetExpressionClass() == ExpressionClass::BOUND_CONSTANT;
+	};
+	std::function<bool(const Expression &)> is_candidate = [&](const Expression &child) {
+		switch (child.GetExpressionClass()) {
+		case ExpressionClass::BOUND_COMPARISON: {
+			auto &comparison = child.Cast<BoundComparisonExpression>();
+			return GetComparisonOperator(child.GetExpressionType()) &&
+			       ((is_column(*comparison.left) && is_constant(*comparison.right)) ||
+			        (is_constant(*comparison.left) && is_column(*comparison.right)));
+		}
+		case ExpressionClass::BOUND_OPERATOR: {
+			auto &op = child.Cast<BoundOperatorExpression>();
+			if (child.GetExpressionType() == ExpressionType::OPERATOR_IS_NULL ||
+			    child.GetExpressionType() == ExpressionType::OPERATOR_IS_NOT_NULL) {
+				return is_column(*op.children[0]);
+			}
+			if (child.GetExpressionType() != ExpressionType::COMPARE_IN || !is_column(*op.children[0])) {
+				return false;
+			}
+			for (idx_t i = 1; i < op.children.size(); i++) {
+				if (!is_constant(*op.children[i])) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case ExpressionClass::BOUND_BETWEEN: {
+			auto &between = child.Cast<BoundBetweenExpression>();
+			return is_column(*between.input) && is_constant(*between.lower) && is_constant(*between.upper);
+		}
+		case ExpressionClass::BOUND_CONJUNCTION: {
+			for (auto &conjunction_child : child.Cast<BoundConjunctionExpression>().children) {
+				if (!is_candidate(*conjunction_child)) {
+					return false;
+				}
+			}
+			return true;
+		}
+		default:
+			return false;
+		}
+	};
+	return is_candidate(expr);
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,299 @@
+#include "optimizer/snowflake_late_materialization.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_semi_join.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/planner/binder.hpp"
+#include "duckdb/planner/expression_iterator.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/operator/logical_comparison_join.hpp"
+#include "duckdb/planner/operator/logical_filter.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/planner/operator/logical_projection.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakeLateMaterialization::SnowflakeLateMaterialization(ClientContext &context, Binder &binder)
+    : context(context), binder(binder) {
+	Value setting;
+	if (context.TryGetCurrentSetting("snowflake_semi_join_max_keys", setting) && !setting.IsNull()) {
+		max_keys = UBigIntValue::Get(setting);
+	}
+}
+
+// Rough size of a value of type in a Snowflake result, to tell the wide columns from the narrow ones
+static idx_t GetValueWidth(const LogicalType &type) {
+	auto physical_type = type.InternalType();
+	if (physical_type == PhysicalType::VARCHAR || type.IsNested()) {
+		return 32;
+	}
+	return GetTypeIdSize(physical_type);
+}
+
+// Points the column references of the scan's table index in expr to the split scan's columns
+static void RebindColumns(Expression &expr, idx_t table_index, const std::function<ColumnBinding(idx_t)> &rebind) {
+	if (expr.GetExpressionClass() == ExpressionClass::BOUND_COLUMN_REF) {
+		auto &colref = expr.Cast<BoundColumnRefExpression>();
+		if (colref.binding.table_index == table_index) {
+			colref.binding = rebind(colref.binding.column_index);
+		}
+		return;
+	}
+	ExpressionIterator::EnumerateChildren(expr,
+	                                      [&](Expression &child) { RebindColumns(child, table_index, rebind); });
+}
+
+bool SnowflakeLateMaterialization::TryRewrite(unique_ptr<LogicalOperator> &op) {
+	if (op->type != LogicalOperatorType::LOGICAL_FILTER) {
+		return false;
+	}
+	auto &filter = op->Cast<LogicalFilter>();
+	if (!filter.projection_map.empty()) {
+		return false;
+	}
+	auto bind_data = SnowflakeOptimizer::GetScanBindData(*filter.children[0]);
+	if (!bind_data || bind_data->primary_key.empty()) {
+		return false;
+	}
+	// Deduplicating the key and filtered columns alone would drop rows that only differ in the others
+	auto &query = bind_data->query;
+	if (query.distinct || bind_data->semi_join_keys) {
+		return false;
+	}
+	auto &get = filter.children[0]->Cast<LogicalGet>();
+	auto column_ids = get.GetColumnIds();
+
+	vector<column_t> key_ids;
+	for (auto &name : bind_data->primary_key) {
+		auto entry = std::find(query.column_names.begin(), query.column_names.end(), name);
+		if (entry == query.column_names.end()) {
+			return false;
+		}
+		key_ids.push_back(NumericCast<column_t>(entry - query.column_names.begin()));
+	}
+	// The second scan is restricted to the values of the first key column Snowflake compares like DuckDB; the join
+	// on the whole key then drops the rows of other keys sharing them
+	optional_idx lookup_key;
+	for (idx_t i = 0; i < key_ids.size(); i++) {
+		auto &type = get.returned_types[key_ids[i]];
+		if (SnowflakeSemiJoinKeys::IsSupportedType(type) && bind_data->CanPushFilter(key_ids[i])) {
+			lookup_key = i;
+			break;
+		}
+	}
+	if (!lookup_key.IsValid()) {
+		return false;
+	}
+
+	// The first scan fetches the key, the columns filtered by the scan itself and those the filter reads; columns
+	// fetched for table filters only are not returned by the scan
+	vector<idx_t> outputs;
+	if (get.projection_ids.empty()) {
+		for (idx_t position = 0; position < column_ids.size(); position++) {
+			outputs.push_back(position);
+		}
+	} else {
+		outputs = get.projection_ids;
+	}
+	vector<bool> narrow(column_ids.size(), true);
+	for (auto position : outputs) {
+		narrow[position] = false;
+	}
+	for (auto &entry : get.table_filters.filters) {
+		narrow[entry.first] = true;
+	}
+	for (idx_t position = 0; position < column_ids.size(); position++) {
+		if (column_ids[position].IsRowIdColumn()) {
+			return false;
+		}
+		auto column_id = column_ids[position].GetPrimaryIndex();
+		if (std::find(key_ids.begin(), key_ids.end(), column_id) != key_ids.end()) {
+			narrow[position] = true;
+		}
+	}
+	for (auto &expr : filter.expressions) {
+		ExpressionIterator::VisitExpression<BoundColumnRefExpression>(
+		    *expr, [&](const BoundColumnRefExpression &colref) {
+			    if (colref.binding.table_index == get.table_index) {
+				    narrow[outputs[colref.binding.column_index]] = true;
+			    }
+		    });
+	}
+	idx_t narrow_width = 0;
+	idx_t wide_width = 0;
+	vector<idx_t> wide_positions;
+	for (idx_t position = 0; position < column_ids.size(); position++) {
+		auto width = GetValueWidth(get.returned_types[column_ids[position].GetPrimaryIndex()]);
+		if (narrow[position]) {
+			narrow_width += width;
+		} else {
+			wide_width += width;
+			wide_positions.push_back(position);
+		}
+	}
+	// Surviving rows are fetched in two parts, which only pays off if most of each row is deferred
+	if (wide_positions.empty() || wide_width <= narrow_width) {
+		return false;
+	}
+	auto cardinality = filter.EstimateCardinality(context);
+	if (cardinality > max_keys) {
+		return false;
+	}
+
+	// The second scan reads the table like a scan of the attached table with the same schema, restricted to the
+	// surviving keys only, as of the query of the first scan
+	auto &connection = bind_data->factory->connection;
+	auto lookup_data = make_uniq<SnowflakeScanBindData>(
+	    make_uniq<SnowflakeArrowStreamFactory>(connection, "SELECT * FROM " + query.source));
+	lookup_data->arrow_table = bind_data->arrow_table;
+	lookup_data->all_types = bind_data->all_types;
+	lookup_data->query.source = query.source;
+	lookup_data->query.column_names = query.column_names;
+	lookup_data->query.pushed_columns = query.pushed_columns;
+	lookup_data->semantic_cache_source = bind_data->semantic_cache_source;
+	lookup_data->table_schema = bind_data->table_schema;
+	lookup_data->table_name = bind_data->table_name;
+	lookup_data->table_last_altered = bind_data->table_last_altered;
+	lookup_data->is_base_table = bind_data->is_base_table;
+	lookup_data->collated_columns = bind_data->collated_columns;
+	lookup_data->estimated_cardinality = bind_data->estimated_cardinality;
+	lookup_data->statistics = bind_data->statistics;
+	auto keys = make_shared_ptr<SnowflakeSemiJoinKeys>(get.returned_types[key_ids[lookup_key.GetIndex()]], max_keys);
+	lookup_data->semi_join_keys = keys;
+	lookup_data->semi_join_column = key_ids[lookup_key.GetIndex()];
+	bind_data->record_snapshot = make_shared_ptr<SnowflakeScanSnapshot>();
+	lookup_data->read_snapshot = bind_data->record_snapshot;
+	DPRINT("SnowflakeLateMaterialization: deferring %llu of %llu columns of %s\n",
+	       (unsigned long long)wide_positions.size(), (unsigned long long)column_ids.size(), query.source.c_str());
+
+	filter.ResolveOperatorTypes();
+	auto output_types = filter.types;
+	auto table_index = get.table_index;
+
+	// The original scan becomes the first one, under a new table index
+	auto first_index = binder.GenerateTableIndex();
+	vector<ColumnIndex> first_columns;
+	vector<idx_t> first_positions(column_ids.size(), DConstants::INVALID_INDEX);
+	for (idx_t position = 0; position < column_ids.size(); position++) {
+		if (narrow[position]) {
+			first_positions[position] = first_columns.size();
+			first_columns.push_back(column_ids[position]);
+		}
+	}
+	vector<idx_t> key_positions;
+	for (auto key_id : key_ids) {
+		idx_t key_position = 0;
+		while (key_position < first_columns.size() && first_columns[key_position].GetPrimaryIndex() != key_id) {
+			key_position++;
+		}
+		if (key_position == first_columns.size()) {
+			first_columns.emplace_back(key_id);
+		}
+		key_positions.push_back(key_position);
+	}
+	for (auto &expr : filter.expressions) {
+		RebindColumns(*expr, table_index, [&](idx_t column_index) {
+			return ColumnBinding(first_index, first_positions[outputs[column_index]]);
+		});
+	}
+	// The second scan applies the scan's own filters as well: they hold for every surviving key anyway, and if the
+	// keys overflow at run time and cannot restrict it, it still reads the rows the original scan would have read
+	// rather than the whole table
+	vector<pair<column_t, unique_ptr<TableFilter>>> lookup_filters;
+	for (auto &entry : get.table_filters.filters) {
+		lookup_filters.emplace_back(column_ids[entry.first].GetPrimaryIndex(), entry.second->Copy());
+	}
+	TableFilterSet first_filters;
+	for (auto &entry : get.table_filters.filters) {
+		first_filters.filters[first_positions[entry.first]] = std::move(entry.second);
+	}
+	get.table_filters = std::move(first_filters);
+	get.table_index = first_index;
+	get.projection_ids.clear();
+	get.GetMutableColumnIds() = std::move(first_columns);
+
+	// The second scan returns the deferred columns followed by the key
+	auto lookup_index = binder.GenerateTableIndex();
+	auto lookup = make_uniq<LogicalGet>(lookup_index, get.function, std::move(lookup_data), get.returned_types,
+	                                    get.names, get.virtual_columns);
+	vector<idx_t> lookup_positions(column_ids.size(), DConstants::INVALID_INDEX);
+	for (idx_t i = 0; i < wide_positions.size(); i++) {
+		lookup_positions[wide_positions[i]] = i;
+		lookup->AddColumnId(column_ids[wide_positions[i]].GetPrimaryIndex());
+	}
+	for (auto key_id : key_ids) {
+		lookup->AddColumnId(key_id);
+	}
+	auto lookup_outputs = lookup->GetColumnIds().size();
+	for (auto &entry : lookup_filters) {
+		auto &lookup_columns = lookup->GetColumnIds();
+		idx_t position = 0;
+		while (position < lookup_columns.size() && lookup_columns[position].GetPrimaryIndex() != entry.first) {
+			position++;
+		}
+		if (position == lookup_columns.size()) {
+			lookup->AddColumnId(entry.first);
+		}
+		lookup->table_filters.filters[position] = std::move(entry.second);
+	}
+	if (lookup->GetColumnIds().size() > lookup_outputs) {
+		// Columns fetched for the filters only are not returned
+		for (idx_t position = 0; position < lookup_outputs; position++) {
+			lookup->projection_ids.push_back(position);
+		}
+	}
+	lookup->has_estimated_cardinality = true;
+	lookup->estimated_cardinality = cardinality;
+
+	// The filtered rows are the join's build side, so their keys are complete before the second scan starts
+	auto key_type = get.returned_types[key_ids[lookup_key.GetIndex()]];
+	auto key_binding = ColumnBinding(first_index, key_positions[lookup_key.GetIndex()]);
+	auto key_ref = make_uniq<BoundColumnRefExpression>(key_type, key_binding);
+	auto collector = make_uniq<LogicalSnowflakeKeyCollector>(std::move(keys), std::move(key_ref));
+	collector->has_estimated_cardinality = true;
+	collector->estimated_cardinality = cardinality;
+	collector->children.push_back(std::move(op));
+
+	auto join = make_uniq<LogicalComparisonJoin>(JoinType::INNER);
+	for (idx_t i = 0; i < key_ids.size(); i++) {
+		auto &type = get.returned_types[key_ids[i]];
+		JoinCondition condition;
+		condition.left =
+		    make_uniq<BoundColumnRefExpression>(type, ColumnBinding(lookup_index, wide_positions.size() + i));
+		condition.right = make_uniq<BoundColumnRefExpression>(type, ColumnBinding(first_index, key_positions[i]));
+		condition.comparison = ExpressionType::COMPARE_EQUAL;
+		join->conditions.push_back(std::move(condition));
+	}
+	join->children.push_back(std::move(lookup));
+	join->children.push_back(std::move(collector));
+	join->has_estimated_cardinality = true;
+	join->estimated_cardinality = cardinality;
+
+	// A projection under the original scan's table index keeps the bindings of the operators above valid
+	vector<unique_ptr<Expression>> expressions;
+	for (idx_t i = 0; i < outputs.size(); i++) {
+		auto position = outputs[i];
+		auto binding = narrow[position] ? ColumnBinding(first_index, first_positions[position])
+		                                : ColumnBinding(lookup_index, lookup_positions[position]);
+		expressions.push_back(make_uniq<BoundColumnRefExpression>(output_types[i], binding));
+	}
+	auto projection = make_uniq<LogicalProjection>(table_index, std::move(expressions));
+	projection->children.push_back(std::move(join));
+	projection->has_estimated_cardinality = true;
+	projection->estimated_cardinality = cardinality;
+	op = std::move(projection);
+	return true;
+}
+
+void SnowflakeLateMaterialization::Optimize(unique_ptr<LogicalOperator> &op) {
+	if (TryRewrite(op)) {
+		return;
+	}
+	for (auto &child : op->children) {
+		Optimize(child);
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
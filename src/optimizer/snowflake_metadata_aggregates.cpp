@@ -0,0 +1,133 @@
+#include "optimizer/snowflake_metadata_aggregates.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
+#include "optimizer/snowflake_expression_translator.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/planner/expression/bound_aggregate_expression.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/operator/logical_aggregate.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/planner/operator/logical_projection.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakeMetadataAggregates::SnowflakeMetadataAggregates(ClientContext &context) : context(context) {
+}
+
+bool SnowflakeMetadataAggregates::TryRewrite(unique_ptr<LogicalOperator> &op) {
+	auto &aggregate = op->Cast<LogicalAggregate>();
+	if (!aggregate.groups.empty() || !aggregate.grouping_functions.empty() || aggregate.expressions.empty()) {
+		return false;
+	}
+	auto bind_data = SnowflakeOptimizer::GetScanBindData(*aggregate.children[0]);
+	// Only whole attached tables have metadata that describes them
+	if (!bind_data || bind_data->table_name.empty() || bind_data->query.limit.IsValid() ||
+	    !bind_data->query.predicates.empty() || bind_data->query.distinct || !bind_data->query.qualify.empty() ||
+	    !bind_data->query.sample.empty()) {
+		return false;
+	}
+	auto &get = aggregate.children[0]->Cast<LogicalGet>();
+	auto &query = bind_data->query;
+	for (auto &entry : get.table_filters.filters) {
+		if (!SnowflakeExpressionTranslator::IsOptionalFilter(*entry.second)) {
+			return false;
+		}
+	}
+
+	// Resolves an aggregate input to the table column it reads
+	auto resolve_column = [&](const Expression &expr, string &result) {
+		if (expr.GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF) {
+			return false;
+		}
+		auto &binding = expr.Cast<BoundColumnRefExpression>().binding;
+		if (binding.table_index != get.table_index) {
+			return false;
+		}
+		auto position = get.projection_ids.empty() ? binding.column_index : get.projection_ids[binding.column_index];
+		auto &column_index = get.GetColumnIds()[position];
+		if (column_index.IsRowIdColumn() || column_index.GetPrimaryIndex() >= query.column_names.size()) {
+			return false;
+		}
+		result = query.GetColumnExpression(column_index.GetPrimaryIndex());
+		return true;
+	};
+
+	vector<string> aggregates;
+	vector<LogicalType> types;
+	for (auto &expr : aggregate.expressions) {
+		if (expr->GetExpressionClass() != ExpressionClass::BOUND_AGGREGATE) {
+			return false;
+		}
+		auto &aggr = expr->Cast<BoundAggregateExpression>();
+		if (aggr.IsDistinct() || aggr.filter || aggr.order_bys) {
+			return false;
+		}
+		auto &name = aggr.function.name;
+		string column;
+		if (name == "count_star") {
+			aggregates.push_back("COUNT(*)");
+		} else if (name == "count" && aggr.children.size() == 1 && resolve_column(*aggr.children[0], column)) {
+			aggregates.push_back("COUNT(" + column + ")");
+		} else if ((name == "min" || name == "max") && aggr.children.size() == 1 &&
+		           aggr.children[0]->return_type == aggr.return_type &&
+		           SnowflakeTableStatistics::HasMinMax(aggr.return_type) &&
+		           resolve_column(*aggr.children[0], column)) {
+			aggregates.push_back(StringUtil::Upper(name) + "(" + column + ")");
+		} else {
+			return false;
+		}
+		types.push_back(aggr.return_type);
+	}
+
+	// The aggregate's results keep their bindings, now produced by a projection
+	auto projection = make_uniq<LogicalProjection>(aggregate.aggregate_index, vector<unique_ptr<Expression>>());
+	// The scan now reads the single row of the aggregate query
+	vector<string> select_list;
+	vector<string> names;
+	for (idx_t i = 0; i < aggregates.size(); i++) {
+		names.push_back("C" + to_string(i));
+		select_list.push_back(aggregates[i] + " AS " + SnowflakeQueryBuilder::QuoteIdentifier(names.back()));
+	}
+	query.source = "(SELECT " + StringUtil::Join(select_list, ", ") + " FROM " + query.source + ")";
+	query.column_names = names;
+	query.pushed_columns.clear();
+	query.order_by.clear();
+	bind_data->all_types = types;
+	// The result no longer has the table's columns: keep caches, result reuse and statistics away from it
+	bind_data->semantic_cache_source.clear();
+	bind_data->table_schema.clear();
+	bind_data->table_name.clear();
+	bind_data->table_last_altered.clear();
+	bind_data->statistics.reset();
+	bind_data->estimated_cardinality = 1;
+	DPRINT("SnowflakeMetadataAggregates: scanning %s\n", query.source.c_str());
+
+	get.returned_types = types;
+	get.names = names;
+	get.projection_ids.clear();
+	get.table_filters.filters.clear();
+	auto &column_ids = get.GetMutableColumnIds();
+	column_ids.clear();
+	for (idx_t i = 0; i < types.size(); i++) {
+		column_ids.emplace_back(i);
+		projection->expressions.push_back(
+		    make_uniq<BoundColumnRefExpression>(types[i], ColumnBinding(get.table_index, i)));
+	}
+	projection->children.push_back(std::move(aggregate.children[0]));
+	op = std::move(projection);
+	return true;
+}
+
+void SnowflakeMetadataAggregates::Optimize(unique_ptr<LogicalOperator> &op) {
+	if (op->type == LogicalOperatorType::LOGICAL_AGGREGATE_AND_GROUP_BY && TryRewrite(op)) {
+		return;
+	}
+	for (auto &child : op->children) {
+		Optimize(child);
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,125 @@
+#include "optimizer/snowflake_optimizer.hpp"
+#include "optimizer/snowflake_expression_translator.hpp"
+#include "optimizer/snowflake_distinct_pushdown.hpp"
+#include "optimizer/snowflake_late_materialization.hpp"
+#include "optimizer/snowflake_metadata_aggregates.hpp"
+#include "optimizer/snowflake_path_pushdown.hpp"
+#include "optimizer/snowflake_projection_pushdown.hpp"
+#include "optimizer/snowflake_sample_pushdown.hpp"
+#include "optimizer/snowflake_topn_pushdown.hpp"
+#include "optimizer/snowflake_scan_spooling.hpp"
+#include "optimizer/snowflake_semi_join_pushdown.hpp"
+#include "optimizer/snowflake_setop_pushdown.hpp"
+#include "optimizer/snowflake_union_prefetch.hpp"
+#include "snowflake_scan.hpp"
+#include "duckdb/optimizer/optimizer.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+OptimizerExtension SnowflakeOptimizer::GetExtension() {
+	OptimizerExtension extension;
+	extension.optimize_function = SnowflakeOptimizer::Optimize;
+	return extension;
+}
+
+void SnowflakeOptimizer::Optimize(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+	auto &context = input.context;
+
+	// Runs first, so the other rewrites see the scans below samples
+	SnowflakeSamplePushdown sample_pushdown(context);
+	sample_pushdown.Optimize(plan);
+
+	SnowflakePathPushdown path_pushdown(context);
+	path_pushdown.Optimize(plan);
+
+	SnowflakeProjectionPushdown projection_pushdown(context);
+	projection_pushdown.Optimize(plan);
+
+	// Runs after the path and projection pushdowns so branches can select pushed columns
+	SnowflakeSetOperationPushdown setop_pushdown(context);
+	setop_pushdown.Optimize(plan);
+
+	SnowflakeDistinctPushdown distinct_pushdown(context);
+	distinct_pushdown.Optimize(plan);
+
+	// Runs after the path and projection pushdowns so orderings can refer to pushed columns, and after the set
+	// operation pushdown so orderings over a combined statement are sent along
+	SnowflakeTopNPushdown top_n_pushdown(context);
+	top_n_pushdown.Optimize(plan);
+
+	SnowflakeMetadataAggregates metadata_aggregates(context);
+	metadata_aggregates.Optimize(plan);
+
+	// Runs after the rewrites that change which columns the scans return
+	Value late_materialization;
+	if (context.TryGetCurrentSetting("snowflake_late_materialization", late_materialization) &&
+	    !late_materialization.IsNull() && BooleanValue::Get(late_materialization)) {
+		SnowflakeLateMaterialization late_materialization_rewrite(context, input.optimizer.binder);
+		late_materialization_rewrite.Optimize(plan);
+	}
+
+	Value semi_join;
+	if (context.TryGetCurrentSetting("snowflake_semi_join_pushdown", semi_join) && !semi_join.IsNull() &&
+	    BooleanValue::Get(semi_join)) {
+		SnowflakeSemiJoinPushdown semi_join_pushdown(context);
+		semi_join_pushdown.Optimize(plan);
+	}
+
+	// Runs once the queries the scans send are final
+	SnowflakeScanSpooling spooling;
+	spooling.Optimize(plan);
+
+	// Runs last, as spooled scans may not send their query. Scans the result or semantic cache may answer locally do
+	// not have their queries executed ahead.
+	SnowflakeResultCacheOptions cache_options;
+	Value semantic_cache;
+	bool local_caches = SnowflakeResultCacheOptions::FromSettings(context, cache_options) ||
+	                    (context.TryGetCurrentSetting("snowflake_semantic_cache", semantic_cache) &&
+	                     !semantic_cache.IsNull() && BooleanValue::Get(semantic_cache));
+	if (SnowflakeScanPrefetches::GetMaxQueries(context) > 0 && !local_caches) {
+		SnowflakeUnionPrefetch union_prefetch;
+		union_prefetch.Optimize(plan);
+	}
+}
+
+optional_ptr<SnowflakeScanBindData> SnowflakeOptimizer::GetScanBindData(LogicalOperator &op) {
+	if (op.type != LogicalOperatorType::LOGICAL_GET) {
+		return nullptr;
+	}
+	auto &get = op.Cast<LogicalGet>();
+	if (get.function.name != "snowflake_scan" || !get.bind_data) {
+		return nullptr;
+	}
+	auto &bind_data = get.bind_data->Cast<SnowflakeScanBindData>();
+	// Scans of a local copy do not send a query that could be rewritten
+	if (bind_data.replica) {
+		return nullptr;
+	}
+	return &bind_data;
+}
+
+bool SnowflakeOptimizer::EvaluatesAllFilters(LogicalGet &get, const SnowflakeScanBindData &bind_data) {
+	for (auto &entry : get.table_filters.filters) {
+		auto &filter = *entry.second;
+		if (SnowflakeExpressionTranslator::IsOptionalFilter(filter)) {
+			continue;
+		}
+		auto &column_index = get.GetColumnIds()[entry.first];
+		string sql;
+		if (column_index.IsRowIdColumn() || !bind_data.CanPushFilter(column_index.GetPrimaryIndex()) ||
+		    !SnowflakeExpressionTranslator::TranslateFilter(
+		        filter, bind_data.query.GetColumnExpression(column_index.GetPrimaryIndex()), sql)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SnowflakeOptimizer::IsCollated(const LogicalType &type) {
+	return type.id() == LogicalTypeId::VARCHAR && !StringType::GetCollation(type).empty();
+}
+
+} // namespace snowflake
+} // namespace duckdb
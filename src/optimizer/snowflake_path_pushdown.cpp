@@ -0,0 +1,327 @@
+#include "optimizer/snowflake_path_pushdown.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/planner/logical_operator_visitor.hpp"
+#include "duckdb/planner/expression_iterator.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakePathPushdown::SnowflakePathPushdown(ClientContext &context) : context(context) {
+}
+
+bool SnowflakePathPushdown::ParseJSONPath(const string &path, vector<SnowflakePathElement> &result) {
+	if (path.empty() || path[0] == '/') {
+		// JSON pointers cannot tell object keys and array indexes apart
+		return false;
+	}
+	if (path[0] != '$') {
+		SnowflakePathElement element;
+		element.key = path;
+		result.push_back(std::move(element));
+		return true;
+	}
+	idx_t pos = 1;
+	while (pos < path.size()) {
+		SnowflakePathElement element;
+		if (path[pos] == '.') {
+			pos++;
+			if (pos < path.size() && path[pos] == '"') {
+				auto end = path.find('"', pos + 1);
+				if (end == string::npos) {
+					return false;
+				}
+				element.key = path.substr(pos + 1, end - pos - 1);
+				pos = end + 1;
+			} else {
+				auto start = pos;
+				while (pos < path.size() && path[pos] != '.' && path[pos] != '[') {
+					pos++;
+				}
+				element.key = path.substr(start, pos - start);
+				if (element.key.empty() || element.key == "*") {
+					return false;
+				}
+			}
+		} else if (path[pos] == '[') {
+			auto end = path.find(']', pos);
+			if (end == string::npos || end == pos + 1) {
+				return false;
+			}
+			auto index = path.substr(pos + 1, end - pos - 1);
+			for (auto c : index) {
+				// Wildcards and from-the-end (#-n) indexes have no Snowflake path equivalent
+				if (!StringUtil::CharacterIsDigit(c)) {
+					return false;
+				}
+			}
+			element.is_index = true;
+			element.index = std::stoull(index);
+			pos = end + 1;
+		} else {
+			return false;
+		}
+		result.push_back(std::move(element));
+	}
+	return !result.empty();
+}
+
+void SnowflakePathPushdown::FindScans(LogicalOperator &op) {
+	auto bind_data = SnowflakeOptimizer::GetScanBindData(op);
+	if (bind_data) {
+		auto &get = op.Cast<LogicalGet>();
+		// Scans with a separate projection list map bindings differently, leave them alone
+		if (get.projection_ids.empty()) {
+			vector<column_t> column_ids;
+			for (auto &column_index : get.GetColumnIds()) {
+				column_ids.push_back(column_index.IsRowIdColumn() ? COLUMN_IDENTIFIER_ROW_ID
+				                                                   : column_index.GetPrimaryIndex());
+			}
+			ScanInfo info {get, *bind_data, std::move(column_ids), vector<ScanColumn>(get.GetColumnIds().size())};
+			// Filtered columns keep their slot, the scan evaluates the filters on the whole value
+			for (auto &filter : get.table_filters.filters) {
+				info.columns[filter.first].raw_use = true;
+			}
+			scans.emplace(get.table_index, std::move(info));
+		}
+	}
+	for (auto &child : op.children) {
+		FindScans(*child);
+	}
+}
+
+bool SnowflakePathPushdown::IsPathColumn(const ColumnBinding &binding) {
+	auto entry = scans.find(binding.table_index);
+	if (entry == scans.end()) {
+		return false;
+	}
+	auto &scan = entry->second;
+	if (binding.column_index >= scan.column_ids.size()) {
+		return false;
+	}
+	auto column_id = scan.column_ids[binding.column_index];
+	if (IsRowIdColumnId(column_id) || column_id >= scan.bind_data.query.column_names.size()) {
+		return false;
+	}
+	auto &type = scan.bind_data.all_types[column_id];
+	switch (type.id()) {
+	case LogicalTypeId::STRUCT:
+	case LogicalTypeId::LIST:
+		return true;
+	default:
+		return type.IsJSONType();
+	}
+}
+
+bool SnowflakePathPushdown::MatchPath(Expression &expr, ColumnBinding &binding, vector<SnowflakePathElement> &path) {
+	if (expr.GetExpressionClass() == ExpressionClass::BOUND_COLUMN_REF) {
+		auto &colref = expr.Cast<BoundColumnRefExpression>();
+		if (colref.depth > 0 || !IsPathColumn(colref.binding)) {
+			return false;
+		}
+		binding = colref.binding;
+		return true;
+	}
+	if (expr.GetExpressionClass() != ExpressionClass::BOUND_FUNCTION) {
+		return false;
+	}
+	auto &function = expr.Cast<BoundFunctionExpression>();
+	if (function.children.size() != 2 ||
+	    function.children[1]->GetExpressionClass() != ExpressionClass::BOUND_CONSTANT) {
+		return false;
+	}
+	auto &argument = function.children[1]->Cast<BoundConstantExpression>().value;
+	if (argument.IsNull()) {
+		return false;
+	}
+	auto &name = function.function.name;
+	auto &input_type = function.children[0]->return_type;
+	auto argument_is_string = argument.type().id() == LogicalTypeId::VARCHAR;
+	auto argument_is_integer = argument.type().IsIntegral();
+
+	vector<SnowflakePathElement> elements;
+	if (name == "struct_extract" || name == "struct_extract_at") {
+		if (input_type.id() != LogicalTypeId::STRUCT) {
+			return false;
+		}
+		// Use the exact field name, Snowflake object keys are case-sensitive
+		auto &child_types = StructType::GetChildTypes(input_type);
+		optional_idx child_idx;
+		if (argument_is_string) {
+			auto key = StringValue::Get(argument);
+			for (idx_t i = 0; i < child_types.size() && !child_idx.IsValid(); i++) {
+				if (StringUtil::CIEquals(child_types[i].first, key)) {
+					child_idx = i;
+				}
+			}
+		} else if (argument_is_integer) {
+			auto index = argument.GetValue<int64_t>();
+			if (index >= 1 && idx_t(index) <= child_types.size()) {
+				child_idx = idx_t(index - 1);
+			}
+		}
+		if (!child_idx.IsValid()) {
+			return false;
+		}
+		SnowflakePathElement element;
+		element.key = child_types[child_idx.GetIndex()].first;
+		elements.push_back(std::move(element));
+	} else if (name == "array_extract" || name == "list_extract") {
+		// DuckDB lists are 1-based, Snowflake arrays 0-based
+		if (input_type.id() != LogicalTypeId::LIST || !argument_is_integer || argument.GetValue<int64_t>() < 1) {
+			return false;
+		}
+		SnowflakePathElement element;
+		element.is_index = true;
+		element.index = idx_t(argument.GetValue<int64_t>() - 1);
+		elements.push_back(std::move(element));
+	} else if (name == "json_extract" || name == "json_extract_string") {
+		if (!input_type.IsJSONType()) {
+			return false;
+		}
+		if (argument_is_string) {
+			if (!ParseJSONPath(StringValue::Get(argument), elements)) {
+				return false;
+			}
+		} else if (argument_is_integer && argument.GetValue<int64_t>() >= 0) {
+			SnowflakePathElement element;
+			element.is_index = true;
+			element.index = idx_t(argument.GetValue<int64_t>());
+			elements.push_back(std::move(element));
+		} else {
+			return false;
+		}
+	} else {
+		return false;
+	}
+	if (!MatchPath(*function.children[0], binding, path)) {
+		return false;
+	}
+	path.insert(path.end(), elements.begin(), elements.end());
+	return true;
+}
+
+SnowflakePathPushdown::PathColumn SnowflakePathPushdown::CreatePathColumn(const ColumnBinding &binding,
+                                                                          const vector<SnowflakePathElement> &path,
+                                                                          const LogicalType &type) {
+	auto &scan = scans.at(binding.table_index);
+	auto column_id = scan.column_ids[binding.column_index];
+	auto &column_name = scan.bind_data.query.column_names[column_id];
+
+	PathColumn result;
+	result.expression = SnowflakeQueryBuilder::QuoteIdentifier(column_name);
+	result.name = column_name;
+	for (idx_t i = 0; i < path.size(); i++) {
+		auto &element = path[i];
+		if (element.is_index) {
+			result.expression += "[" + to_string(element.index) + "]";
+			result.name += "[" + to_string(element.index) + "]";
+		} else {
+			result.expression += (i == 0 ? ":" : ".") + SnowflakeQueryBuilder::QuoteIdentifier(element.key);
+			result.name += (i == 0 ? ":" : ".") + element.key;
+		}
+	}
+	if (type.id() == LogicalTypeId::VARCHAR && !type.IsJSONType()) {
+		// Strings come back unquoted, anything else as its JSON text, like json_extract_string
+		result.expression += "::VARCHAR";
+	}
+	// Everything else arrives as VARIANT text and is converted by the scan
+	result.type = type;
+	return result;
+}
+
+void SnowflakePathPushdown::VisitExpression(unique_ptr<Expression> &expr, bool rewrite) {
+	ColumnBinding binding;
+	vector<SnowflakePathElement> path;
+	if (MatchPath(*expr, binding, path)) {
+		auto &scan_column = scans.at(binding.table_index).columns[binding.column_index];
+		if (path.empty()) {
+			scan_column.raw_use = true;
+			return;
+		}
+		auto path_column = CreatePathColumn(binding, path, expr->return_type);
+		for (auto &existing : scan_column.paths) {
+			if (existing.expression == path_column.expression && existing.type == path_column.type) {
+				if (rewrite) {
+					auto alias = expr->GetAlias().empty() ? existing.name : expr->GetAlias();
+					expr = make_uniq<BoundColumnRefExpression>(alias, existing.type,
+					                                           ColumnBinding(binding.table_index, existing.position));
+				}
+				return;
+			}
+		}
+		D_ASSERT(!rewrite);
+		scan_column.paths.push_back(std::move(path_column));
+		return;
+	}
+	if (expr->GetExpressionClass() == ExpressionClass::BOUND_COLUMN_REF) {
+		return;
+	}
+	ExpressionIterator::EnumerateChildren(*expr,
+	                                      [&](unique_ptr<Expression> &child) { VisitExpression(child, rewrite); });
+}
+
+void SnowflakePathPushdown::VisitOperator(LogicalOperator &op, bool rewrite) {
+	LogicalOperatorVisitor::EnumerateExpressions(
+	    op, [&](unique_ptr<Expression> *child) { VisitExpression(*child, rewrite); });
+	for (auto &child : op.children) {
+		VisitOperator(*child, rewrite);
+	}
+}
+
+void SnowflakePathPushdown::AssignColumns(ScanInfo &scan) {
+	auto &get = scan.get;
+	auto &query = scan.bind_data.query;
+	for (idx_t position = 0; position < scan.columns.size(); position++) {
+		auto &scan_column = scan.columns[position];
+		for (idx_t i = 0; i < scan_column.paths.size(); i++) {
+			auto &path = scan_column.paths[i];
+			auto column_id = query.AddPushedColumn(SnowflakePushedColumn {path.name, path.expression, path.type});
+			if (column_id == scan.bind_data.all_types.size()) {
+				scan.bind_data.all_types.push_back(path.type);
+			}
+			if (column_id == get.returned_types.size()) {
+				get.returned_types.push_back(path.type);
+				get.names.push_back(path.name);
+			}
+			if (!scan_column.raw_use && i == 0) {
+				// The document itself is no longer needed: its slot is taken over by the first path
+				get.GetMutableColumnIds()[position] = ColumnIndex(column_id);
+				path.position = position;
+			} else {
+				path.position = get.GetColumnIds().size();
+				get.AddColumnId(column_id);
+			}
+			DPRINT("SnowflakePathPushdown: pushing %s as column %llu\n", path.expression.c_str(),
+			       (unsigned long long)column_id);
+		}
+	}
+}
+
+void SnowflakePathPushdown::Optimize(unique_ptr<LogicalOperator> &plan) {
+	FindScans(*plan);
+	if (scans.empty()) {
+		return;
+	}
+	// First collect which paths are used and whether the documents themselves are still needed, then rewrite
+	VisitOperator(*plan, false);
+	bool has_paths = false;
+	for (auto &entry : scans) {
+		for (auto &column : entry.second.columns) {
+			has_paths = has_paths || !column.paths.empty();
+		}
+		AssignColumns(entry.second);
+	}
+	if (has_paths) {
+		VisitOperator(*plan, true);
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,195 @@
+#include "optimizer/snowflake_projection_pushdown.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
+#include "optimizer/snowflake_expression_translator.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/planner/expression_iterator.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/planner/operator/logical_projection.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakeProjectionPushdown::SnowflakeProjectionPushdown(ClientContext &context) : context(context) {
+}
+
+// Bytes a value of type takes in a result row, counting strings by their DuckDB representation
+static idx_t GetValueWidth(const LogicalType &type) {
+	auto physical_type = type.InternalType();
+	return TypeIsConstantSize(physical_type) ? GetTypeIdSize(physical_type) : sizeof(string_t);
+}
+
+static void RemapColumns(Expression &expr, idx_t table_index, const vector<optional_idx> &new_positions) {
+	if (expr.GetExpressionClass() == ExpressionClass::BOUND_COLUMN_REF) {
+		auto &binding = expr.Cast<BoundColumnRefExpression>().binding;
+		if (binding.table_index == table_index) {
+			binding.column_index = new_positions[binding.column_index].GetIndex();
+		}
+		return;
+	}
+	ExpressionIterator::EnumerateChildren(
+	    expr, [&](Expression &child) { RemapColumns(child, table_index, new_positions); });
+}
+
+void SnowflakeProjectionPushdown::TryPushdown(LogicalProjection &projection) {
+	auto bind_data = SnowflakeOptimizer::GetScanBindData(*projection.children[0]);
+	if (!bind_data) {
+		return;
+	}
+	auto &get = projection.children[0]->Cast<LogicalGet>();
+	// Scans with a separate projection list map bindings differently, leave them alone
+	if (!get.projection_ids.empty()) {
+		return;
+	}
+	auto &query = bind_data->query;
+	auto &column_ids = get.GetColumnIds();
+
+	SnowflakeExpressionTranslator translator([&](const ColumnBinding &binding, string &result) {
+		if (binding.table_index != get.table_index || binding.column_index >= column_ids.size()) {
+			return false;
+		}
+		auto &column_index = column_ids[binding.column_index];
+		if (column_index.IsRowIdColumn() || !bind_data->CanPushFilter(column_index.GetPrimaryIndex())) {
+			return false;
+		}
+		result = query.GetColumnExpression(column_index.GetPrimaryIndex());
+		return true;
+	});
+
+	// Scan columns that must still be fetched: filtered ones, and those read by expressions that stay local
+	vector<bool> raw_use(column_ids.size(), false);
+	for (auto &filter : get.table_filters.filters) {
+		raw_use[filter.first] = true;
+	}
+	struct Candidate {
+		idx_t expression_index;
+		string sql;
+		vector<idx_t> positions;
+		bool pushed = true;
+	};
+	vector<Candidate> candidates;
+	for (idx_t i = 0; i < projection.expressions.size(); i++) {
+		auto &expr = *projection.expressions[i];
+		vector<idx_t> positions;
+		ExpressionIterator::VisitExpression<BoundColumnRefExpression>(
+		    expr, [&](const BoundColumnRefExpression &colref) {
+			    if (colref.binding.table_index == get.table_index) {
+				    positions.push_back(colref.binding.column_index);
+			    }
+		    });
+		string sql;
+		if (expr.GetExpressionClass() == ExpressionClass::BOUND_COLUMN_REF || positions.empty() ||
+		    !translator.Translate(expr, sql)) {
+			for (auto position : positions) {
+				raw_use[position] = true;
+			}
+			continue;
+		}
+		candidates.push_back(Candidate {i, std::move(sql), std::move(positions)});
+	}
+	// An expression is only worth pushing if none of its columns is still fetched; giving one up can keep another's
+	// columns in the result, so repeat until nothing changes
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (auto &candidate : candidates) {
+			if (!candidate.pushed) {
+				continue;
+			}
+			for (auto position : candidate.positions) {
+				candidate.pushed = candidate.pushed && !raw_use[position];
+			}
+			if (!candidate.pushed) {
+				for (auto position : candidate.positions) {
+					raw_use[position] = true;
+				}
+				changed = true;
+			}
+		}
+	}
+
+	// Several expressions over the same columns can fetch more than the columns themselves
+	vector<bool> removed(column_ids.size(), false);
+	idx_t pushed_width = 0;
+	for (auto &candidate : candidates) {
+		if (candidate.pushed) {
+			pushed_width += GetValueWidth(projection.expressions[candidate.expression_index]->return_type);
+			for (auto position : candidate.positions) {
+				removed[position] = true;
+			}
+		}
+	}
+	idx_t removed_width = 0;
+	for (idx_t position = 0; position < column_ids.size(); position++) {
+		if (removed[position]) {
+			removed_width += GetValueWidth(bind_data->all_types[column_ids[position].GetPrimaryIndex()]);
+		}
+	}
+	if (removed_width == 0 || pushed_width > removed_width) {
+		return;
+	}
+
+	// The scan keeps the columns still fetched in their order, followed by the pushed expressions
+	vector<optional_idx> new_positions(column_ids.size());
+	vector<ColumnIndex> new_column_ids;
+	for (idx_t position = 0; position < column_ids.size(); position++) {
+		if (!removed[position]) {
+			new_positions[position] = new_column_ids.size();
+			new_column_ids.push_back(column_ids[position]);
+		}
+	}
+	TableFilterSet table_filters;
+	for (auto &filter : get.table_filters.filters) {
+		table_filters.filters[new_positions[filter.first].GetIndex()] = std::move(filter.second);
+	}
+	get.table_filters = std::move(table_filters);
+	vector<bool> pushed(projection.expressions.size(), false);
+	for (auto &candidate : candidates) {
+		pushed[candidate.expression_index] = candidate.pushed;
+	}
+	for (idx_t i = 0; i < projection.expressions.size(); i++) {
+		if (!pushed[i]) {
+			RemapColumns(*projection.expressions[i], get.table_index, new_positions);
+		}
+	}
+
+	unordered_map<idx_t, idx_t> pushed_positions;
+	for (auto &candidate : candidates) {
+		if (!candidate.pushed) {
+			continue;
+		}
+		auto &expr = projection.expressions[candidate.expression_index];
+		auto type = expr->return_type;
+		auto name = expr->GetAlias().empty() ? expr->GetName() : expr->GetAlias();
+		auto column_id = query.AddPushedColumn(SnowflakePushedColumn {name, candidate.sql, type});
+		if (column_id == bind_data->all_types.size()) {
+			bind_data->all_types.push_back(type);
+		}
+		if (column_id == get.returned_types.size()) {
+			get.returned_types.push_back(type);
+			get.names.push_back(name);
+		}
+		auto entry = pushed_positions.find(column_id);
+		if (entry == pushed_positions.end()) {
+			entry = pushed_positions.emplace(column_id, new_column_ids.size()).first;
+			new_column_ids.emplace_back(column_id);
+		}
+		DPRINT("SnowflakeProjectionPushdown: pushing %s as column %llu\n", candidate.sql.c_str(),
+		       (unsigned long long)column_id);
+		expr = make_uniq<BoundColumnRefExpression>(name, type, ColumnBinding(get.table_index, entry->second));
+	}
+	get.GetMutableColumnIds() = std::move(new_column_ids);
+}
+
+void SnowflakeProjectionPushdown::Optimize(unique_ptr<LogicalOperator> &op) {
+	if (op->type == LogicalOperatorType::LOGICAL_PROJECTION) {
+		TryPushdown(op->Cast<LogicalProjection>());
+	}
+	for (auto &child : op->children) {
+		Optimize(child);
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,73 @@
+#include "optimizer/snowflake_sample_pushdown.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
+#include "optimizer/snowflake_expression_translator.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/parser/parsed_data/sample_options.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/planner/operator/logical_sample.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakeSamplePushdown::SnowflakeSamplePushdown(ClientContext &context) : context(context) {
+}
+
+bool SnowflakeSamplePushdown::TryPushdown(unique_ptr<LogicalOperator> &op) {
+	auto &sample = op->Cast<LogicalSample>();
+	auto &options = *sample.sample_options;
+	// Projections compute row by row, so sampling below them keeps the same rows
+	reference<LogicalOperator> current = *sample.children[0];
+	while (current.get().type == LogicalOperatorType::LOGICAL_PROJECTION) {
+		current = *current.get().children[0];
+	}
+	auto bind_data = SnowflakeOptimizer::GetScanBindData(current.get());
+	if (!bind_data) {
+		return false;
+	}
+	auto &query = bind_data->query;
+	if (!query.sample.empty() || query.distinct || !query.qualify.empty() || !query.order_by.empty() ||
+	    query.limit.IsValid() || bind_data->semi_join_keys) {
+		return false;
+	}
+	// Snowflake seeds percentage samples only
+	auto seed = options.repeatable ? options.seed : optional_idx();
+
+	if (options.is_percentage) {
+		// Snowflake samples blocks of and seeds samples of base tables only; views, external tables and query results
+		// are sampled by rows, and a seeded sample of them stays local
+		if (seed.IsValid() && !bind_data->is_base_table) {
+			return false;
+		}
+		auto percentage = options.sample_size.GetValue<double>();
+		bool block_sampling = options.method == SampleMethod::SYSTEM_SAMPLE && bind_data->is_base_table;
+		query.SetPercentageSample(percentage, block_sampling, seed);
+	} else {
+		// Snowflake draws a fixed-size sample before applying the WHERE clause, DuckDB from the filtered rows
+		auto &get = current.get().Cast<LogicalGet>();
+		for (auto &entry : get.table_filters.filters) {
+			if (!SnowflakeExpressionTranslator::IsOptionalFilter(*entry.second)) {
+				return false;
+			}
+		}
+		auto rows = options.sample_size.GetValue<idx_t>();
+		if (!query.predicates.empty() || seed.IsValid() || rows > SnowflakeQueryBuilder::MAX_SAMPLE_ROWS) {
+			return false;
+		}
+		query.SetRowSample(rows);
+	}
+	DPRINT("SnowflakeSamplePushdown: pushed SAMPLE %s\n", query.sample.c_str());
+	op = std::move(sample.children[0]);
+	return true;
+}
+
+void SnowflakeSamplePushdown::Optimize(unique_ptr<LogicalOperator> &op) {
+	while (op->type == LogicalOperatorType::LOGICAL_SAMPLE && TryPushdown(op)) {
+	}
+	for (auto &child : op->children) {
+		Optimize(child);
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,50 @@
+#include "optimizer/snowflake_scan_spooling.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+static string GetScanSignature(LogicalGet &get, const SnowflakeScanBindData &bind_data) {
+	vector<column_t> column_ids;
+	for (auto &column_index : get.GetColumnIds()) {
+		column_ids.push_back(column_index.GetPrimaryIndex());
+	}
+	auto signature = bind_data.query.Build(column_ids);
+	for (auto &entry : get.table_filters.filters) {
+		signature += "\n" + to_string(entry.first) + ": " + entry.second->ToString("c");
+	}
+	return signature;
+}
+
+void SnowflakeScanSpooling::CollectScans(LogicalOperator &op, bool repeated) {
+	auto bind_data = SnowflakeOptimizer::GetScanBindData(op);
+	// Semi-join scans send a query that depends on the keys collected for their join, and scans recording their
+	// snapshot must run their own query
+	if (bind_data && !bind_data->semi_join_keys && !bind_data->record_snapshot) {
+		bind_data->spool = repeated;
+		scans[GetScanSignature(op.Cast<LogicalGet>(), *bind_data)].push_back(*bind_data);
+	}
+	for (idx_t child_idx = 0; child_idx < op.children.size(); child_idx++) {
+		bool recursive_part = op.type == LogicalOperatorType::LOGICAL_RECURSIVE_CTE && child_idx == 1;
+		CollectScans(*op.children[child_idx], repeated || recursive_part);
+	}
+}
+
+void SnowflakeScanSpooling::Optimize(unique_ptr<LogicalOperator> &op) {
+	CollectScans(*op, false);
+	for (auto &entry : scans) {
+		if (entry.second.size() < 2) {
+			continue;
+		}
+		DPRINT("SnowflakeScanSpooling: %zu scans send the same query\n", entry.second.size());
+		for (auto &bind_data : entry.second) {
+			bind_data.get().spool = true;
+		}
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,112 @@
+#include "optimizer/snowflake_semi_join_pushdown.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_semi_join.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/operator/logical_comparison_join.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakeSemiJoinPushdown::SnowflakeSemiJoinPushdown(ClientContext &context) : context(context) {
+	Value setting;
+	if (context.TryGetCurrentSetting("snowflake_semi_join_ratio", setting) && !setting.IsNull()) {
+		ratio = UBigIntValue::Get(setting);
+	}
+	if (context.TryGetCurrentSetting("snowflake_semi_join_max_keys", setting) && !setting.IsNull()) {
+		max_keys = UBigIntValue::Get(setting);
+	}
+}
+
+static bool ScansSnowflake(LogicalOperator &op) {
+	if (SnowflakeOptimizer::GetScanBindData(op)) {
+		return true;
+	}
+	for (auto &child : op.children) {
+		if (ScansSnowflake(*child)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void SnowflakeSemiJoinPushdown::TryPushdown(LogicalComparisonJoin &join) {
+	// Joins that keep every row of the Snowflake side cannot drop rows without a match
+	switch (join.join_type) {
+	case JoinType::INNER:
+	case JoinType::SEMI:
+	case JoinType::RIGHT_SEMI:
+	case JoinType::RIGHT:
+		break;
+	default:
+		return;
+	}
+	// The Snowflake scan must probe the join, so the build side is complete before it starts
+	auto bind_data = SnowflakeOptimizer::GetScanBindData(*join.children[0]);
+	// A restriction of the rows would change which rows a pushed QUALIFY keeps; a scan recording its snapshot must
+	// run on the connection that tracks query IDs, while key tables live in the session of the main one
+	if (!bind_data || bind_data->semi_join_keys || bind_data->record_snapshot || !bind_data->query.qualify.empty() ||
+	    ScansSnowflake(*join.children[1])) {
+		return;
+	}
+	auto &get = join.children[0]->Cast<LogicalGet>();
+
+	optional_idx condition_index;
+	column_t column_id = 0;
+	for (idx_t i = 0; i < join.conditions.size(); i++) {
+		auto &condition = join.conditions[i];
+		if (condition.comparison != ExpressionType::COMPARE_EQUAL ||
+		    condition.left->GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF ||
+		    condition.left->return_type != condition.right->return_type ||
+		    !SnowflakeSemiJoinKeys::IsSupportedType(condition.left->return_type)) {
+			continue;
+		}
+		auto &binding = condition.left->Cast<BoundColumnRefExpression>().binding;
+		if (binding.table_index != get.table_index) {
+			continue;
+		}
+		auto position = get.projection_ids.empty() ? binding.column_index : get.projection_ids[binding.column_index];
+		auto &column_index = get.GetColumnIds()[position];
+		if (column_index.IsRowIdColumn() || !bind_data->CanPushFilter(column_index.GetPrimaryIndex())) {
+			continue;
+		}
+		condition_index = i;
+		column_id = column_index.GetPrimaryIndex();
+		break;
+	}
+	if (!condition_index.IsValid()) {
+		return;
+	}
+
+	auto local_cardinality = join.children[1]->EstimateCardinality(context);
+	auto remote_cardinality = join.children[0]->EstimateCardinality(context);
+	if (local_cardinality > max_keys || remote_cardinality / MaxValue<idx_t>(local_cardinality, 1) < ratio) {
+		return;
+	}
+	DPRINT("SnowflakeSemiJoinPushdown: restricting scan of %llu rows to the keys of %llu local rows\n",
+	       (unsigned long long)remote_cardinality, (unsigned long long)local_cardinality);
+
+	auto &condition = join.conditions[condition_index.GetIndex()];
+	auto keys = make_shared_ptr<SnowflakeSemiJoinKeys>(condition.right->return_type, max_keys);
+	bind_data->semi_join_keys = keys;
+	bind_data->semi_join_column = column_id;
+	auto collector = make_uniq<LogicalSnowflakeKeyCollector>(std::move(keys), condition.right->Copy());
+	collector->has_estimated_cardinality = true;
+	collector->estimated_cardinality = local_cardinality;
+	collector->children.push_back(std::move(join.children[1]));
+	join.children[1] = std::move(collector);
+}
+
+void SnowflakeSemiJoinPushdown::Optimize(unique_ptr<LogicalOperator> &op) {
+	for (auto &child : op->children) {
+		Optimize(child);
+	}
+	if (op->type == LogicalOperatorType::LOGICAL_COMPARISON_JOIN) {
+		TryPushdown(op->Cast<LogicalComparisonJoin>());
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
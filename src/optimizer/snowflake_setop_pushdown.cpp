@@ -0,0 +1,257 @@
+#include "optimizer/snowflake_setop_pushdown.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
+#include "optimizer/snowflake_expression_translator.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/planner/expression/bound_columnref_expression.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/planner/operator/logical_projection.hpp"
+#include "duckdb/planner/operator/logical_set_operation.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakeSetOperationPushdown::SnowflakeSetOperationPushdown(ClientContext &context) : context(context) {
+}
+
+//! A branch of a set operation that reads a Snowflake scan
+struct SnowflakeSetOperationBranch {
+	//! The pointer holding the scan within the branch, so the first branch's scan can be reused
+	optional_ptr<unique_ptr<LogicalOperator>> scan;
+	optional_ptr<SnowflakeScanBindData> bind_data;
+	//! Scan column id of every output column of the branch
+	vector<column_t> column_ids;
+};
+
+// Follows the output columns of a branch through projections of plain columns down to a Snowflake scan
+static bool ResolveBranch(unique_ptr<LogicalOperator> &branch, idx_t column_count,
+                          SnowflakeSetOperationBranch &result) {
+	vector<idx_t> indexes;
+	for (idx_t i = 0; i < column_count; i++) {
+		indexes.push_back(i);
+	}
+	reference<unique_ptr<LogicalOperator>> current = branch;
+	while (current.get()->type == LogicalOperatorType::LOGICAL_PROJECTION) {
+		auto &projection = current.get()->Cast<LogicalProjection>();
+		auto child_bindings = projection.children[0]->GetColumnBindings();
+		for (auto &index : indexes) {
+			auto &expr = *projection.expressions[index];
+			if (expr.GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF) {
+				return false;
+			}
+			auto &binding = expr.Cast<BoundColumnRefExpression>().binding;
+			auto entry = std::find(child_bindings.begin(), child_bindings.end(), binding);
+			if (entry == child_bindings.end()) {
+				return false;
+			}
+			index = NumericCast<idx_t>(entry - child_bindings.begin());
+		}
+		current = projection.children[0];
+	}
+	result.bind_data = SnowflakeOptimizer::GetScanBindData(*current.get());
+	if (!result.bind_data) {
+		return false;
+	}
+	auto &get = current.get()->Cast<LogicalGet>();
+	for (auto index : indexes) {
+		auto position = get.projection_ids.empty() ? index : get.projection_ids[index];
+		auto &column_index = get.GetColumnIds()[position];
+		if (column_index.IsRowIdColumn()) {
+			return false;
+		}
+		result.column_ids.push_back(column_index.GetPrimaryIndex());
+	}
+	result.scan = &current.get();
+	return true;
+}
+
+// Builds the SELECT a branch contributes to the combined statement, with its columns named as given
+static bool BuildBranchQuery(const SnowflakeSetOperationBranch &branch, const vector<string> &names, string &result) {
+	auto &bind_data = *branch.bind_data;
+	auto &query = bind_data.query;
+	// Orderings, limits and deduplication belong to the branch and would need a subquery to keep their meaning
+	if (!query.order_by.empty() || query.limit.IsValid() || query.distinct || !query.qualify.empty() ||
+	    bind_data.semi_join_keys) {
+		return false;
+	}
+	auto &get = branch.scan->get()->Cast<LogicalGet>();
+	auto predicates = query.predicates;
+	for (auto &entry : get.table_filters.filters) {
+		auto &filter = *entry.second;
+		if (SnowflakeExpressionTranslator::IsOptionalFilter(filter)) {
+			continue;
+		}
+		auto column_id = get.GetColumnIds()[entry.first].GetPrimaryIndex();
+		string sql;
+		if (!bind_data.CanPushFilter(column_id) ||
+		    !SnowflakeExpressionTranslator::TranslateFilter(filter, query.GetColumnExpression(column_id), sql)) {
+			return false;
+		}
+		predicates.push_back(std::move(sql));
+	}
+	vector<string> select_list;
+	for (idx_t i = 0; i < branch.column_ids.size(); i++) {
+		select_list.push_back(query.GetColumnExpression(branch.column_ids[i]) + " AS " +
+		                      SnowflakeQueryBuilder::QuoteIdentifier(names[i]));
+	}
+	result = "SELECT " + StringUtil::Join(select_list, ", ") + " FROM " + query.GetRelation();
+	if (!predicates.empty()) {
+		result += " WHERE " + StringUtil::Join(predicates, " AND ");
+	}
+	return true;
+}
+
+unique_ptr<LogicalOperator> SnowflakeSetOperationPushdown::TryPushdown(LogicalSetOperation &set_operation) {
+	// Snowflake has no INTERSECT ALL or EXCEPT ALL
+	string keyword;
+	switch (set_operation.type) {
+	case LogicalOperatorType::LOGICAL_UNION:
+		keyword = set_operation.setop_all ? "UNION ALL" : "UNION";
+		break;
+	case LogicalOperatorType::LOGICAL_INTERSECT:
+		keyword = set_operation.setop_all ? string() : "INTERSECT";
+		break;
+	case LogicalOperatorType::LOGICAL_EXCEPT:
+		keyword = set_operation.setop_all ? string() : "EXCEPT";
+		break;
+	default:
+		break;
+	}
+	if (keyword.empty() || set_operation.children.size() < 2) {
+		return nullptr;
+	}
+	set_operation.ResolveOperatorTypes();
+	auto &types = set_operation.types;
+
+	vector<SnowflakeSetOperationBranch> branches;
+	for (auto &child : set_operation.children) {
+		SnowflakeSetOperationBranch branch;
+		if (!ResolveBranch(child, types.size(), branch)) {
+			return nullptr;
+		}
+		// All branches must run on the same Snowflake connection
+		if (!branches.empty() && branch.bind_data->factory->connection != branches[0].bind_data->factory->connection) {
+			return nullptr;
+		}
+		for (idx_t i = 0; i < types.size(); i++) {
+			auto &type = branch.bind_data->all_types[branch.column_ids[i]];
+			if (type != types[i]) {
+				return nullptr;
+			}
+			// DuckDB and Snowflake compare semi-structured values and collated strings differently, so only UNION
+			// ALL, which compares nothing, may carry them; strings can be collated on either side
+			if (!set_operation.setop_all &&
+			    (type.IsJSONType() || type.IsNested() || SnowflakeOptimizer::IsCollated(type) ||
+			     branch.bind_data->IsCollated(branch.column_ids[i]))) {
+				return nullptr;
+			}
+		}
+		branches.push_back(std::move(branch));
+	}
+
+	// Columns take the names of the first branch, made unique
+	vector<string> names;
+	case_insensitive_set_t used_names;
+	for (auto column_id : branches[0].column_ids) {
+		auto name = branches[0].bind_data->query.GetColumnName(column_id);
+		for (idx_t suffix = 1; used_names.find(name) != used_names.end(); suffix++) {
+			name = branches[0].bind_data->query.GetColumnName(column_id) + "_" + to_string(suffix);
+		}
+		used_names.insert(name);
+		names.push_back(std::move(name));
+	}
+	vector<string> branch_queries;
+	for (auto &branch : branches) {
+		string branch_query;
+		if (!BuildBranchQuery(branch, names, branch_query)) {
+			return nullptr;
+		}
+		branch_queries.push_back("(" + branch_query + ")");
+	}
+	auto query = StringUtil::Join(branch_queries, " " + keyword + " ");
+
+	// Every branch returns the types the plan expects, so the combined statement needs no schema from Snowflake
+	auto &connection = branches[0].bind_data->factory->connection;
+	auto bind_data = make_uniq<SnowflakeScanBindData>(make_uniq<SnowflakeArrowStreamFactory>(connection, query));
+	bind_data->query.source = "(" + query + ")";
+	bind_data->query.column_names = names;
+	bind_data->all_types = types;
+	// Filters on a column can be sent along if every branch ships it as is
+	for (idx_t i = 0; i < types.size(); i++) {
+		shared_ptr<ArrowType> arrow_type;
+		for (auto &branch : branches) {
+			auto &arrow_columns = branch.bind_data->arrow_table.GetColumns();
+			auto arrow_column = arrow_columns.find(branch.column_ids[i]);
+			if (arrow_column == arrow_columns.end() || arrow_column->second->GetDuckType() != types[i]) {
+				arrow_type = nullptr;
+				break;
+			}
+			arrow_type = arrow_column->second;
+		}
+		if (arrow_type) {
+			bind_data->arrow_table.AddColumn(i, std::move(arrow_type));
+		}
+	}
+
+	idx_t cardinality = 0;
+	for (idx_t i = 0; i < set_operation.children.size(); i++) {
+		auto child_cardinality = set_operation.children[i]->EstimateCardinality(context);
+		if (set_operation.type == LogicalOperatorType::LOGICAL_UNION) {
+			cardinality += child_cardinality;
+		} else if (i == 0 || set_operation.type == LogicalOperatorType::LOGICAL_INTERSECT) {
+			cardinality = i == 0 ? child_cardinality : MinValue(cardinality, child_cardinality);
+		}
+	}
+	bind_data->estimated_cardinality = cardinality;
+	DPRINT("SnowflakeSetOperationPushdown: pushing %s\n", query.c_str());
+
+	// The first branch's scan becomes the scan of the combined statement
+	auto scan = std::move(*branches[0].scan);
+	auto &get = scan->Cast<LogicalGet>();
+	get.bind_data = std::move(bind_data);
+	get.returned_types = types;
+	get.names = names;
+	get.projection_ids.clear();
+	get.table_filters = TableFilterSet();
+	auto &column_ids = get.GetMutableColumnIds();
+	column_ids.clear();
+	vector<unique_ptr<Expression>> expressions;
+	for (idx_t i = 0; i < types.size(); i++) {
+		column_ids.emplace_back(i);
+		expressions.push_back(
+		    make_uniq<BoundColumnRefExpression>(names[i], types[i], ColumnBinding(get.table_index, i)));
+	}
+	get.has_estimated_cardinality = true;
+	get.estimated_cardinality = cardinality;
+
+	// A projection under the set operation's table index keeps the bindings of the operators above valid
+	auto projection = make_uniq<LogicalProjection>(set_operation.table_index, std::move(expressions));
+	projection->children.push_back(std::move(scan));
+	projection->has_estimated_cardinality = true;
+	projection->estimated_cardinality = cardinality;
+	return std::move(projection);
+}
+
+void SnowflakeSetOperationPushdown::Optimize(unique_ptr<LogicalOperator> &op) {
+	// Bottom-up, so nested set operations are combined into one statement
+	for (auto &child : op->children) {
+		Optimize(child);
+	}
+	switch (op->type) {
+	case LogicalOperatorType::LOGICAL_UNION:
+	case LogicalOperatorType::LOGICAL_INTERSECT:
+	case LogicalOperatorType::LOGICAL_EXCEPT: {
+		auto result = TryPushdown(op->Cast<LogicalSetOperation>());
+		if (result) {
+			op = std::move(result);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
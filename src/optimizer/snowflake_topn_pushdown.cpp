@@ -0,0 +1,160 @@
+#include "optimizer/snowflake_topn_pushdown.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
+#include "optimizer/snowflake_expression_translator.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/planner/operator/logical_order.hpp"
+#include "duckdb/planner/operator/logical_projection.hpp"
+#include "duckdb/planner/operator/logical_top_n.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakeTopNPushdown::SnowflakeTopNPushdown(ClientContext &context) : context(context) {
+}
+
+// Strings are left out because Snowflake collations can order them unlike DuckDB, timestamps because of time zone
+// conversions. Floats sort alike: both systems order NaN above every number, which vector similarity orderings need.
+static bool SortsAlike(const LogicalType &type) {
+	return SnowflakeTableStatistics::HasMinMax(type) || type.id() == LogicalTypeId::FLOAT ||
+	       type.id() == LogicalTypeId::DOUBLE;
+}
+
+optional_ptr<SnowflakeScanBindData> SnowflakeTopNPushdown::TranslateOrders(LogicalOperator &child,
+                                                                           const vector<BoundOrderByNode> &orders,
+                                                                           vector<string> &order_by) {
+	// Only projections may sit between the ordering and the scan
+	vector<reference<LogicalProjection>> projections;
+	reference<LogicalOperator> current = child;
+	while (current.get().type == LogicalOperatorType::LOGICAL_PROJECTION) {
+		projections.push_back(current.get().Cast<LogicalProjection>());
+		current = *current.get().children[0];
+	}
+	auto bind_data = SnowflakeOptimizer::GetScanBindData(current.get());
+	if (!bind_data) {
+		return nullptr;
+	}
+	auto &get = current.get().Cast<LogicalGet>();
+	auto &query = bind_data->query;
+	if (query.limit.IsValid() || !query.order_by.empty()) {
+		return nullptr;
+	}
+
+	optional_ptr<SnowflakeExpressionTranslator> translator;
+	SnowflakeExpressionTranslator::column_resolver_t resolve = [&](const ColumnBinding &binding, string &result) {
+		if (binding.table_index == get.table_index) {
+			auto position =
+			    get.projection_ids.empty() ? binding.column_index : get.projection_ids[binding.column_index];
+			auto &column_index = get.GetColumnIds()[position];
+			if (column_index.IsRowIdColumn()) {
+				return false;
+			}
+			result = query.GetColumnExpression(column_index.GetPrimaryIndex());
+			return true;
+		}
+		for (auto &projection : projections) {
+			if (projection.get().table_index == binding.table_index) {
+				return translator->Translate(*projection.get().expressions[binding.column_index], result);
+			}
+		}
+		return false;
+	};
+	SnowflakeExpressionTranslator expression_translator(resolve);
+	translator = &expression_translator;
+
+	for (auto &order : orders) {
+		// Rows Snowflake sorts differently would end up in a different order, or a top-N would keep other rows
+		if (!SortsAlike(order.expression->return_type)) {
+			return nullptr;
+		}
+		string expression;
+		if (!expression_translator.Translate(*order.expression, expression)) {
+			return nullptr;
+		}
+		// Spell out the NULL order: Snowflake sorts NULLs first for DESC, DuckDB last
+		if (order.type == OrderType::ASCENDING) {
+			expression += " ASC";
+		} else if (order.type == OrderType::DESCENDING) {
+			expression += " DESC";
+		} else {
+			return nullptr;
+		}
+		if (order.null_order == OrderByNullType::NULLS_FIRST) {
+			expression += " NULLS FIRST";
+		} else if (order.null_order == OrderByNullType::NULLS_LAST) {
+			expression += " NULLS LAST";
+		} else {
+			return nullptr;
+		}
+		order_by.push_back(std::move(expression));
+	}
+	return bind_data;
+}
+
+bool SnowflakeTopNPushdown::TryPushdown(LogicalTopN &top_n) {
+	vector<string> order_by;
+	auto bind_data = TranslateOrders(*top_n.children[0], top_n.orders, order_by);
+	if (!bind_data) {
+		return false;
+	}
+	// The limit applies after the filters, so Snowflake has to evaluate all of them
+	reference<LogicalOperator> current = *top_n.children[0];
+	while (current.get().type == LogicalOperatorType::LOGICAL_PROJECTION) {
+		current = *current.get().children[0];
+	}
+	if (!SnowflakeOptimizer::EvaluatesAllFilters(current.get().Cast<LogicalGet>(), *bind_data)) {
+		return false;
+	}
+
+	auto &query = bind_data->query;
+	query.order_by = std::move(order_by);
+	query.limit = top_n.limit + top_n.offset;
+	DPRINT("SnowflakeTopNPushdown: pushed ORDER BY %s LIMIT %llu\n", StringUtil::Join(query.order_by, ", ").c_str(),
+	       (unsigned long long)query.limit.GetIndex());
+	return true;
+}
+
+bool SnowflakeTopNPushdown::TryPushdownOrder(LogicalOrder &order) {
+	// Without insertion order, nothing keeps the rows in the order they arrive in
+	if (!DBConfig::GetConfig(context).options.preserve_insertion_order || !order.projections.empty()) {
+		return false;
+	}
+	vector<string> order_by;
+	auto bind_data = TranslateOrders(*order.children[0], order.orders, order_by);
+	if (!bind_data) {
+		return false;
+	}
+	bind_data->query.order_by = std::move(order_by);
+	DPRINT("SnowflakeTopNPushdown: pushed ORDER BY %s, dropping the local sort\n",
+	       StringUtil::Join(bind_data->query.order_by, ", ").c_str());
+	return true;
+}
+
+void SnowflakeTopNPushdown::Optimize(unique_ptr<LogicalOperator> &op) {
+	Optimize(op, true);
+}
+
+void SnowflakeTopNPushdown::Optimize(unique_ptr<LogicalOperator> &op, bool ordered_output) {
+	if (op->type == LogicalOperatorType::LOGICAL_TOP_N) {
+		TryPushdown(op->Cast<LogicalTopN>());
+	} else if (op->type == LogicalOperatorType::LOGICAL_ORDER_BY && ordered_output &&
+	           TryPushdownOrder(op->Cast<LogicalOrder>())) {
+		// The scan delivers its rows sorted and the plan keeps them in that order by batch index
+		op = std::move(op->children[0]);
+		Optimize(op, false);
+		return;
+	}
+	// Only the order of the query result, or of the rows a LIMIT picks from, is kept by the operators above; other
+	// sorts may feed operators that rely on them differently, e.g. windows or ordered aggregates
+	bool children_ordered = (ordered_output && op->type == LogicalOperatorType::LOGICAL_PROJECTION) ||
+	                        op->type == LogicalOperatorType::LOGICAL_LIMIT;
+	for (auto &child : op->children) {
+		Optimize(child, children_ordered);
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
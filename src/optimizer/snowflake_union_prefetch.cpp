@@ -0,0 +1,132 @@
+#include "optimizer/snowflake_union_prefetch.hpp"
+#include "optimizer/snowflake_expression_translator.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/planner/operator/logical_set_operation.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+static bool IsUnionAll(LogicalOperator &op) {
+	return op.type == LogicalOperatorType::LOGICAL_UNION && op.Cast<LogicalSetOperation>().setop_all;
+}
+
+// Follows a branch through projections and filters down to a Snowflake scan that sends a query of its own
+static optional_ptr<LogicalGet> GetBranchScan(LogicalOperator &branch) {
+	reference<LogicalOperator> current = branch;
+	while (current.get().type == LogicalOperatorType::LOGICAL_PROJECTION ||
+	       current.get().type == LogicalOperatorType::LOGICAL_FILTER) {
+		current = *current.get().children[0];
+	}
+	auto bind_data = SnowflakeOptimizer::GetScanBindData(current.get());
+	// Semi-join queries depend on the keys collected at run time, spooled scans may replay another's result, and
+	// scans recording their snapshot need the ID of a query they run themselves
+	if (!bind_data || bind_data->semi_join_keys || bind_data->spool || bind_data->record_snapshot) {
+		return nullptr;
+	}
+	return &current.get().Cast<LogicalGet>();
+}
+
+// The query the scan sends when it starts, with the filters it evaluates in Snowflake. A scan whose query turns out
+// different at run time runs it itself.
+static string GetScanQuery(LogicalGet &get, const SnowflakeScanBindData &bind_data) {
+	vector<column_t> column_ids;
+	for (auto &column_index : get.GetColumnIds()) {
+		column_ids.push_back(column_index.GetPrimaryIndex());
+	}
+	vector<string> predicates;
+	for (auto &entry : get.table_filters.filters) {
+		auto &filter = *entry.second;
+		if (SnowflakeExpressionTranslator::IsOptionalFilter(filter)) {
+			continue;
+		}
+		auto column_id = column_ids[entry.first];
+		string sql;
+		if (!bind_data.CanPushFilter(column_id)) {
+			continue;
+		}
+		auto column = bind_data.query.GetColumnExpression(column_id);
+		if (SnowflakeExpressionTranslator::TranslateFilter(filter, column, sql)) {
+			predicates.push_back(std::move(sql));
+		}
+	}
+	return bind_data.query.Build(column_ids, predicates);
+}
+
+void SnowflakeUnionPrefetch::CollectBranches(unique_ptr<LogicalOperator> &op,
+                                             vector<reference<unique_ptr<LogicalOperator>>> &branches) {
+	if (!IsUnionAll(*op)) {
+		branches.push_back(op);
+		return;
+	}
+	for (auto &child : op->children) {
+		CollectBranches(child, branches);
+	}
+}
+
+// Whether the operator reads its whole input before producing a row, so a limit above it does not stop the input
+// early
+static bool ConsumesInput(LogicalOperator &op) {
+	switch (op.type) {
+	case LogicalOperatorType::LOGICAL_AGGREGATE_AND_GROUP_BY:
+	case LogicalOperatorType::LOGICAL_ORDER_BY:
+	case LogicalOperatorType::LOGICAL_WINDOW:
+	case LogicalOperatorType::LOGICAL_DISTINCT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void SnowflakeUnionPrefetch::Optimize(unique_ptr<LogicalOperator> &op) {
+	Optimize(op, false);
+}
+
+void SnowflakeUnionPrefetch::Optimize(unique_ptr<LogicalOperator> &op, bool limited) {
+	if (op->type == LogicalOperatorType::LOGICAL_LIMIT || op->type == LogicalOperatorType::LOGICAL_TOP_N) {
+		limited = true;
+	} else if (ConsumesInput(*op)) {
+		limited = false;
+	}
+	// Under a LIMIT, the later branches may never be read; executing them ahead would only cost warehouse time
+	if (!IsUnionAll(*op) || limited) {
+		for (auto &child : op->children) {
+			Optimize(child, limited);
+		}
+		return;
+	}
+	vector<reference<unique_ptr<LogicalOperator>>> branches;
+	CollectBranches(op, branches);
+
+	// Queries are executed ahead on the connection of their scan, so branches are grouped by connection
+	unordered_map<SnowflakeClient *, vector<reference<SnowflakeScanBindData>>> scans;
+	unordered_map<SnowflakeClient *, vector<string>> queries;
+	for (auto &branch : branches) {
+		auto get = GetBranchScan(*branch.get());
+		if (!get) {
+			continue;
+		}
+		auto &bind_data = get->bind_data->Cast<SnowflakeScanBindData>();
+		auto connection = bind_data.factory->connection.get();
+		scans[connection].push_back(bind_data);
+		queries[connection].push_back(GetScanQuery(*get, bind_data));
+	}
+	for (auto &entry : scans) {
+		if (entry.second.size() < 2) {
+			continue;
+		}
+		DPRINT("SnowflakeUnionPrefetch: %zu branches can be executed ahead\n", entry.second.size() - 1);
+		for (auto &bind_data : entry.second) {
+			bind_data.get().prefetch_queries = queries[entry.first];
+		}
+	}
+
+	for (auto &branch : branches) {
+		Optimize(branch.get(), limited);
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
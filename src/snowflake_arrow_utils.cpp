@@ -29,6 +29,17 @@ unique_ptr<ArrowArrayStreamWrapper> SnowflakeProduceArrowScan(uintptr_t factory_
 	DPRINT("SnowflakeProduceArrowScan: factory=%p, statement_initialized=%d\n", (void *)factory,
 	       factory->statement_initialized);
 
+	// A tracked statement stays locked until its query ID has been read
+	unique_lock<mutex> tracked_guard;
+	AdbcConnection *adbc_connection;
+	if (factory->track_query_id) {
+		adbc_connection = factory->connection->GetTrackedConnection(tracked_guard);
+	} else if (factory->pooled_connection) {
+		adbc_connection = factory->pooled_connection;
+	} else {
+		adbc_connection = factory->connection->GetConnection();
+	}
+
 	// Initialize ADBC statement if not already done
 	// We defer this to the produce function to avoid executing the query during bind
 	if (!factory->statement_initialized) {
@@ -36,7 +47,7 @@ unique_ptr<ArrowArrayStreamWrapper> SnowflakeProduceArrowScan(uintptr_t factory_
 		std::memset(&error, 0, sizeof(error));
 
 		// Create a new ADBC statement from the connection
-		AdbcStatusCode status = AdbcStatementNew(factory->connection->GetConnection(), &factory->statement, &error);
+		AdbcStatusCode status = AdbcStatementNew(adbc_connection, &factory->statement, &error);
 		DPRINT("Statement created at %p for factory %p\n", (void *)&factory->statement, (void *)factory);
 		if (status != ADBC_STATUS_OK) {
 			throw IOException("Failed to create statement");
@@ -82,6 +93,10 @@ unique_ptr<ArrowArrayStreamWrapper> SnowflakeProduceArrowScan(uintptr_t factory_
 	// This ensures zero-copy data transfer from Snowflake to DuckDB
 	wrapper->InitializeFromADBC(&adbc_stream);
 	wrapper->number_of_rows = rows_affected;
+	if (factory->track_query_id) {
+		factory->query_id = factory->connection->GetLastQueryId();
+		DPRINT("SnowflakeProduceArrowScan: query ID %s\n", factory->query_id.c_str());
+	}
 
 	return std::move(wrapper);
 }
@@ -37,6 +37,7 @@ static std::string GetExtensionDirectory() {
 SnowflakeClient::SnowflakeClient() {
 	std::memset(&database, 0, sizeof(database));
 	std::memset(&connection, 0, sizeof(connection));
+	std::memset(&tracked_connection, 0, sizeof(tracked_connection));
 }
 
 SnowflakeClient::~SnowflakeClient() {
@@ -50,7 +51,7 @@ void SnowflakeClient::Connect(const SnowflakeConfig &config) {
 
 	this->config = config;
 	InitializeDatabase(config);
-	InitializeConnection();
+	InitializeConnection(connection);
 	connected = true;
 }
 
@@ -66,6 +67,22 @@ void SnowflakeClient::Disconnect() {
 	status = AdbcConnectionRelease(&connection, &error);
 	CheckError(status, "Failed to release ADBC connection", &error);
 
+	if (tracked_connected) {
+		status = AdbcConnectionRelease(&tracked_connection, &error);
+		CheckError(status, "Failed to release ADBC connection", &error);
+		tracked_connected = false;
+	}
+
+	{
+		lock_guard<mutex> guard(pool_lock);
+		for (auto &pooled_connection : pooled_connections) {
+			status = AdbcConnectionRelease(pooled_connection.get(), &error);
+			CheckError(status, "Failed to release ADBC connection", &error);
+		}
+		pooled_connections.clear();
+		idle_connections.clear();
+	}
+
 	status = AdbcDatabaseRelease(&database, &error);
 	CheckError(status, "Failed to release ADBC database", &error);
 
@@ -175,13 +192,50 @@ void SnowflakeClient::InitializeDatabase(const SnowflakeConfig &config) {
 	CheckError(status, "Failed to initialize database", &error);
 }
 
-void SnowflakeClient::InitializeConnection() {
+AdbcConnection *SnowflakeClient::GetTrackedConnection(unique_lock<mutex> &guard) {
+	guard = unique_lock<mutex>(tracked_lock);
+	if (!tracked_connected) {
+		InitializeConnection(tracked_connection);
+		tracked_connected = true;
+	}
+	return &tracked_connection;
+}
+
+string SnowflakeClient::GetLastQueryId() {
+	auto result = ExecuteAndGetStrings(tracked_connection, "SELECT LAST_QUERY_ID()", {});
+	if (result.empty() || result[0].empty()) {
+		return string();
+	}
+	return result[0][0];
+}
+
+AdbcConnection *SnowflakeClient::AcquirePooledConnection() {
+	lock_guard<mutex> guard(pool_lock);
+	if (!idle_connections.empty()) {
+		auto adbc_connection = idle_connections.back();
+		idle_connections.pop_back();
+		return adbc_connection;
+	}
+	auto adbc_connection = make_uniq<AdbcConnection>();
+	std::memset(adbc_connection.get(), 0, sizeof(AdbcConnection));
+	InitializeConnection(*adbc_connection);
+	pooled_connections.push_back(std::move(adbc_connection));
+	DPRINT("SnowflakeClient: opened pooled connection %zu\n", pooled_connections.size());
+	return pooled_connections.back().get();
+}
+
+void SnowflakeClient::ReleasePooledConnection(AdbcConnection *adbc_connection) {
+	lock_guard<mutex> guard(pool_lock);
+	idle_connections.push_back(adbc_connection);
+}
+
+void SnowflakeClient::InitializeConnection(AdbcConnection &adbc_connection) {
 	AdbcError error;
 	std::memset(&error, 0, sizeof(error));
-	AdbcStatusCode status = AdbcConnectionNew(&connection, &error);
+	AdbcStatusCode status = AdbcConnectionNew(&adbc_connection, &error);
 	CheckError(status, "Failed to create connection", &error);
 
-	status = AdbcConnectionInit(&connection, &database, &error);
+	status = AdbcConnectionInit(&adbc_connection, &database, &error);
 	CheckError(status, "Failed to initialize connection", &error);
 }
 
@@ -232,25 +286,88 @@ vector<string> SnowflakeClient::ListSchemas(ClientContext &context) {
 	return schemas;
 }
 
-vector<string> SnowflakeClient::ListTables(ClientContext &context, const string &schema = "") {
+// Fixed format, so LAST_ALTERED values can be compared as text regardless of session settings
+static const char *LAST_ALTERED_SQL = "TO_VARCHAR(last_altered, 'YYYY-MM-DD HH24:MI:SS.FF9 TZH:TZM')";
+
+static optional_idx ParseTableSize(const string &value) {
+	if (value.empty()) {
+		return optional_idx();
+	}
+	return optional_idx(std::stoull(value));
+}
+
+vector<SnowflakeTableMetadata> SnowflakeClient::ListTables(ClientContext &context, const string &schema = "") {
 	DPRINT("ListTables called for schema: %s in database: %s\n", schema.c_str(), config.database.c_str());
 	const string upper_schema = StringUtil::Upper(schema);
-	const string table_name_query = "SELECT table_name FROM " + config.database + ".information_schema.tables" +
+	const string table_name_query = "SELECT table_name, TO_VARCHAR(row_count), TO_VARCHAR(bytes), " +
+	                                string(LAST_ALTERED_SQL) + ", table_type FROM " + config.database +
+	                                ".information_schema.tables" +
 	                                (schema != "" ? " WHERE table_schema = '" + upper_schema + "'" : "");
 	DPRINT("Table query: %s\n", table_name_query.c_str());
 
-	auto result = ExecuteAndGetStrings(context, table_name_query, {"table_name"});
-	auto table_names = result[0];
+	auto result = ExecuteAndGetStrings(context, table_name_query, {});
+	vector<SnowflakeTableMetadata> tables;
+	if (result.size() < 5) {
+		return tables;
+	}
+	for (idx_t row_idx = 0; row_idx < result[0].size(); row_idx++) {
+		SnowflakeTableMetadata table;
+		table.name = StringUtil::Lower(result[0][row_idx]);
+		table.row_count = ParseTableSize(result[1][row_idx]);
+		table.bytes = ParseTableSize(result[2][row_idx]);
+		table.last_altered = result[3][row_idx];
+		table.table_type = result[4][row_idx];
+		tables.push_back(std::move(table));
+	}
 
-	for (auto &table_name : table_names) {
-		table_name = StringUtil::Lower(table_name);
+	DPRINT("ListTables returning %zu tables\n", tables.size());
+	for (const auto &table : tables) {
+		DPRINT("Found table: %s\n", table.name.c_str());
 	}
+	return tables;
+}
 
-	DPRINT("ListTables returning %zu tables\n", table_names.size());
-	for (const auto &table_name : table_names) {
-		DPRINT("Found table: %s\n", table_name.c_str());
+string SnowflakeClient::GetLastAltered(ClientContext &context, const string &schema, const string &table_name) {
+	if (!connected) {
+		throw IOException("Connection must be created before GetLastAltered is called");
 	}
-	return table_names;
+	return GetLastAltered(connection, schema, table_name);
+}
+
+string SnowflakeClient::GetLastAltered(AdbcConnection &adbc_connection, const string &schema,
+                                       const string &table_name) {
+	const string query = "SELECT " + string(LAST_ALTERED_SQL) + " FROM " + config.database +
+	                     ".information_schema.tables WHERE table_schema = '" + StringUtil::Upper(schema) +
+	                     "' AND table_name = '" + StringUtil::Upper(table_name) + "'";
+	auto result = ExecuteAndGetStrings(adbc_connection, query, {});
+	if (result.empty() || result[0].empty()) {
+		throw CatalogException("Table '%s.%s' no longer exists in Snowflake", schema, table_name);
+	}
+	return result[0][0];
+}
+
+bool SnowflakeClient::HasChangeTracking(ClientContext &context, const string &schema, const string &table_name) {
+	// INFORMATION_SCHEMA does not show change tracking; SHOW TABLES does, among non-string columns
+	const string query = "SHOW TABLES LIKE '" + table_name + "' IN SCHEMA " + config.database + "." + schema +
+	                     " ->> SELECT \"change_tracking\" FROM $1 WHERE \"name\" = '" + StringUtil::Upper(table_name) +
+	                     "'";
+	auto result = ExecuteAndGetStrings(context, query, {});
+	if (result.empty() || result[0].empty()) {
+		throw CatalogException("Table '%s.%s' does not exist in Snowflake or is not a table", schema, table_name);
+	}
+	return StringUtil::CIEquals(result[0][0], "ON");
+}
+
+vector<string> SnowflakeClient::GetPrimaryKey(ClientContext &context, const string &schema,
+                                             const string &table_name) {
+	// SHOW returns non-string columns as well, so its result is narrowed down to the key columns in a pipe
+	const string query = "SHOW PRIMARY KEYS IN TABLE " + config.database + "." + schema + "." + table_name +
+	                     " ->> SELECT \"column_name\" FROM $1 ORDER BY \"key_sequence\"";
+	auto result = ExecuteAndGetStrings(context, query, {});
+	if (result.empty()) {
+		return vector<string>();
+	}
+	return result[0];
 }
 
 vector<SnowflakeColumn> SnowflakeClient::GetTableInfo(ClientContext &context, const string &schema,
@@ -258,12 +375,13 @@ vector<SnowflakeColumn> SnowflakeClient::GetTableInfo(ClientContext &context, co
 	const string upper_schema = StringUtil::Upper(schema);
 	const string upper_table = StringUtil::Upper(table_name);
 
-	const string table_info_query = "SELECT COLUMN_NAME, DATA_TYPE, IS_NULLABLE FROM " + config.database +
-	                                ".information_schema.columns WHERE table_schema = '" + upper_schema +
-	                                "' AND table_name = '" + upper_table + "' ORDER BY ORDINAL_POSITION";
+	const string table_info_query = "SELECT COLUMN_NAME, DATA_TYPE, IS_NULLABLE, COLLATION_NAME FROM " +
+	                                config.database + ".information_schema.columns WHERE table_schema = '" +
+	                                upper_schema + "' AND table_name = '" + upper_table +
+	                                "' ORDER BY ORDINAL_POSITION";
 
 	DPRINT("GetTableInfo query: %s\n", table_info_query.c_str());
-	const vector<string> expected_names = {"COLUMN_NAME", "DATA_TYPE", "IS_NULLABLE"};
+	const vector<string> expected_names = {"COLUMN_NAME", "DATA_TYPE", "IS_NULLABLE", "COLLATION_NAME"};
 
 	auto result = ExecuteAndGetStrings(context, table_info_query, expected_names);
 
@@ -283,7 +401,7 @@ vector<SnowflakeColumn> SnowflakeClient::GetTableInfo(ClientContext &context, co
 		bool is_nullable = (nullable == "YES");
 		LogicalType duckdb_type = SnowflakeTypeToLogicalType(data_type);
 
-		SnowflakeColumn new_col = {column_name, duckdb_type, is_nullable};
+		SnowflakeColumn new_col = {column_name, duckdb_type, is_nullable, result[3][row_idx]};
 		col_data.emplace_back(new_col);
 	}
 
@@ -295,7 +413,50 @@ vector<vector<string>> SnowflakeClient::ExecuteAndGetStrings(ClientContext &cont
 	if (!connected) {
 		throw IOException("Connection must be created before ListTables is called");
 	}
+	return ExecuteAndGetStrings(connection, query, expected_col_names);
+}
 
+void SnowflakeClient::Ingest(const string &table_name, ArrowArrayStream &stream) {
+	if (!connected) {
+		if (stream.release) {
+			stream.release(&stream);
+		}
+		throw IOException("Connection must be created before Ingest is called");
+	}
+	AdbcStatement statement;
+	std::memset(&statement, 0, sizeof(statement));
+	AdbcError error;
+	std::memset(&error, 0, sizeof(error));
+
+	DPRINT("Ingest: Table='%s'\n", table_name.c_str());
+	auto status = AdbcStatementNew(&connection, &statement, &error);
+	if (status != ADBC_STATUS_OK && stream.release) {
+		stream.release(&stream);
+	}
+	CheckError(status, "Failed to create AdbcStatement", &error);
+	try {
+		status = AdbcStatementSetOption(&statement, ADBC_INGEST_OPTION_TARGET_TABLE, table_name.c_str(), &error);
+		CheckError(status, "Failed to set ingestion target table " + table_name, &error);
+		status = AdbcStatementSetOption(&statement, ADBC_INGEST_OPTION_MODE, ADBC_INGEST_OPTION_MODE_APPEND, &error);
+		CheckError(status, "Failed to set ingestion mode", &error);
+		status = AdbcStatementBindStream(&statement, &stream, &error);
+		CheckError(status, "Failed to bind the ingested stream", &error);
+		int64_t rows_affected = -1;
+		status = AdbcStatementExecuteQuery(&statement, nullptr, &rows_affected, &error);
+		CheckError(status, "Failed to ingest into " + table_name, &error);
+		DPRINT("Ingest: %lld rows\n", (long long)rows_affected);
+	} catch (...) {
+		if (stream.release) {
+			stream.release(&stream);
+		}
+		AdbcStatementRelease(&statement, &error);
+		throw;
+	}
+	CheckError(AdbcStatementRelease(&statement, &error), "Failed to release AdbcStatement", &error);
+}
+
+vector<vector<string>> SnowflakeClient::ExecuteAndGetStrings(AdbcConnection &adbc_connection, const string &query,
+                                                             const vector<string> &expected_col_names) {
 	AdbcStatement statement;
 	std::memset(&statement, 0, sizeof(statement));
 	AdbcError error;
@@ -304,7 +465,7 @@ vector<vector<string>> SnowflakeClient::ExecuteAndGetStrings(ClientContext &cont
 
 	DPRINT("ExecuteAndGetStrings: Query='%s'\n", query.c_str());
 	DPRINT("About to create statement...\n");
-	status = AdbcStatementNew(GetConnection(), &statement, &error);
+	status = AdbcStatementNew(&adbc_connection, &statement, &error);
 	CheckError(status, "Failed to create AdbcStatement", &error);
 	DPRINT("Statement created successfully\n");
 
@@ -0,0 +1,262 @@
+#include "snowflake_decoder.hpp"
+#include "duckdb/common/types/vector_buffer.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+namespace snowflake {
+
+// Keeps a record batch alive for as long as a vector references its string data
+class SnowflakeBatchBuffer : public VectorBuffer {
+public:
+	explicit SnowflakeBatchBuffer(shared_ptr<ArrowArrayWrapper> batch_p)
+	    : VectorBuffer(VectorBufferType::OPAQUE_BUFFER), batch(std::move(batch_p)) {
+	}
+
+private:
+	shared_ptr<ArrowArrayWrapper> batch;
+};
+
+SnowflakeDecoderKind GetSnowflakeDecoderKind(const ArrowSchema &schema, const LogicalType &type) {
+	if (schema.dictionary || !schema.format) {
+		return SnowflakeDecoderKind::GENERIC;
+	}
+	const string format(schema.format);
+	switch (type.id()) {
+	case LogicalTypeId::TINYINT:
+		return format == "c" ? SnowflakeDecoderKind::INT8 : SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::SMALLINT:
+		return format == "s" ? SnowflakeDecoderKind::INT16 : SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::INTEGER:
+		return format == "i" ? SnowflakeDecoderKind::INT32 : SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::DATE:
+		// date32 and DuckDB's date_t both count days since the epoch
+		return format == "tdD" ? SnowflakeDecoderKind::INT32 : SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::BIGINT:
+		return format == "l" ? SnowflakeDecoderKind::INT64 : SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::TIME:
+		return format == "ttu" ? SnowflakeDecoderKind::INT64 : SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::TIMESTAMP:
+	case LogicalTypeId::TIMESTAMP_TZ:
+		// Microsecond timestamps share DuckDB's representation, with or without a time zone
+		return StringUtil::StartsWith(format, "tsu:") ? SnowflakeDecoderKind::INT64 : SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::TIMESTAMP_NS:
+		return format == "tsn:" ? SnowflakeDecoderKind::INT64 : SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::FLOAT:
+		return format == "f" ? SnowflakeDecoderKind::FLOAT : SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::DOUBLE:
+		return format == "g" ? SnowflakeDecoderKind::DOUBLE : SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::BOOLEAN:
+		return format == "b" ? SnowflakeDecoderKind::BOOLEAN : SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::VARCHAR:
+	case LogicalTypeId::BLOB:
+		if (format == "u" || format == "z") {
+			return SnowflakeDecoderKind::UTF8;
+		}
+		if (format == "U" || format == "Z") {
+			return SnowflakeDecoderKind::LARGE_UTF8;
+		}
+		return SnowflakeDecoderKind::GENERIC;
+	case LogicalTypeId::ARRAY: {
+		if (!StringUtil::StartsWith(format, "+w:") || schema.n_children != 1 || !schema.children[0]->format ||
+		    schema.children[0]->dictionary) {
+			return SnowflakeDecoderKind::GENERIC;
+		}
+		const string child_format(schema.children[0]->format);
+		auto &child_type = ArrayType::GetChildType(type);
+		if (child_format == "f" && child_type.id() == LogicalTypeId::FLOAT) {
+			return SnowflakeDecoderKind::FLOAT_ARRAY;
+		}
+		if (child_format == "i" && child_type.id() == LogicalTypeId::INTEGER) {
+			return SnowflakeDecoderKind::INT32_ARRAY;
+		}
+		return SnowflakeDecoderKind::GENERIC;
+	}
+	default:
+		return SnowflakeDecoderKind::GENERIC;
+	}
+}
+
+void SnowflakeBatchAligner::EmitPending(std::deque<SnowflakeScanUnit> &result) {
+	if (pending.count == 0) {
+		return;
+	}
+	pending.batch_index = next_batch_index++;
+	if (pending.segments.size() == 1) {
+		pending.segments[0].whole_unit = true;
+	}
+	result.push_back(std::move(pending));
+	pending = SnowflakeScanUnit();
+}
+
+void SnowflakeBatchAligner::Append(shared_ptr<ArrowArrayWrapper> batch, std::deque<SnowflakeScanUnit> &result) {
+	auto length = NumericCast<idx_t>(batch->arrow_array.length);
+	idx_t offset = 0;
+	while (offset < length) {
+		auto count = MinValue<idx_t>(length - offset, STANDARD_VECTOR_SIZE - pending.count);
+		pending.segments.push_back(SnowflakeBatchSegment {batch, offset, count, false});
+		pending.count += count;
+		offset += count;
+		if (pending.count == STANDARD_VECTOR_SIZE) {
+			EmitPending(result);
+		}
+	}
+	if (!can_coalesce) {
+		// The tail of the batch cannot be merged with the next batch
+		EmitPending(result);
+	}
+}
+
+void SnowflakeBatchAligner::Finalize(std::deque<SnowflakeScanUnit> &result) {
+	EmitPending(result);
+}
+
+static inline bool ArrowRowIsValid(const uint8_t *validity, idx_t row) {
+	return (validity[row >> 3] >> (row & 7)) & 1;
+}
+
+template <bool HAS_NULLS>
+static void DecodeValidity(const ArrowArray &array, idx_t arrow_offset, Vector &out, idx_t out_offset, idx_t count) {
+	if (!HAS_NULLS) {
+		return;
+	}
+	auto validity = static_cast<const uint8_t *>(array.buffers[0]);
+	auto &result_mask = FlatVector::Validity(out);
+	for (idx_t i = 0; i < count; i++) {
+		if (!ArrowRowIsValid(validity, arrow_offset + i)) {
+			result_mask.SetInvalid(out_offset + i);
+		}
+	}
+}
+
+template <class T, bool HAS_NULLS>
+static void DecodeFixedWidth(const ArrowArray &array, idx_t arrow_offset, Vector &out, idx_t out_offset,
+                             idx_t count) {
+	auto source = static_cast<const T *>(array.buffers[1]) + arrow_offset;
+	auto target = FlatVector::GetData<T>(out) + out_offset;
+	memcpy(target, source, count * sizeof(T));
+	DecodeValidity<HAS_NULLS>(array, arrow_offset, out, out_offset, count);
+}
+
+template <bool HAS_NULLS>
+static void DecodeBoolean(const ArrowArray &array, idx_t arrow_offset, Vector &out, idx_t out_offset, idx_t count) {
+	auto source = static_cast<const uint8_t *>(array.buffers[1]);
+	auto target = FlatVector::GetData<bool>(out) + out_offset;
+	for (idx_t i = 0; i < count; i++) {
+		target[i] = ArrowRowIsValid(source, arrow_offset + i);
+	}
+	DecodeValidity<HAS_NULLS>(array, arrow_offset, out, out_offset, count);
+}
+
+template <class OFFSET_TYPE, bool HAS_NULLS>
+static void DecodeString(const SnowflakeBatchSegment &segment, const ArrowArray &array, idx_t arrow_offset, Vector &out,
+                         idx_t out_offset, idx_t count) {
+	auto validity = static_cast<const uint8_t *>(array.buffers[0]);
+	auto offsets = static_cast<const OFFSET_TYPE *>(array.buffers[1]) + arrow_offset;
+	auto data = static_cast<const char *>(array.buffers[2]);
+	auto target = FlatVector::GetData<string_t>(out) + out_offset;
+	auto &result_mask = FlatVector::Validity(out);
+	for (idx_t i = 0; i < count; i++) {
+		if (HAS_NULLS && !ArrowRowIsValid(validity, arrow_offset + i)) {
+			result_mask.SetInvalid(out_offset + i);
+			continue;
+		}
+		auto length = UnsafeNumericCast<uint32_t>(offsets[i + 1] - offsets[i]);
+		// Long strings point straight into the Arrow buffer; the batch is kept alive below
+		target[i] = string_t(data + offsets[i], length);
+	}
+	StringVector::AddBuffer(out, make_buffer<SnowflakeBatchBuffer>(segment.batch));
+}
+
+template <class T, bool HAS_NULLS>
+static void DecodeFixedSizeList(const SnowflakeBatchSegment &segment, const ArrowArray &array, idx_t arrow_offset,
+                                Vector &out, idx_t out_offset, idx_t count) {
+	auto array_size = ArrayType::GetSize(out.GetType());
+	auto &child_array = *array.children[0];
+	auto source = static_cast<const T *>(child_array.buffers[1]) +
+	              (NumericCast<idx_t>(child_array.offset) + arrow_offset) * array_size;
+	auto &child = ArrayVector::GetEntry(out);
+	bool child_has_nulls = child_array.null_count != 0 && child_array.buffers[0] != nullptr;
+	if (segment.whole_unit && !child_has_nulls) {
+		// The elements already have DuckDB's layout: point the child vector at the batch and keep the batch alive
+		D_ASSERT(out_offset == 0);
+		FlatVector::SetData(child, data_ptr_cast(const_cast<T *>(source)));
+		child.SetAuxiliary(make_buffer<SnowflakeBatchBuffer>(segment.batch));
+	} else {
+		memcpy(FlatVector::GetData<T>(child) + out_offset * array_size, source, count * array_size * sizeof(T));
+		if (child_has_nulls) {
+			auto validity = static_cast<const uint8_t *>(child_array.buffers[0]);
+			auto &child_mask = FlatVector::Validity(child);
+			auto child_arrow_offset = (NumericCast<idx_t>(child_array.offset) + arrow_offset) * array_size;
+			for (idx_t i = 0; i < count * array_size; i++) {
+				if (!ArrowRowIsValid(validity, child_arrow_offset + i)) {
+					child_mask.SetInvalid(out_offset * array_size + i);
+				}
+			}
+		}
+	}
+	DecodeValidity<HAS_NULLS>(array, arrow_offset, out, out_offset, count);
+}
+
+template <bool HAS_NULLS>
+static void DecodeColumnInternal(SnowflakeDecoderKind kind, const SnowflakeBatchSegment &segment,
+                                 const ArrowArray &array, idx_t arrow_offset, Vector &out, idx_t out_offset) {
+	auto count = segment.count;
+	switch (kind) {
+	case SnowflakeDecoderKind::INT8:
+		DecodeFixedWidth<int8_t, HAS_NULLS>(array, arrow_offset, out, out_offset, count);
+		break;
+	case SnowflakeDecoderKind::INT16:
+		DecodeFixedWidth<int16_t, HAS_NULLS>(array, arrow_offset, out, out_offset, count);
+		break;
+	case SnowflakeDecoderKind::INT32:
+		DecodeFixedWidth<int32_t, HAS_NULLS>(array, arrow_offset, out, out_offset, count);
+		break;
+	case SnowflakeDecoderKind::INT64:
+		DecodeFixedWidth<int64_t, HAS_NULLS>(array, arrow_offset, out, out_offset, count);
+		break;
+	case SnowflakeDecoderKind::FLOAT:
+		DecodeFixedWidth<float, HAS_NULLS>(array, arrow_offset, out, out_offset, count);
+		break;
+	case SnowflakeDecoderKind::DOUBLE:
+		DecodeFixedWidth<double, HAS_NULLS>(array, arrow_offset, out, out_offset, count);
+		break;
+	case SnowflakeDecoderKind::BOOLEAN:
+		DecodeBoolean<HAS_NULLS>(array, arrow_offset, out, out_offset, count);
+		break;
+	case SnowflakeDecoderKind::UTF8:
+		DecodeString<int32_t, HAS_NULLS>(segment, array, arrow_offset, out, out_offset, count);
+		break;
+	case SnowflakeDecoderKind::LARGE_UTF8:
+		DecodeString<int64_t, HAS_NULLS>(segment, array, arrow_offset, out, out_offset, count);
+		break;
+	case SnowflakeDecoderKind::FLOAT_ARRAY:
+		DecodeFixedSizeList<float, HAS_NULLS>(segment, array, arrow_offset, out, out_offset, count);
+		break;
+	case SnowflakeDecoderKind::INT32_ARRAY:
+		DecodeFixedSizeList<int32_t, HAS_NULLS>(segment, array, arrow_offset, out, out_offset, count);
+		break;
+	default:
+		throw InternalException("Snowflake column decoder called for a column that requires the generic conversion");
+	}
+}
+
+void SnowflakeDecodeColumn(SnowflakeDecoderKind kind, const SnowflakeBatchSegment &segment, idx_t stream_idx,
+                           Vector &out, idx_t out_offset) {
+	auto &batch = segment.batch->arrow_array;
+	auto &array = *batch.children[stream_idx];
+	auto arrow_offset = NumericCast<idx_t>(batch.offset + array.offset) + segment.offset;
+
+	// A null_count of -1 means "unknown"; only skip validity handling when Snowflake tells us there are no NULLs
+	bool has_nulls = array.null_count != 0 && array.buffers[0] != nullptr;
+	if (has_nulls) {
+		DecodeColumnInternal<true>(kind, segment, array, arrow_offset, out, out_offset);
+	} else {
+		DecodeColumnInternal<false>(kind, segment, array, arrow_offset, out, out_offset);
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
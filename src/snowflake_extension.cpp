@@ -4,6 +4,7 @@
 #include "snowflake_extension.hpp"
 // #include "snowflake_attach.hpp"
 #include "storage/snowflake_storage.hpp"
+#include "optimizer/snowflake_optimizer.hpp"
 #include "duckdb.hpp"
 #include "duckdb/common/exception.hpp"
 #include "duckdb/common/string_util.hpp"
@@ -14,6 +15,7 @@
 #include "duckdb/function/table_function.hpp"
 #include "snowflake_functions.hpp"
 #include "snowflake_secret_provider.hpp"
+#include "snowflake_replicate.hpp"
 
 namespace duckdb {
 
@@ -52,11 +54,131 @@ static void LoadInternal(DatabaseInstance &instance) {
 	auto snowflake_scan_function = GetSnowflakeScanFunction();
 	ExtensionUtil::RegisterFunction(instance, snowflake_scan_function);
 
+	// Register the snowflake_replicate and snowflake_refresh_replica table functions
+	ExtensionUtil::RegisterFunction(instance, GetSnowflakeReplicateFunction());
+	ExtensionUtil::RegisterFunction(instance, GetSnowflakeRefreshReplicaFunction());
+
 	// duckdb::snowflake::SnowflakeAttachFunction snowflake_attach_function;
 	// ExtensionUtil::RegisterFunction(instance, snowflake_attach_function);
 
 	auto &config = DBConfig::GetConfig(instance);
 	config.storage_extensions["snowflake"] = make_uniq<snowflake::SnowflakeStorageExtension>();
+	config.optimizer_extensions.push_back(snowflake::SnowflakeOptimizer::GetExtension());
+
+	// Scan settings
+	config.AddExtensionOption("snowflake_parallel_decode",
+	                          "Pull Snowflake record batches on a dedicated thread and decode them on all threads",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(true));
+	config.AddExtensionOption("snowflake_prefetch_units",
+	                          "Number of fetched vector-sized units buffered ahead of the decoders per Snowflake "
+	                          "scan (NULL: 2x threads)",
+	                          LogicalType::UBIGINT, Value());
+	config.AddExtensionOption("snowflake_union_prefetch",
+	                          "Number of later UNION ALL branches whose Snowflake queries are executed ahead, each "
+	                          "on a pooled connection, while an earlier branch is read (0: one branch after the other)",
+	                          LogicalType::UBIGINT, Value::UBIGINT(0));
+	config.AddExtensionOption("snowflake_scan_spool",
+	                          "Send a Snowflake query the plan runs more than once only once and replay its spooled "
+	                          "result",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(true));
+	config.AddExtensionOption("snowflake_variant_inference_rows",
+	                          "Number of sampled rows used to infer nested types for VARIANT/OBJECT/ARRAY columns "
+	                          "(0: expose them as JSON)",
+	                          LogicalType::UBIGINT, Value::UBIGINT(0));
+
+	// Estimate settings
+	config.AddExtensionOption("snowflake_scan_estimates",
+	                          "Explain snowflake_scan queries at bind time to estimate their result size for the "
+	                          "optimizer",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
+	config.AddExtensionOption("snowflake_max_bytes_scanned",
+	                          "Flag snowflake_scan queries Snowflake estimates to scan more bytes than this (NULL: "
+	                          "no limit)",
+	                          LogicalType::UBIGINT, Value());
+	config.AddExtensionOption("snowflake_max_bytes_scanned_action",
+	                          "What to do with snowflake_scan queries over snowflake_max_bytes_scanned: 'error' or "
+	                          "'warn'",
+	                          LogicalType::VARCHAR, Value("error"));
+
+	// Result cache settings
+	config.AddExtensionOption("snowflake_result_cache",
+	                          "Keep Snowflake query results on disk and serve identical queries from there",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
+	config.AddExtensionOption("snowflake_result_cache_directory",
+	                          "Directory of the Snowflake result cache (empty: ~/.duckdb/snowflake_result_cache)",
+	                          LogicalType::VARCHAR, Value(""));
+	config.AddExtensionOption("snowflake_result_cache_ttl",
+	                          "Seconds a cached Snowflake result is served before it is fetched again",
+	                          LogicalType::UBIGINT, Value::UBIGINT(3600));
+	config.AddExtensionOption("snowflake_result_cache_max_bytes",
+	                          "Total size of the Snowflake result cache; least recently used results are evicted "
+	                          "beyond it",
+	                          LogicalType::UBIGINT, Value::UBIGINT(1ULL << 30));
+
+	// Semantic cache settings
+	config.AddExtensionOption("snowflake_semantic_cache",
+	                          "Keep columns of attached Snowflake tables in memory and answer scans with implied "
+	                          "filters from there",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
+	config.AddExtensionOption("snowflake_semantic_cache_ttl",
+	                          "Seconds cached Snowflake table columns are used before they are fetched again",
+	                          LogicalType::UBIGINT, Value::UBIGINT(3600));
+	config.AddExtensionOption("snowflake_semantic_cache_max_bytes",
+	                          "Memory used by the Snowflake semantic cache; least recently used entries are evicted "
+	                          "beyond it",
+	                          LogicalType::UBIGINT, Value::UBIGINT(256ULL << 20));
+
+	// Shared scan settings
+	config.AddExtensionOption("snowflake_shared_scans",
+	                          "Let identical Snowflake queries running at the same time share one execution",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
+	config.AddExtensionOption("snowflake_shared_scan_max_rows",
+	                          "Rows of a shared Snowflake query buffered for consumers joining late; beyond it no "
+	                          "consumers can join",
+	                          LogicalType::UBIGINT, Value::UBIGINT(1000000));
+
+	// Statistics settings
+	config.AddExtensionOption("snowflake_statistics",
+	                          "Gather column statistics of attached Snowflake tables with one aggregate query per "
+	                          "table, for filter pruning and join planning",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
+	config.AddExtensionOption("snowflake_scan_statistics",
+	                          "Learn column statistics of attached Snowflake tables from the rows of scans that read "
+	                          "the whole table",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
+	config.AddExtensionOption("snowflake_statistics_ttl",
+	                          "Seconds Snowflake row counts are used before LAST_ALTERED is checked, and before a "
+	                          "failed statistics query is retried",
+	                          LogicalType::UBIGINT, Value::UBIGINT(300));
+
+	// Result reuse settings
+	config.AddExtensionOption("snowflake_result_reuse",
+	                          "Read repeated attached-table scans from Snowflake's stored result with RESULT_SCAN "
+	                          "while the table is unchanged",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
+	config.AddExtensionOption("snowflake_result_reuse_window",
+	                          "Seconds a stored Snowflake result is reused (at most 86400, Snowflake's retention)",
+	                          LogicalType::UBIGINT, Value::UBIGINT(3600));
+
+	// Semi-join settings
+	config.AddExtensionOption("snowflake_semi_join_pushdown",
+	                          "Restrict Snowflake scans probing a join to the keys of the much smaller local side, "
+	                          "shipping them as a temporary table if needed",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
+	config.AddExtensionOption("snowflake_semi_join_ratio",
+	                          "How many times more rows the Snowflake side of a join must be estimated to have than "
+	                          "the local side for a semi-join pushdown",
+	                          LogicalType::UBIGINT, Value::UBIGINT(100));
+	config.AddExtensionOption("snowflake_semi_join_max_keys",
+	                          "Most distinct local join keys shipped to Snowflake; with more, the scan runs without "
+	                          "them",
+	                          LogicalType::UBIGINT, Value::UBIGINT(10000000));
+
+	// Late materialization settings
+	config.AddExtensionOption("snowflake_late_materialization",
+	                          "Split filtered scans of attached tables with a primary key into a scan of the key and "
+	                          "filtered columns and a lookup of the remaining columns for the surviving keys",
+	                          LogicalType::BOOLEAN, Value::BOOLEAN(false));
 }
 
 void SnowflakeExtension::Load(DuckDB &db) {
@@ -0,0 +1,649 @@
+#include "snowflake_json.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/operator/cast_operators.hpp"
+#include "duckdb/common/types/vector.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+namespace {
+
+// Values nested deeper than this are inferred as JSON, so hostile documents cannot exhaust the stack
+static constexpr idx_t MAX_INFERENCE_DEPTH = 32;
+// Objects with more distinct keys than this across the samples are inferred as a MAP, not a STRUCT
+static constexpr idx_t MAX_INFERRED_FIELDS = 256;
+
+//! Shape of the sampled JSON values at one position of the document tree, used for type inference
+struct JSONShape {
+	enum class Kind : uint8_t { UNKNOWN, BOOLEAN, BIGINT, DOUBLE, VARCHAR, OBJECT, ARRAY, MIXED };
+
+	Kind kind = Kind::UNKNOWN;
+	//! Object fields, in order of first appearance, and their positions by name
+	vector<pair<string, unique_ptr<JSONShape>>> fields;
+	unordered_map<string, idx_t> field_index;
+	//! Whether the object had too many distinct fields; its values are then all observed in element, as a MAP's
+	bool is_map = false;
+	//! Shape of the array elements, or of the values of an object inferred as a MAP
+	unique_ptr<JSONShape> element;
+
+	void Observe(Kind observed) {
+		if (kind == Kind::UNKNOWN || kind == observed) {
+			kind = observed;
+		} else if ((kind == Kind::BIGINT && observed == Kind::DOUBLE) ||
+		           (kind == Kind::DOUBLE && observed == Kind::BIGINT)) {
+			kind = Kind::DOUBLE;
+		} else {
+			kind = Kind::MIXED;
+		}
+	}
+
+	JSONShape &GetField(const string &name) {
+		if (is_map) {
+			return GetElement();
+		}
+		auto entry = field_index.find(name);
+		if (entry != field_index.end()) {
+			return *fields[entry->second].second;
+		}
+		if (fields.size() >= MAX_INFERRED_FIELDS) {
+			// Keys are data rather than structure
+			ConvertToMap();
+			return GetElement();
+		}
+		field_index[name] = fields.size();
+		fields.emplace_back(name, make_uniq<JSONShape>());
+		return *fields.back().second;
+	}
+
+	//! Turns an object into a MAP whose value shape holds the observations of all fields seen so far
+	void ConvertToMap() {
+		is_map = true;
+		for (auto &field : fields) {
+			GetElement().Merge(*field.second);
+		}
+		fields.clear();
+		field_index.clear();
+	}
+
+	//! Adds the observations of other at the same position
+	void Merge(const JSONShape &other) {
+		if (other.kind == Kind::UNKNOWN) {
+			return;
+		}
+		Observe(other.kind);
+		if (kind == Kind::OBJECT) {
+			if (other.is_map && !is_map) {
+				ConvertToMap();
+			}
+			for (auto &field : other.fields) {
+				GetField(field.first).Merge(*field.second);
+			}
+			if (other.is_map && other.element) {
+				GetElement().Merge(*other.element);
+			}
+		} else if (kind == Kind::ARRAY && other.element) {
+			GetElement().Merge(*other.element);
+		}
+	}
+
+	JSONShape &GetElement() {
+		if (!element) {
+			element = make_uniq<JSONShape>();
+		}
+		return *element;
+	}
+
+	LogicalType ToType() const {
+		switch (kind) {
+		case Kind::BOOLEAN:
+			return LogicalType::BOOLEAN;
+		case Kind::BIGINT:
+			return LogicalType::BIGINT;
+		case Kind::DOUBLE:
+			return LogicalType::DOUBLE;
+		case Kind::VARCHAR:
+			return LogicalType::VARCHAR;
+		case Kind::OBJECT: {
+			if (is_map) {
+				return LogicalType::MAP(LogicalType::VARCHAR, element ? element->ToType() : LogicalType::JSON());
+			}
+			if (fields.empty()) {
+				return LogicalType::JSON();
+			}
+			child_list_t<LogicalType> children;
+			for (auto &field : fields) {
+				children.emplace_back(field.first, field.second->ToType());
+			}
+			return LogicalType::STRUCT(std::move(children));
+		}
+		case Kind::ARRAY:
+			return LogicalType::LIST(element ? element->ToType() : LogicalType::JSON());
+		default:
+			return LogicalType::JSON();
+		}
+	}
+};
+
+//! Minimal recursive-descent JSON parser that writes values straight into DuckDB vectors
+class JSONParser {
+public:
+	JSONParser(const char *data, idx_t size) : begin(data), pos(data), end(data + size) {
+	}
+
+	void ParseDocument(Vector &result, idx_t row) {
+		ParseValue(result, row);
+		SkipWhitespace();
+		if (pos != end) {
+			Error("unexpected trailing characters");
+		}
+	}
+
+	void ObserveDocument(JSONShape &shape) {
+		ObserveValue(shape, 0);
+		SkipWhitespace();
+		if (pos != end) {
+			Error("unexpected trailing characters");
+		}
+	}
+
+private:
+	[[noreturn]] void Error(const string &message) {
+		throw InvalidInputException("Failed to parse Snowflake semi-structured value at offset %llu: %s",
+		                            static_cast<uint64_t>(pos - begin), message);
+	}
+
+	void SkipWhitespace() {
+		while (pos < end && StringUtil::CharacterIsSpace(*pos)) {
+			pos++;
+		}
+	}
+
+	char Peek() {
+		SkipWhitespace();
+		if (pos == end) {
+			Error("unexpected end of document");
+		}
+		return *pos;
+	}
+
+	void Expect(char c) {
+		if (Peek() != c) {
+			Error(string("expected '") + c + "'");
+		}
+		pos++;
+	}
+
+	bool ConsumeLiteral(const char *literal, idx_t length) {
+		if (idx_t(end - pos) >= length && memcmp(pos, literal, length) == 0) {
+			pos += length;
+			return true;
+		}
+		return false;
+	}
+
+	static void AppendUTF8(string &result, uint32_t code_point) {
+		if (code_point < 0x80) {
+			result += char(code_point);
+		} else if (code_point < 0x800) {
+			result += char(0xC0 | (code_point >> 6));
+			result += char(0x80 | (code_point & 0x3F));
+		} else if (code_point < 0x10000) {
+			result += char(0xE0 | (code_point >> 12));
+			result += char(0x80 | ((code_point >> 6) & 0x3F));
+			result += char(0x80 | (code_point & 0x3F));
+		} else {
+			result += char(0xF0 | (code_point >> 18));
+			result += char(0x80 | ((code_point >> 12) & 0x3F));
+			result += char(0x80 | ((code_point >> 6) & 0x3F));
+			result += char(0x80 | (code_point & 0x3F));
+		}
+	}
+
+	uint32_t ParseHex4() {
+		if (end - pos < 4) {
+			Error("truncated unicode escape");
+		}
+		uint32_t result = 0;
+		for (idx_t i = 0; i < 4; i++) {
+			auto c = *pos++;
+			result <<= 4;
+			if (c >= '0' && c <= '9') {
+				result |= uint32_t(c - '0');
+			} else if (c >= 'a' && c <= 'f') {
+				result |= uint32_t(c - 'a' + 10);
+			} else if (c >= 'A' && c <= 'F') {
+				result |= uint32_t(c - 'A' + 10);
+			} else {
+				Error("invalid unicode escape");
+			}
+		}
+		return result;
+	}
+
+	//! Parses a string starting at its opening quote and returns the unescaped contents
+	string ParseString() {
+		Expect('"');
+		string result;
+		auto run_start = pos;
+		while (true) {
+			if (pos == end) {
+				Error("unterminated string");
+			}
+			auto c = *pos;
+			if (c == '"') {
+				result.append(run_start, pos - run_start);
+				pos++;
+				return result;
+			}
+			if (c != '\\') {
+				pos++;
+				continue;
+			}
+			result.append(run_start, pos - run_start);
+			pos++;
+			if (pos == end) {
+				Error("unterminated escape sequence");
+			}
+			switch (*pos++) {
+			case '"':
+				result += '"';
+				break;
+			case '\\':
+				result += '\\';
+				break;
+			case '/':
+				result += '/';
+				break;
+			case 'b':
+				result += '\b';
+				break;
+			case 'f':
+				result += '\f';
+				break;
+			case 'n':
+				result += '\n';
+				break;
+			case 'r':
+				result += '\r';
+				break;
+			case 't':
+				result += '\t';
+				break;
+			case 'u': {
+				auto code_point = ParseHex4();
+				if (code_point >= 0xD800 && code_point <= 0xDBFF && ConsumeLiteral("\\u", 2)) {
+					auto low = ParseHex4();
+					code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+				}
+				AppendUTF8(result, code_point);
+				break;
+			}
+			default:
+				Error("invalid escape sequence");
+			}
+			run_start = pos;
+		}
+	}
+
+	//! Skips over any value and returns its raw text
+	string_t SkipValue() {
+		SkipWhitespace();
+		auto start = pos;
+		idx_t depth = 0;
+		while (pos < end) {
+			auto c = *pos;
+			if (c == '"') {
+				ParseString();
+				if (depth == 0) {
+					break;
+				}
+				continue;
+			}
+			if (c == '{' || c == '[') {
+				depth++;
+			} else if (c == '}' || c == ']') {
+				if (depth == 0) {
+					break;
+				}
+				if (--depth == 0) {
+					pos++;
+					break;
+				}
+			} else if (depth == 0 && (c == ',' || c == ':' || StringUtil::CharacterIsSpace(c))) {
+				break;
+			}
+			pos++;
+		}
+		if (depth > 0) {
+			Error("unexpected end of document");
+		}
+		if (pos == start) {
+			Error("expected a value");
+		}
+		return string_t(start, UnsafeNumericCast<uint32_t>(pos - start));
+	}
+
+	template <class T>
+	static void WriteNumeric(Vector &result, idx_t row, const string_t &text) {
+		T value;
+		if (TryCast::Operation<string_t, T>(text, value, false)) {
+			FlatVector::GetData<T>(result)[row] = value;
+		} else {
+			FlatVector::SetNull(result, row, true);
+		}
+	}
+
+	//! Writes a scalar given as text (a JSON string's contents or a number/boolean literal) into result
+	static void WriteScalar(Vector &result, idx_t row, const string_t &text) {
+		auto &type = result.GetType();
+		switch (type.id()) {
+		case LogicalTypeId::VARCHAR:
+			FlatVector::GetData<string_t>(result)[row] = StringVector::AddString(result, text);
+			break;
+		case LogicalTypeId::TINYINT:
+			WriteNumeric<int8_t>(result, row, text);
+			break;
+		case LogicalTypeId::SMALLINT:
+			WriteNumeric<int16_t>(result, row, text);
+			break;
+		case LogicalTypeId::INTEGER:
+			WriteNumeric<int32_t>(result, row, text);
+			break;
+		case LogicalTypeId::BIGINT:
+			WriteNumeric<int64_t>(result, row, text);
+			break;
+		case LogicalTypeId::FLOAT:
+			WriteNumeric<float>(result, row, text);
+			break;
+		case LogicalTypeId::DOUBLE:
+			WriteNumeric<double>(result, row, text);
+			break;
+		case LogicalTypeId::BOOLEAN:
+			WriteNumeric<bool>(result, row, text);
+			break;
+		default: {
+			// Decimals, dates, timestamps, ... take the generic cast
+			Value converted;
+			if (Value(text.GetString()).DefaultTryCastAs(type, converted, nullptr)) {
+				result.SetValue(row, converted);
+			} else {
+				FlatVector::SetNull(result, row, true);
+			}
+			break;
+		}
+		}
+	}
+
+	void ParseStruct(Vector &result, idx_t row) {
+		auto &type = result.GetType();
+		auto &children = StructVector::GetEntries(result);
+		auto &child_types = StructType::GetChildTypes(type);
+		vector<bool> found(children.size(), false);
+
+		Expect('{');
+		if (Peek() != '}') {
+			while (true) {
+				auto key = ParseString();
+				Expect(':');
+				optional_idx child_idx;
+				for (idx_t i = 0; i < child_types.size() && !child_idx.IsValid(); i++) {
+					if (child_types[i].first == key) {
+						child_idx = i;
+					}
+				}
+				for (idx_t i = 0; i < child_types.size() && !child_idx.IsValid(); i++) {
+					if (StringUtil::CIEquals(child_types[i].first, key)) {
+						child_idx = i;
+					}
+				}
+				if (child_idx.IsValid()) {
+					ParseValue(*children[child_idx.GetIndex()], row);
+					found[child_idx.GetIndex()] = true;
+				} else {
+					SkipValue();
+				}
+				if (Peek() != ',') {
+					break;
+				}
+				pos++;
+			}
+		}
+		Expect('}');
+		for (idx_t i = 0; i < children.size(); i++) {
+			if (!found[i]) {
+				FlatVector::SetNull(*children[i], row, true);
+			}
+		}
+	}
+
+	void ParseList(Vector &result, idx_t row) {
+		auto offset = ListVector::GetListSize(result);
+		idx_t length = 0;
+		Expect('[');
+		if (Peek() != ']') {
+			while (true) {
+				ListVector::Reserve(result, offset + length + 1);
+				ParseValue(ListVector::GetEntry(result), offset + length);
+				length++;
+				ListVector::SetListSize(result, offset + length);
+				if (Peek() != ',') {
+					break;
+				}
+				pos++;
+			}
+		}
+		Expect(']');
+		FlatVector::GetData<list_entry_t>(result)[row] = list_entry_t(offset, length);
+	}
+
+	void ParseArray(Vector &result, idx_t row) {
+		auto array_size = ArrayType::GetSize(result.GetType());
+		auto &child = ArrayVector::GetEntry(result);
+		idx_t length = 0;
+		Expect('[');
+		if (Peek() != ']') {
+			while (true) {
+				if (length < array_size) {
+					ParseValue(child, row * array_size + length);
+				} else {
+					SkipValue();
+				}
+				length++;
+				if (Peek() != ',') {
+					break;
+				}
+				pos++;
+			}
+		}
+		Expect(']');
+		// An array of another size is a value of a mismatching kind
+		if (length != array_size) {
+			for (idx_t i = 0; i < array_size; i++) {
+				FlatVector::SetNull(child, row * array_size + i, true);
+			}
+			FlatVector::SetNull(result, row, true);
+		}
+	}
+
+	void ParseMap(Vector &result, idx_t row) {
+		auto offset = ListVector::GetListSize(result);
+		idx_t length = 0;
+		Expect('{');
+		if (Peek() != '}') {
+			while (true) {
+				auto key = ParseString();
+				Expect(':');
+				ListVector::Reserve(result, offset + length + 1);
+				string_t key_text(key);
+				WriteScalar(MapVector::GetKeys(result), offset + length, key_text);
+				ParseValue(MapVector::GetValues(result), offset + length);
+				length++;
+				ListVector::SetListSize(result, offset + length);
+				if (Peek() != ',') {
+					break;
+				}
+				pos++;
+			}
+		}
+		Expect('}');
+		FlatVector::GetData<list_entry_t>(result)[row] = list_entry_t(offset, length);
+	}
+
+	void ParseValue(Vector &result, idx_t row) {
+		auto c = Peek();
+		if (c == 'n' && ConsumeLiteral("null", 4)) {
+			FlatVector::SetNull(result, row, true);
+			return;
+		}
+		auto &type = result.GetType();
+		if (type.IsJSONType()) {
+			// Nested JSON values are kept as their raw text
+			auto raw = SkipValue();
+			FlatVector::GetData<string_t>(result)[row] = StringVector::AddString(result, raw);
+			return;
+		}
+		switch (type.id()) {
+		case LogicalTypeId::STRUCT:
+			if (c == '{') {
+				ParseStruct(result, row);
+				return;
+			}
+			break;
+		case LogicalTypeId::MAP:
+			if (c == '{') {
+				ParseMap(result, row);
+				return;
+			}
+			break;
+		case LogicalTypeId::LIST:
+			if (c == '[') {
+				ParseList(result, row);
+				return;
+			}
+			break;
+		case LogicalTypeId::ARRAY:
+			if (c == '[') {
+				ParseArray(result, row);
+				return;
+			}
+			break;
+		default:
+			if (c == '"') {
+				auto text = ParseString();
+				WriteScalar(result, row, string_t(text));
+				return;
+			}
+			if (c != '{' && c != '[') {
+				WriteScalar(result, row, SkipValue());
+				return;
+			}
+			if (type.id() == LogicalTypeId::VARCHAR) {
+				// Non-JSON VARCHAR targets receive nested values as text
+				WriteScalar(result, row, SkipValue());
+				return;
+			}
+			break;
+		}
+		// The value does not have the expected kind
+		SkipValue();
+		FlatVector::SetNull(result, row, true);
+	}
+
+	void ObserveValue(JSONShape &shape, idx_t depth) {
+		auto c = Peek();
+		if ((c == '{' || c == '[') && depth >= MAX_INFERENCE_DEPTH) {
+			SkipValue();
+			shape.Observe(JSONShape::Kind::MIXED);
+			return;
+		}
+		if (c == '{') {
+			shape.Observe(JSONShape::Kind::OBJECT);
+			pos++;
+			if (Peek() != '}') {
+				while (true) {
+					auto key = ParseString();
+					Expect(':');
+					if (shape.kind == JSONShape::Kind::OBJECT) {
+						ObserveValue(shape.GetField(key), depth + 1);
+					} else {
+						SkipValue();
+					}
+					if (Peek() != ',') {
+						break;
+					}
+					pos++;
+				}
+			}
+			Expect('}');
+		} else if (c == '[') {
+			shape.Observe(JSONShape::Kind::ARRAY);
+			pos++;
+			if (Peek() != ']') {
+				while (true) {
+					if (shape.kind == JSONShape::Kind::ARRAY) {
+						ObserveValue(shape.GetElement(), depth + 1);
+					} else {
+						SkipValue();
+					}
+					if (Peek() != ',') {
+						break;
+					}
+					pos++;
+				}
+			}
+			Expect(']');
+		} else if (c == '"') {
+			ParseString();
+			shape.Observe(JSONShape::Kind::VARCHAR);
+		} else if (ConsumeLiteral("null", 4)) {
+			// NULLs do not constrain the type
+		} else if (ConsumeLiteral("true", 4) || ConsumeLiteral("false", 5)) {
+			shape.Observe(JSONShape::Kind::BOOLEAN);
+		} else {
+			auto number = SkipValue().GetString();
+			bool is_integer = number.size() <= 18 && number.find_first_of(".eE") == string::npos;
+			shape.Observe(is_integer ? JSONShape::Kind::BIGINT : JSONShape::Kind::DOUBLE);
+		}
+	}
+
+private:
+	const char *begin;
+	const char *pos;
+	const char *end;
+};
+
+} // namespace
+
+void SnowflakeJSONReader::Convert(Vector &source, Vector &result, idx_t count) {
+	UnifiedVectorFormat source_data;
+	source.ToUnifiedFormat(count, source_data);
+	auto documents = UnifiedVectorFormat::GetData<string_t>(source_data);
+
+	result.SetVectorType(VectorType::FLAT_VECTOR);
+	for (idx_t row = 0; row < count; row++) {
+		auto source_idx = source_data.sel->get_index(row);
+		if (!source_data.validity.RowIsValid(source_idx)) {
+			FlatVector::SetNull(result, row, true);
+			continue;
+		}
+		auto &document = documents[source_idx];
+		JSONParser parser(document.GetData(), document.GetSize());
+		parser.ParseDocument(result, row);
+	}
+}
+
+LogicalType SnowflakeJSONReader::InferType(const vector<string> &documents) {
+	JSONShape shape;
+	for (auto &document : documents) {
+		if (document.empty()) {
+			continue;
+		}
+		JSONParser parser(document.c_str(), document.size());
+		parser.ObserveDocument(shape);
+	}
+	return shape.ToType();
+}
+
+} // namespace snowflake
+} // namespace duckdb
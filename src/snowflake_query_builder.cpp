@@ -0,0 +1,112 @@
+#include "snowflake_query_builder.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+string SnowflakeQueryBuilder::QuoteIdentifier(const string &identifier) {
+	return "\"" + StringUtil::Replace(identifier, "\"", "\"\"") + "\"";
+}
+
+string SnowflakeQueryBuilder::QuoteString(const string &str) {
+	auto escaped = StringUtil::Replace(str, "\\", "\\\\");
+	return "'" + StringUtil::Replace(escaped, "'", "''") + "'";
+}
+
+idx_t SnowflakeQueryBuilder::AddPushedColumn(SnowflakePushedColumn column) {
+	for (idx_t i = 0; i < pushed_columns.size(); i++) {
+		if (pushed_columns[i].expression == column.expression && pushed_columns[i].type == column.type) {
+			return column_names.size() + i;
+		}
+	}
+	pushed_columns.push_back(std::move(column));
+	return column_names.size() + pushed_columns.size() - 1;
+}
+
+const string &SnowflakeQueryBuilder::GetColumnName(column_t column_id) const {
+	if (column_id < column_names.size()) {
+		return column_names[column_id];
+	}
+	auto pushed_idx = column_id - column_names.size();
+	if (pushed_idx >= pushed_columns.size()) {
+		throw InternalException("Snowflake scan: column id %llu is out of range", column_id);
+	}
+	return pushed_columns[pushed_idx].name;
+}
+
+string SnowflakeQueryBuilder::GetColumnExpression(column_t column_id) const {
+	if (column_id < column_names.size()) {
+		return QuoteIdentifier(column_names[column_id]);
+	}
+	return pushed_columns[column_id - column_names.size()].expression;
+}
+
+string SnowflakeQueryBuilder::GetRelation() const {
+	return sample.empty() ? source : source + " SAMPLE " + sample;
+}
+
+void SnowflakeQueryBuilder::SetPercentageSample(double percentage, bool block_sampling, optional_idx seed) {
+	sample = (block_sampling ? "BLOCK (" : "BERNOULLI (") + Value::DOUBLE(percentage).ToString() + ")";
+	// Snowflake only accepts a seed for percentage samples
+	if (seed.IsValid()) {
+		sample += " SEED (" + to_string(seed.GetIndex()) + ")";
+	}
+	sample_fraction = percentage / 100;
+	sample_rows = optional_idx();
+}
+
+void SnowflakeQueryBuilder::SetRowSample(idx_t rows) {
+	sample = "(" + to_string(rows) + " ROWS)";
+	sample_fraction = 1;
+	sample_rows = rows;
+}
+
+string SnowflakeQueryBuilder::Build(const vector<column_t> &column_ids, const vector<string> &predicates) const {
+	bool all_columns = column_ids.size() == column_names.size();
+	for (idx_t i = 0; i < column_ids.size() && all_columns; i++) {
+		all_columns = column_ids[i] == i;
+	}
+	auto all_predicates = this->predicates;
+	all_predicates.insert(all_predicates.end(), predicates.begin(), predicates.end());
+	string suffix;
+	if (!all_predicates.empty()) {
+		suffix += " WHERE " + StringUtil::Join(all_predicates, " AND ");
+	}
+	if (!qualify.empty()) {
+		suffix += " QUALIFY " + qualify;
+	}
+	if (!order_by.empty()) {
+		suffix += " ORDER BY " + StringUtil::Join(order_by, ", ");
+	}
+	if (limit.IsValid()) {
+		suffix += " LIMIT " + to_string(limit.GetIndex());
+	}
+	string select = distinct ? "SELECT DISTINCT " : "SELECT ";
+	if (all_columns) {
+		return select + "* FROM " + GetRelation() + suffix;
+	}
+
+	string select_list;
+	for (auto column_id : column_ids) {
+		if (!select_list.empty()) {
+			select_list += ", ";
+		}
+		if (IsRowIdColumnId(column_id)) {
+			// Only the row count matters, e.g. for COUNT(*)
+			select_list += "0";
+		} else if (column_id < column_names.size()) {
+			select_list += QuoteIdentifier(column_names[column_id]);
+		} else {
+			auto &pushed = pushed_columns[column_id - column_names.size()];
+			select_list += pushed.expression + " AS " + QuoteIdentifier(pushed.name);
+		}
+	}
+	if (select_list.empty()) {
+		select_list = "0";
+	}
+	return select + select_list + " FROM " + GetRelation() + suffix;
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,191 @@
+#include "snowflake_query_estimate.hpp"
+#include "snowflake_client.hpp"
+#include "snowflake_debug.hpp"
+#include "snowflake_json.hpp"
+#include "snowflake_query_builder.hpp"
+#include "snowflake_result_cache.hpp"
+#include "snowflake_semantic_cache.hpp"
+#include "duckdb/main/client_context.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+// Table sizes change slowly compared to how often a dashboard re-runs the same query
+static constexpr uint64_t ESTIMATE_TTL_SECONDS = 3600;
+
+optional_idx SnowflakeQueryEstimate::EstimateRows() const {
+	// The assigned bytes are compressed and cover every column of the assigned partitions, so they do not convert
+	// to rows of the projected columns; partitions hold similar numbers of rows
+	if (!plain_scan || !table_rows.IsValid() || partitions_total == 0) {
+		return optional_idx();
+	}
+	auto fraction = static_cast<double>(partitions_assigned) / static_cast<double>(partitions_total);
+	return MaxValue<idx_t>(LossyNumericCast<idx_t>(static_cast<double>(table_rows.GetIndex()) * fraction), 1);
+}
+
+// Whether the operations of an explained plan read a single table and at most filter its rows; table is set to the
+// name of the scanned table as the plan gives it
+static bool IsPlainScan(const Value &operations, string &table) {
+	idx_t table_scans = 0;
+	for (auto &step : ListValue::GetChildren(operations)) {
+		if (step.IsNull()) {
+			return false;
+		}
+		for (auto &operation : ListValue::GetChildren(step)) {
+			if (operation.IsNull() || StructValue::GetChildren(operation)[0].IsNull()) {
+				return false;
+			}
+			auto name = StructValue::GetChildren(operation)[0].ToString();
+			if (name == "TableScan") {
+				table_scans++;
+				auto &objects = StructValue::GetChildren(operation)[1];
+				if (!objects.IsNull() && ListValue::GetChildren(objects).size() == 1 &&
+				    !ListValue::GetChildren(objects)[0].IsNull()) {
+					table = ListValue::GetChildren(objects)[0].ToString();
+				}
+			} else if (name != "Result" && name != "Filter") {
+				return false;
+			}
+		}
+	}
+	return table_scans == 1;
+}
+
+SnowflakeQueryEstimates &SnowflakeQueryEstimates::Get() {
+	static SnowflakeQueryEstimates instance;
+	return instance;
+}
+
+static optional_idx GetMaxBytesScanned(ClientContext &context) {
+	Value setting;
+	if (!context.TryGetCurrentSetting("snowflake_max_bytes_scanned", setting) || setting.IsNull()) {
+		return optional_idx();
+	}
+	return UBigIntValue::Get(setting);
+}
+
+// Row count of a table named database.schema.table, as the plan's objects name it; invalid if Snowflake does not
+// track it, e.g. for external tables
+static optional_idx GetTableRows(ClientContext &context, SnowflakeClient &connection, const string &table) {
+	auto parts = StringUtil::Split(table, '.');
+	auto query = "SELECT TO_VARCHAR(row_count) FROM " + SnowflakeQueryBuilder::QuoteIdentifier(parts[0]) +
+	             ".information_schema.tables WHERE table_schema = " + SnowflakeQueryBuilder::QuoteString(parts[1]) +
+	             " AND table_name = " + SnowflakeQueryBuilder::QuoteString(parts[2]);
+	try {
+		auto result = connection.ExecuteAndGetStrings(context, query, {});
+		if (result.empty() || result[0].size() != 1 || result[0][0].empty()) {
+			return optional_idx();
+		}
+		return optional_idx(std::stoull(result[0][0]));
+	} catch (std::exception &ex) {
+		DPRINT("SnowflakeQueryEstimates: could not read the row count of %s: %s\n", table.c_str(), ex.what());
+		return optional_idx();
+	}
+}
+
+bool SnowflakeQueryEstimates::GetEstimate(ClientContext &context, SnowflakeClient &connection, const string &query,
+                                          SnowflakeQueryEstimate &result) {
+	Value setting;
+	bool enabled = context.TryGetCurrentSetting("snowflake_scan_estimates", setting) && !setting.IsNull() &&
+	               BooleanValue::Get(setting);
+	if (!enabled && !GetMaxBytesScanned(context).IsValid()) {
+		return false;
+	}
+	auto key = SnowflakeResultCache::GetKey(connection.GetConfig(), query);
+	auto now = SnowflakeSemanticCache::CurrentTime();
+	{
+		lock_guard<mutex> guard(lock);
+		auto entry = estimates.find(key);
+		if (entry != estimates.end() && now < entry->second.explained_at + ESTIMATE_TTL_SECONDS) {
+			result = entry->second;
+			return true;
+		}
+	}
+
+	vector<vector<string>> plan;
+	try {
+		plan = connection.ExecuteAndGetStrings(context, "EXPLAIN USING JSON " + query, {});
+	} catch (std::exception &ex) {
+		DPRINT("SnowflakeQueryEstimates: could not explain query: %s\n", ex.what());
+		return false;
+	}
+	if (plan.empty() || plan[0].empty() || plan[0][0].empty()) {
+		return false;
+	}
+	child_list_t<LogicalType> global_stats;
+	global_stats.emplace_back("partitionsTotal", LogicalType::UBIGINT);
+	global_stats.emplace_back("partitionsAssigned", LogicalType::UBIGINT);
+	global_stats.emplace_back("bytesAssigned", LogicalType::UBIGINT);
+	child_list_t<LogicalType> operation_fields;
+	operation_fields.emplace_back("operation", LogicalType::VARCHAR);
+	operation_fields.emplace_back("objects", LogicalType::LIST(LogicalType::VARCHAR));
+	child_list_t<LogicalType> plan_fields;
+	plan_fields.emplace_back("GlobalStats", LogicalType::STRUCT(std::move(global_stats)));
+	plan_fields.emplace_back("Operations",
+	                         LogicalType::LIST(LogicalType::LIST(LogicalType::STRUCT(std::move(operation_fields)))));
+	Value plan_value;
+	try {
+		Vector source(Value(plan[0][0]));
+		Vector parsed(LogicalType::STRUCT(std::move(plan_fields)), 1);
+		SnowflakeJSONReader::Convert(source, parsed, 1);
+		plan_value = parsed.GetValue(0);
+	} catch (std::exception &ex) {
+		// The plan format is not documented as stable; go without an estimate rather than fail the query
+		DPRINT("SnowflakeQueryEstimates: could not parse the plan: %s\n", ex.what());
+		return false;
+	}
+	if (plan_value.IsNull() || StructValue::GetChildren(plan_value)[0].IsNull()) {
+		return false;
+	}
+	auto &stats = StructValue::GetChildren(StructValue::GetChildren(plan_value)[0]);
+	for (auto &stat : stats) {
+		if (stat.IsNull()) {
+			return false;
+		}
+	}
+	auto &operations = StructValue::GetChildren(plan_value)[1];
+	string table;
+	result.plain_scan = !operations.IsNull() && IsPlainScan(operations, table);
+	result.partitions_total = UBigIntValue::Get(stats[0]);
+	result.partitions_assigned = UBigIntValue::Get(stats[1]);
+	result.bytes_assigned = UBigIntValue::Get(stats[2]);
+	result.explained_at = now;
+	if (result.plain_scan && StringUtil::Split(table, '.').size() == 3) {
+		result.table_rows = GetTableRows(context, connection, table);
+	}
+	DPRINT("SnowflakeQueryEstimates: %llu of %llu partitions, %llu bytes%s\n",
+	       (unsigned long long)result.partitions_assigned, (unsigned long long)result.partitions_total,
+	       (unsigned long long)result.bytes_assigned, result.plain_scan ? ", plain scan" : "");
+
+	lock_guard<mutex> guard(lock);
+	for (auto entry = estimates.begin(); entry != estimates.end();) {
+		if (entry->second.explained_at + ESTIMATE_TTL_SECONDS <= now) {
+			entry = estimates.erase(entry);
+		} else {
+			entry++;
+		}
+	}
+	estimates[key] = result;
+	return true;
+}
+
+void SnowflakeQueryEstimates::CheckBytesScanned(ClientContext &context, const SnowflakeQueryEstimate &estimate) {
+	auto max_bytes = GetMaxBytesScanned(context);
+	if (!max_bytes.IsValid() || estimate.bytes_assigned <= max_bytes.GetIndex()) {
+		return;
+	}
+	Value action;
+	if (context.TryGetCurrentSetting("snowflake_max_bytes_scanned_action", action) && !action.IsNull() &&
+	    StringUtil::Lower(action.ToString()) == "warn") {
+		fprintf(stderr,
+		        "[Snowflake Warning] Query is estimated to scan %llu bytes (snowflake_max_bytes_scanned is %llu)\n",
+		        (unsigned long long)estimate.bytes_assigned, (unsigned long long)max_bytes.GetIndex());
+		return;
+	}
+	throw BinderException("Snowflake query is estimated to scan %llu bytes, more than snowflake_max_bytes_scanned "
+	                      "(%llu); raise the limit or SET snowflake_max_bytes_scanned_action = 'warn'",
+	                      estimate.bytes_assigned, max_bytes.GetIndex());
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,485 @@
+#include "snowflake_replicate.hpp"
+#include "snowflake_scan.hpp"
+#include "snowflake_debug.hpp"
+#include "storage/snowflake_catalog.hpp"
+#include "duckdb/catalog/catalog.hpp"
+#include "duckdb/catalog/catalog_search_path.hpp"
+#include "duckdb/catalog/catalog_entry/table_catalog_entry.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/value_map.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/main/appender.hpp"
+#include "duckdb/main/client_data.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include "duckdb/parser/parsed_data/create_table_info.hpp"
+#include "duckdb/parser/qualified_name.hpp"
+#include "duckdb/planner/binder.hpp"
+#include "duckdb/storage/data_table.hpp"
+#include "duckdb/storage/table/delete_state.hpp"
+#include "duckdb/storage/table/scan_state.hpp"
+#include "duckdb/transaction/duck_transaction.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+// Local table recording the source and Snowflake timestamp of every replica, in the main schema of the replica's
+// database
+static constexpr const char *REPLICA_METADATA_TABLE = "__snowflake_replicas";
+static constexpr const char *ACTION_COLUMN = "METADATA$ACTION";
+
+struct SnowflakeReplicaSource {
+	shared_ptr<SnowflakeClient> client;
+	string schema;
+	string table;
+	//! The table as Snowflake names it, database.schema.table
+	string table_ref;
+};
+
+//! The local table of a replica, resolved against the search path like a table reference in a query
+struct SnowflakeReplicaTarget {
+	string catalog;
+	string schema;
+	string table;
+};
+
+struct SnowflakeReplicateBindData : public TableFunctionData {
+	//! 'catalog.schema.table' of the attached Snowflake table; empty for a refresh, which reads it from the metadata
+	string source;
+	SnowflakeReplicaTarget target;
+};
+
+struct SnowflakeReplicateGlobalState : public GlobalTableFunctionState {
+	bool finished = false;
+};
+
+struct SnowflakeReplicateResult {
+	//! The local table as recorded in the metadata, catalog.schema.table
+	string local_table;
+	idx_t rows_inserted = 0;
+	idx_t rows_deleted = 0;
+	string offset;
+};
+
+static SnowflakeReplicaSource ResolveSource(ClientContext &context, const string &source) {
+	auto parts = StringUtil::Split(source, '.');
+	if (parts.size() != 3) {
+		throw BinderException("Snowflake replica source must be given as 'catalog.schema.table', got '%s'", source);
+	}
+	auto &catalog = Catalog::GetCatalog(context, parts[0]);
+	if (catalog.GetCatalogType() != "snowflake") {
+		throw BinderException("'%s' is not an attached Snowflake database", parts[0]);
+	}
+	SnowflakeReplicaSource result;
+	result.client = catalog.Cast<SnowflakeCatalog>().GetClient();
+	result.schema = parts[1];
+	result.table = parts[2];
+	result.table_ref = result.client->GetConfig().database + "." + parts[1] + "." + parts[2];
+	return result;
+}
+
+static SnowflakeReplicaTarget ResolveTarget(ClientContext &context, const string &target) {
+	auto name = QualifiedName::Parse(target);
+	auto &search_path = *ClientData::Get(context).catalog_search_path;
+	SnowflakeReplicaTarget result;
+	result.catalog = name.catalog;
+	result.schema = name.schema;
+	result.table = name.name;
+	if (IsInvalidCatalog(result.catalog)) {
+		result.catalog = IsInvalidSchema(result.schema) ? search_path.GetDefault().catalog
+		                                                : search_path.GetDefaultCatalog(result.schema);
+	}
+	if (IsInvalidSchema(result.schema)) {
+		result.schema = search_path.GetDefaultSchema(result.catalog);
+	}
+	auto &catalog = Catalog::GetCatalog(context, result.catalog);
+	if (!catalog.IsDuckCatalog()) {
+		throw BinderException("Snowflake replicas must be stored in a DuckDB database, '%s' is not one", target);
+	}
+	result.catalog = catalog.GetName();
+	return result;
+}
+
+// Name of a local table as recorded in the metadata, so every spelling of a reference to it finds the same replica
+static string GetReplicaName(TableCatalogEntry &table) {
+	return KeywordHelper::WriteOptionallyQuoted(table.ParentCatalog().GetName()) + "." +
+	       KeywordHelper::WriteOptionallyQuoted(table.ParentSchema().name) + "." +
+	       KeywordHelper::WriteOptionallyQuoted(table.name);
+}
+
+// The current Snowflake timestamp, which marks the state of a copy and the start of the next refresh
+static string GetSnowflakeTimestamp(ClientContext &context, SnowflakeClient &client) {
+	auto result = client.ExecuteAndGetStrings(
+	    context, "SELECT TO_VARCHAR(CURRENT_TIMESTAMP(), 'YYYY-MM-DD HH24:MI:SS.FF9 TZH:TZM')", {});
+	if (result.empty() || result[0].empty()) {
+		throw IOException("Failed to read the current timestamp from Snowflake");
+	}
+	return result[0][0];
+}
+
+static unique_ptr<SnowflakeScanBindData> BindQuery(ClientContext &context, const SnowflakeReplicaSource &source,
+                                                   const string &query, vector<string> &names,
+                                                   vector<LogicalType> &types) {
+	auto factory = make_uniq<SnowflakeArrowStreamFactory>(source.client, query);
+	auto bind_data = make_uniq<SnowflakeScanBindData>(std::move(factory));
+	SnowflakeBindSchema(context, *bind_data, "(" + query + ")", names, types, 0);
+	return bind_data;
+}
+
+// Local tables are created, read and written through the catalog and storage of the caller's transaction, so the
+// changes of a replication commit or roll back with the statement or transaction that called it
+static TableCatalogEntry &CreateLocalTable(ClientContext &context, const string &catalog, const string &schema,
+                                           const string &table, const vector<string> &names,
+                                           const vector<LogicalType> &types, OnCreateConflict on_conflict) {
+	auto info = make_uniq<CreateTableInfo>(catalog, schema, table);
+	for (idx_t i = 0; i < names.size(); i++) {
+		info->columns.AddColumn(ColumnDefinition(names[i], types[i]));
+	}
+	info->on_conflict = on_conflict;
+	Catalog::GetCatalog(context, catalog).CreateTable(context, std::move(info));
+	return Catalog::GetEntry<TableCatalogEntry>(context, catalog, schema, table);
+}
+
+// Passes every row of a local table to callback, together with its row id
+static void ScanLocalTable(ClientContext &context, TableCatalogEntry &table,
+                           const std::function<void(DataChunk &chunk, const row_t *row_ids)> &callback) {
+	vector<StorageIndex> column_ids;
+	vector<LogicalType> types;
+	for (auto &column : table.GetColumns().Physical()) {
+		column_ids.emplace_back(column.StorageOid());
+		types.push_back(column.Type());
+	}
+	column_ids.emplace_back(COLUMN_IDENTIFIER_ROW_ID);
+	types.push_back(LogicalType::ROW_TYPE);
+
+	auto &storage = table.GetStorage();
+	auto &transaction = DuckTransaction::Get(context, table.ParentCatalog());
+	TableScanState state;
+	storage.InitializeScan(context, transaction, state, column_ids);
+	DataChunk chunk;
+	chunk.Initialize(Allocator::Get(context), types);
+	while (true) {
+		chunk.Reset();
+		storage.Scan(transaction, chunk, state);
+		if (chunk.size() == 0) {
+			break;
+		}
+		chunk.Flatten();
+		callback(chunk, FlatVector::GetData<row_t>(chunk.data.back()));
+	}
+}
+
+static idx_t DeleteLocalRows(ClientContext &context, TableCatalogEntry &table, const vector<row_t> &row_ids) {
+	auto &storage = table.GetStorage();
+	// Replicas and the metadata table are created without constraints
+	vector<unique_ptr<BoundConstraint>> bound_constraints;
+	auto state = storage.InitializeDelete(table, context, bound_constraints);
+	Vector ids(LogicalType::ROW_TYPE);
+	idx_t deleted = 0;
+	for (idx_t offset = 0; offset < row_ids.size(); offset += STANDARD_VECTOR_SIZE) {
+		auto count = MinValue<idx_t>(STANDARD_VECTOR_SIZE, row_ids.size() - offset);
+		auto data = FlatVector::GetData<row_t>(ids);
+		for (idx_t i = 0; i < count; i++) {
+			data[i] = row_ids[offset + i];
+		}
+		deleted += storage.Delete(*state, context, ids, count);
+	}
+	return deleted;
+}
+
+// Hashes the first column_count columns of every row of chunk
+static void HashRows(DataChunk &chunk, idx_t column_count, Vector &hashes) {
+	VectorOperations::Hash(chunk.data[0], hashes, chunk.size());
+	for (idx_t col_idx = 1; col_idx < column_count; col_idx++) {
+		VectorOperations::CombineHash(hashes, chunk.data[col_idx], chunk.size());
+	}
+	hashes.Flatten(chunk.size());
+}
+
+// Runs a bound Snowflake query and passes its result to callback
+static void ScanQuery(ClientContext &context, const SnowflakeScanBindData &bind_data,
+                      const vector<column_t> &column_ids, const std::function<void(DataChunk &)> &callback) {
+	SnowflakeScanQuery(context, bind_data, bind_data.query.Build(column_ids), column_ids, callback);
+}
+
+static TableCatalogEntry &GetMetadataTable(ClientContext &context, const string &catalog) {
+	return CreateLocalTable(context, catalog, DEFAULT_SCHEMA, REPLICA_METADATA_TABLE,
+	                        {"local_table", "source", "snowflake_offset", "refreshed_at"},
+	                        {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::TIMESTAMP},
+	                        OnCreateConflict::IGNORE_ON_CONFLICT);
+}
+
+// Reads the source and offset recorded for a replica, returns false if there are none
+static bool LookupOffset(ClientContext &context, const string &catalog, const string &local_table, string &source,
+                         string &offset) {
+	auto metadata = Catalog::GetEntry<TableCatalogEntry>(context, catalog, DEFAULT_SCHEMA, REPLICA_METADATA_TABLE,
+	                                                     OnEntryNotFound::RETURN_NULL);
+	if (!metadata) {
+		return false;
+	}
+	bool found = false;
+	ScanLocalTable(context, *metadata, [&](DataChunk &chunk, const row_t *row_ids) {
+		for (idx_t row = 0; row < chunk.size(); row++) {
+			if (chunk.GetValue(0, row).ToString() == local_table) {
+				source = chunk.GetValue(1, row).ToString();
+				offset = chunk.GetValue(2, row).ToString();
+				found = true;
+			}
+		}
+	});
+	return found;
+}
+
+static void StoreOffset(ClientContext &context, const string &catalog, const string &local_table,
+                        const string &source, const string &offset) {
+	auto &metadata = GetMetadataTable(context, catalog);
+	vector<row_t> previous;
+	ScanLocalTable(context, metadata, [&](DataChunk &chunk, const row_t *row_ids) {
+		for (idx_t row = 0; row < chunk.size(); row++) {
+			if (chunk.GetValue(0, row).ToString() == local_table) {
+				previous.push_back(row_ids[row]);
+			}
+		}
+	});
+	DeleteLocalRows(context, metadata, previous);
+	InternalAppender appender(context, metadata);
+	appender.BeginRow();
+	appender.Append(Value(local_table));
+	appender.Append(Value(source));
+	appender.Append(Value(offset));
+	appender.Append(Value::TIMESTAMP(Timestamp::GetCurrentTimestamp()));
+	appender.EndRow();
+	appender.Close();
+}
+
+static SnowflakeReplicateResult Replicate(ClientContext &context, const string &source_name,
+                                          const SnowflakeReplicaTarget &target) {
+	auto source = ResolveSource(context, source_name);
+
+	// Snowflake only records changes while change tracking is on; enabling it alters the table, which is left to
+	// its owner
+	if (!source.client->HasChangeTracking(context, source.schema, source.table)) {
+		throw InvalidInputException("Change tracking is not enabled on %s, which refreshing the replica needs; enable "
+		                            "it with ALTER TABLE %s SET CHANGE_TRACKING = TRUE",
+		                            source.table_ref, source.table_ref);
+	}
+
+	SnowflakeReplicateResult result;
+	result.offset = GetSnowflakeTimestamp(context, *source.client);
+	// The copy reads the table as of the offset, so the first refresh neither misses nor repeats changes
+	auto query = "SELECT * FROM " + source.table_ref + " AT(TIMESTAMP => '" + result.offset + "'::TIMESTAMP_TZ)";
+	vector<string> names;
+	vector<LogicalType> types;
+	auto bind_data = BindQuery(context, source, query, names, types);
+	vector<column_t> column_ids;
+	for (idx_t i = 0; i < names.size(); i++) {
+		column_ids.push_back(i);
+	}
+
+	auto &table = CreateLocalTable(context, target.catalog, target.schema, target.table, names, types,
+	                               OnCreateConflict::REPLACE_ON_CONFLICT);
+	result.local_table = GetReplicaName(table);
+	InternalAppender appender(context, table);
+	ScanQuery(context, *bind_data, column_ids, [&](DataChunk &chunk) {
+		appender.AppendDataChunk(chunk);
+		result.rows_inserted += chunk.size();
+	});
+	appender.Close();
+	StoreOffset(context, target.catalog, result.local_table, source_name, result.offset);
+	DPRINT("Replicate: copied %llu rows of %s as of %s\n", (unsigned long long)result.rows_inserted,
+	       source.table_ref.c_str(), result.offset.c_str());
+	return result;
+}
+
+static SnowflakeReplicateResult RefreshReplica(ClientContext &context, const SnowflakeReplicaTarget &target) {
+	auto table = Catalog::GetEntry<TableCatalogEntry>(context, target.catalog, target.schema, target.table,
+	                                                  OnEntryNotFound::RETURN_NULL);
+	SnowflakeReplicateResult result;
+	string source_name;
+	string start_offset;
+	if (table) {
+		result.local_table = GetReplicaName(*table);
+	}
+	if (!table || !LookupOffset(context, target.catalog, result.local_table, source_name, start_offset)) {
+		throw InvalidInputException("'%s' is not a Snowflake replica, create it with snowflake_replicate",
+		                            target.table);
+	}
+	auto source = ResolveSource(context, source_name);
+
+	result.offset = GetSnowflakeTimestamp(context, *source.client);
+	// Net changes over the interval: updates arrive as a DELETE of the old row and an INSERT of the new one
+	auto query = "SELECT * FROM " + source.table_ref + " CHANGES(INFORMATION => DEFAULT) AT(TIMESTAMP => '" +
+	             start_offset + "'::TIMESTAMP_TZ) END(TIMESTAMP => '" + result.offset + "'::TIMESTAMP_TZ)";
+	vector<string> names;
+	vector<LogicalType> types;
+	unique_ptr<SnowflakeScanBindData> bind_data;
+	try {
+		bind_data = BindQuery(context, source, query, names, types);
+	} catch (std::exception &ex) {
+		throw IOException("Failed to read the changes of %s since %s: %s\nChange tracking has to be enabled on the "
+		                  "table and the offset has to be within its data retention period; run snowflake_replicate "
+		                  "to copy the table again",
+		                  source.table_ref, start_offset, ex.what());
+	}
+
+	// Keep the table columns followed by the action, skip the other change metadata
+	vector<column_t> column_ids;
+	child_list_t<LogicalType> row_type;
+	optional_idx action_id;
+	for (idx_t i = 0; i < names.size(); i++) {
+		if (StringUtil::CIEquals(names[i], ACTION_COLUMN)) {
+			action_id = i;
+		} else if (!StringUtil::StartsWith(StringUtil::Upper(names[i]), "METADATA$")) {
+			column_ids.push_back(i);
+			row_type.emplace_back(names[i], types[i]);
+		}
+	}
+	if (!action_id.IsValid() || column_ids.size() != table->GetColumns().PhysicalColumnCount()) {
+		throw InvalidInputException("The columns of '%s' no longer match %s, run snowflake_replicate to copy the table "
+		                            "again",
+		                            result.local_table, source.table_ref);
+	}
+	column_ids.push_back(action_id.GetIndex());
+
+	// Rows are not identified by a key, so a DELETE removes one local row with the same values: deleted rows are
+	// counted per value, and as many identical local rows are removed. Local rows are matched by their hash first,
+	// so only rows hashing like a deleted one are compared value by value.
+	value_map_t<idx_t> deleted_rows;
+	unordered_set<hash_t> deleted_hashes;
+	idx_t deleted_count = 0;
+	auto inserted = make_uniq<ColumnDataCollection>(Allocator::Get(context), table->GetTypes());
+	idx_t change_count = 0;
+	ScanQuery(context, *bind_data, column_ids, [&](DataChunk &chunk) {
+		auto action_idx = chunk.ColumnCount() - 1;
+		SelectionVector insert_sel(STANDARD_VECTOR_SIZE);
+		idx_t insert_count = 0;
+		Vector hashes(LogicalType::HASH, chunk.size());
+		HashRows(chunk, action_idx, hashes);
+		auto hash_data = FlatVector::GetData<hash_t>(hashes);
+		for (idx_t row = 0; row < chunk.size(); row++) {
+			auto action = chunk.GetValue(action_idx, row).ToString();
+			if (action == "INSERT") {
+				insert_sel.set_index(insert_count++, row);
+				continue;
+			}
+			child_list_t<Value> values;
+			for (idx_t col_idx = 0; col_idx < action_idx; col_idx++) {
+				values.emplace_back(row_type[col_idx].first, chunk.GetValue(col_idx, row));
+			}
+			deleted_rows[Value::STRUCT(std::move(values))]++;
+			deleted_hashes.insert(hash_data[row]);
+			deleted_count++;
+		}
+		change_count += chunk.size();
+		if (insert_count > 0) {
+			DataChunk rows;
+			rows.InitializeEmpty(table->GetTypes());
+			for (idx_t col_idx = 0; col_idx < action_idx; col_idx++) {
+				rows.data[col_idx].Slice(chunk.data[col_idx], insert_sel, insert_count);
+			}
+			rows.SetCardinality(insert_count);
+			inserted->Append(rows);
+		}
+	});
+	DPRINT("RefreshReplica: %llu changes to %s since %s\n", (unsigned long long)change_count,
+	       source.table_ref.c_str(), start_offset.c_str());
+
+	if (!deleted_rows.empty()) {
+		vector<row_t> row_ids;
+		ScanLocalTable(context, *table, [&](DataChunk &chunk, const row_t *chunk_row_ids) {
+			if (row_ids.size() == deleted_count) {
+				return;
+			}
+			Vector hashes(LogicalType::HASH, chunk.size());
+			HashRows(chunk, row_type.size(), hashes);
+			auto hash_data = FlatVector::GetData<hash_t>(hashes);
+			for (idx_t row = 0; row < chunk.size(); row++) {
+				if (deleted_hashes.find(hash_data[row]) == deleted_hashes.end()) {
+					continue;
+				}
+				child_list_t<Value> values;
+				for (idx_t col_idx = 0; col_idx < row_type.size(); col_idx++) {
+					values.emplace_back(row_type[col_idx].first, chunk.GetValue(col_idx, row));
+				}
+				auto entry = deleted_rows.find(Value::STRUCT(std::move(values)));
+				if (entry != deleted_rows.end() && entry->second > 0) {
+					entry->second--;
+					row_ids.push_back(chunk_row_ids[row]);
+				}
+			}
+		});
+		result.rows_deleted = DeleteLocalRows(context, *table, row_ids);
+	}
+	if (inserted->Count() > 0) {
+		InternalAppender appender(context, *table);
+		for (auto &chunk : inserted->Chunks()) {
+			appender.AppendDataChunk(chunk);
+		}
+		appender.Close();
+		result.rows_inserted = inserted->Count();
+	}
+	StoreOffset(context, target.catalog, result.local_table, source_name, result.offset);
+	return result;
+}
+
+static unique_ptr<FunctionData> SnowflakeReplicateBind(ClientContext &context, TableFunctionBindInput &input,
+                                                       vector<LogicalType> &return_types, vector<string> &names) {
+	auto result = make_uniq<SnowflakeReplicateBindData>();
+	for (auto &value : input.inputs) {
+		if (value.IsNull()) {
+			throw BinderException("%s arguments cannot be NULL", input.table_function.name);
+		}
+	}
+	string target;
+	if (input.inputs.size() == 2) {
+		result->source = StringValue::Get(input.inputs[0]);
+		target = StringValue::Get(input.inputs[1]);
+	} else {
+		target = StringValue::Get(input.inputs[0]);
+	}
+	result->target = ResolveTarget(context, target);
+	// The statement writes to the replica's database, which DuckDB has to know to open a writable transaction on it
+	if (input.binder) {
+		input.binder->GetStatementProperties().RegisterDBModify(Catalog::GetCatalog(context, result->target.catalog),
+		                                                        context);
+	}
+	names = {"local_table", "rows_inserted", "rows_deleted", "snowflake_offset"};
+	return_types = {LogicalType::VARCHAR, LogicalType::UBIGINT, LogicalType::UBIGINT, LogicalType::VARCHAR};
+	return std::move(result);
+}
+
+static unique_ptr<GlobalTableFunctionState> SnowflakeReplicateInitGlobal(ClientContext &context,
+                                                                         TableFunctionInitInput &input) {
+	return make_uniq<SnowflakeReplicateGlobalState>();
+}
+
+static void SnowflakeReplicateFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &bind_data = data_p.bind_data->Cast<SnowflakeReplicateBindData>();
+	auto &global_state = data_p.global_state->Cast<SnowflakeReplicateGlobalState>();
+	if (global_state.finished) {
+		return;
+	}
+	global_state.finished = true;
+	auto result = bind_data.source.empty() ? RefreshReplica(context, bind_data.target)
+	                                       : Replicate(context, bind_data.source, bind_data.target);
+	output.SetValue(0, 0, Value(result.local_table));
+	output.SetValue(1, 0, Value::UBIGINT(result.rows_inserted));
+	output.SetValue(2, 0, Value::UBIGINT(result.rows_deleted));
+	output.SetValue(3, 0, Value(result.offset));
+	output.SetCardinality(1);
+}
+
+} // namespace snowflake
+
+TableFunction GetSnowflakeReplicateFunction() {
+	return TableFunction("snowflake_replicate", {LogicalType::VARCHAR, LogicalType::VARCHAR},
+	                     snowflake::SnowflakeReplicateFunction, snowflake::SnowflakeReplicateBind,
+	                     snowflake::SnowflakeReplicateInitGlobal);
+}
+
+TableFunction GetSnowflakeRefreshReplicaFunction() {
+	return TableFunction("snowflake_refresh_replica", {LogicalType::VARCHAR}, snowflake::SnowflakeReplicateFunction,
+	                     snowflake::SnowflakeReplicateBind, snowflake::SnowflakeReplicateInitGlobal);
+}
+
+} // namespace duckdb
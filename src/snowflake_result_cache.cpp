@@ -0,0 +1,931 @@
+#include "snowflake_result_cache.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/hash.hpp"
+#include "duckdb/main/client_context.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+namespace duckdb {
+namespace snowflake {
+
+// Layout of a cache entry (all integers are little-endian uint64):
+//   magic, version, creation time, key
+//   schema:  format, name, metadata, flags, child count, children...
+//   batches: length, null count, offset, buffer count, child count, buffers (size + 64-byte aligned data), children...
+//   index:   batch count, batch offsets...
+//   trailer: index offset, magic
+static constexpr char RESULT_CACHE_MAGIC[8] = {'S', 'F', 'R', 'C', 'A', 'C', 'H', 'E'};
+static constexpr uint64_t RESULT_CACHE_VERSION = 1;
+static constexpr idx_t RESULT_CACHE_ALIGNMENT = 64;
+static constexpr uint64_t RESULT_CACHE_NULL = NumericLimits<uint64_t>::Maximum();
+static constexpr const char *RESULT_CACHE_EXTENSION = ".sfrc";
+
+static uint64_t CurrentUnixTime() {
+	return NumericCast<uint64_t>(
+	    std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+bool SnowflakeResultCacheOptions::FromSettings(ClientContext &context, SnowflakeResultCacheOptions &result) {
+#ifdef _WIN32
+	// Entries are memory-mapped, which is only implemented for POSIX systems
+	return false;
+#else
+	Value setting;
+	if (!context.TryGetCurrentSetting("snowflake_result_cache", setting) || setting.IsNull() ||
+	    !BooleanValue::Get(setting)) {
+		return false;
+	}
+	if (context.TryGetCurrentSetting("snowflake_result_cache_directory", setting) && !setting.IsNull()) {
+		result.directory = StringValue::Get(setting);
+	}
+	if (result.directory.empty()) {
+		auto home = std::getenv("HOME");
+		if (!home) {
+			return false;
+		}
+		result.directory = string(home) + "/.duckdb/snowflake_result_cache";
+	}
+	if (context.TryGetCurrentSetting("snowflake_result_cache_ttl", setting) && !setting.IsNull()) {
+		result.ttl_seconds = UBigIntValue::Get(setting);
+	}
+	if (context.TryGetCurrentSetting("snowflake_result_cache_max_bytes", setting) && !setting.IsNull()) {
+		result.max_bytes = UBigIntValue::Get(setting);
+	}
+	return true;
+#endif
+}
+
+#ifndef _WIN32
+
+//===--------------------------------------------------------------------===//
+// Arrow layout
+//===--------------------------------------------------------------------===//
+static idx_t GetFixedWidth(const string &format) {
+	if (format == "c" || format == "C") {
+		return 1;
+	}
+	if (format == "s" || format == "S" || format == "e") {
+		return 2;
+	}
+	if (format == "i" || format == "I" || format == "f" || format == "tdD" || format == "tts" || format == "ttm" ||
+	    format == "tiM") {
+		return 4;
+	}
+	if (format == "l" || format == "L" || format == "g" || format == "tdm" || format == "ttu" || format == "ttn" ||
+	    format == "tiD" || StringUtil::StartsWith(format, "ts") || StringUtil::StartsWith(format, "tD")) {
+		return 8;
+	}
+	if (format == "tin") {
+		return 16;
+	}
+	if (StringUtil::StartsWith(format, "d:")) {
+		// d:precision,scale[,bitwidth]
+		auto parts = StringUtil::Split(format.substr(2), ',');
+		return parts.size() == 3 ? std::stoull(parts[2]) / 8 : 16;
+	}
+	if (StringUtil::StartsWith(format, "w:")) {
+		return std::stoull(format.substr(2));
+	}
+	return 0;
+}
+
+//! Computes the size of every buffer of an array; returns false for layouts the cache does not store
+static bool GetBufferSizes(const ArrowSchema &schema, const ArrowArray &array, vector<idx_t> &sizes) {
+	sizes.clear();
+	if (schema.dictionary || array.dictionary || !schema.format) {
+		return false;
+	}
+	const string format(schema.format);
+	auto rows = NumericCast<idx_t>(array.offset + array.length);
+	auto validity = (rows + 7) / 8;
+	if (format == "n") {
+		// Null arrays have no buffers
+	} else if (format == "b") {
+		sizes = {validity, validity};
+	} else if (format == "u" || format == "z" || format == "U" || format == "Z") {
+		bool large = format == "U" || format == "Z";
+		idx_t data_size = 0;
+		if (array.buffers[1]) {
+			data_size = large ? NumericCast<idx_t>(static_cast<const int64_t *>(array.buffers[1])[rows])
+			                  : NumericCast<idx_t>(static_cast<const int32_t *>(array.buffers[1])[rows]);
+		}
+		sizes = {validity, (rows + 1) * (large ? 8 : 4), data_size};
+	} else if (format == "+s" || StringUtil::StartsWith(format, "+w:")) {
+		sizes = {validity};
+	} else if (format == "+l" || format == "+m") {
+		sizes = {validity, (rows + 1) * 4};
+	} else if (format == "+L") {
+		sizes = {validity, (rows + 1) * 8};
+	} else {
+		auto width = GetFixedWidth(format);
+		if (width == 0) {
+			return false;
+		}
+		sizes = {validity, rows * width};
+	}
+	return NumericCast<idx_t>(array.n_buffers) == sizes.size() && array.n_children == schema.n_children;
+}
+
+static idx_t GetMetadataSize(const char *metadata) {
+	if (!metadata) {
+		return 0;
+	}
+	auto ptr = metadata;
+	int32_t pair_count;
+	memcpy(&pair_count, ptr, sizeof(int32_t));
+	ptr += sizeof(int32_t);
+	for (int32_t i = 0; i < pair_count * 2; i++) {
+		int32_t length;
+		memcpy(&length, ptr, sizeof(int32_t));
+		ptr += sizeof(int32_t) + length;
+	}
+	return NumericCast<idx_t>(ptr - metadata);
+}
+
+//===--------------------------------------------------------------------===//
+// Writing
+//===--------------------------------------------------------------------===//
+//! Writes a result to a temporary file as it streams by and moves it into the cache once complete
+class ResultCacheWriter {
+public:
+	ResultCacheWriter(SnowflakeResultCacheOptions options_p, string path_p)
+	    : options(std::move(options_p)), path(std::move(path_p)) {
+		static std::atomic<idx_t> temp_counter {0};
+		temp_path = path + "." + to_string(getpid()) + "." + to_string(temp_counter++) + ".tmp";
+	}
+
+	~ResultCacheWriter() {
+		if (file) {
+			fclose(file);
+		}
+		if (created && !committed) {
+			std::remove(temp_path.c_str());
+		}
+	}
+
+	bool Open(const string &key, const ArrowSchema &schema) {
+		// Results may hold anything the user can read in Snowflake, so only the user can read the entries; O_EXCL
+		// refuses to write through a file or link someone else placed at the temporary path
+		auto fd = open(temp_path.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0600);
+		if (fd < 0) {
+			return false;
+		}
+		created = true;
+		file = fdopen(fd, "wb");
+		if (!file) {
+			close(fd);
+			return false;
+		}
+		Write(RESULT_CACHE_MAGIC, sizeof(RESULT_CACHE_MAGIC));
+		WriteInteger(RESULT_CACHE_VERSION);
+		WriteInteger(CurrentUnixTime());
+		WriteString(key.c_str(), key.size());
+		WriteSchema(schema);
+		return !failed;
+	}
+
+	void Append(const ArrowSchema &schema, const ArrowArray &batch) {
+		if (failed) {
+			return;
+		}
+		Pad();
+		batch_offsets.push_back(written);
+		WriteArray(schema, batch);
+	}
+
+	void Commit() {
+		if (failed) {
+			return;
+		}
+		Pad();
+		auto index_offset = written;
+		WriteInteger(batch_offsets.size());
+		for (auto offset : batch_offsets) {
+			WriteInteger(offset);
+		}
+		WriteInteger(index_offset);
+		Write(RESULT_CACHE_MAGIC, sizeof(RESULT_CACHE_MAGIC));
+		if (failed || fclose(file) != 0) {
+			file = nullptr;
+			return;
+		}
+		file = nullptr;
+		// Readers either see the complete entry or none at all
+		if (std::rename(temp_path.c_str(), path.c_str()) == 0) {
+			committed = true;
+			DPRINT("SnowflakeResultCache: stored %llu bytes in %s\n", (unsigned long long)written, path.c_str());
+		}
+	}
+
+	bool Failed() const {
+		return failed;
+	}
+
+private:
+	void Write(const void *data, idx_t size) {
+		if (failed) {
+			return;
+		}
+		if (written + size > options.max_bytes || fwrite(data, 1, size, file) != size) {
+			// Results exceeding the budget are not cached at all
+			failed = true;
+			return;
+		}
+		written += size;
+	}
+
+	void WriteInteger(uint64_t value) {
+		Write(&value, sizeof(uint64_t));
+	}
+
+	void WriteString(const char *data, idx_t size) {
+		WriteInteger(size);
+		Write(data, size);
+	}
+
+	void Pad() {
+		static const char zeros[RESULT_CACHE_ALIGNMENT] = {};
+		auto remainder = written % RESULT_CACHE_ALIGNMENT;
+		if (remainder != 0) {
+			Write(zeros, RESULT_CACHE_ALIGNMENT - remainder);
+		}
+	}
+
+	void WriteSchema(const ArrowSchema &schema) {
+		if (schema.dictionary || !schema.format) {
+			failed = true;
+			return;
+		}
+		WriteString(schema.format, strlen(schema.format));
+		auto name = schema.name ? schema.name : "";
+		WriteString(name, strlen(name));
+		if (schema.metadata) {
+			WriteString(schema.metadata, GetMetadataSize(schema.metadata));
+		} else {
+			WriteInteger(RESULT_CACHE_NULL);
+		}
+		WriteInteger(NumericCast<uint64_t>(schema.flags));
+		WriteInteger(NumericCast<uint64_t>(schema.n_children));
+		for (int64_t i = 0; i < schema.n_children; i++) {
+			WriteSchema(*schema.children[i]);
+		}
+	}
+
+	void WriteArray(const ArrowSchema &schema, const ArrowArray &array) {
+		vector<idx_t> sizes;
+		if (!GetBufferSizes(schema, array, sizes)) {
+			failed = true;
+			return;
+		}
+		WriteInteger(NumericCast<uint64_t>(array.length));
+		WriteInteger(static_cast<uint64_t>(array.null_count));
+		WriteInteger(NumericCast<uint64_t>(array.offset));
+		WriteInteger(sizes.size());
+		WriteInteger(NumericCast<uint64_t>(array.n_children));
+		for (idx_t i = 0; i < sizes.size(); i++) {
+			if (!array.buffers[i]) {
+				WriteInteger(RESULT_CACHE_NULL);
+				continue;
+			}
+			WriteInteger(sizes[i]);
+			Pad();
+			Write(array.buffers[i], sizes[i]);
+		}
+		for (int64_t i = 0; i < array.n_children; i++) {
+			WriteArray(*schema.children[i], *array.children[i]);
+		}
+	}
+
+private:
+	SnowflakeResultCacheOptions options;
+	string path;
+	string temp_path;
+	FILE *file = nullptr;
+	idx_t written = 0;
+	bool failed = false;
+	bool created = false;
+	bool committed = false;
+	vector<uint64_t> batch_offsets;
+};
+
+//===--------------------------------------------------------------------===//
+// Reading
+//===--------------------------------------------------------------------===//
+struct MappedResultFile {
+	MappedResultFile(const data_t *data, idx_t size) : data(data), size(size) {
+	}
+	~MappedResultFile() {
+		munmap(const_cast<data_t *>(data), size);
+	}
+
+	const data_t *data;
+	idx_t size;
+};
+
+struct ResultCacheCursor {
+	ResultCacheCursor(const MappedResultFile &file, idx_t position) : file(file), position(position) {
+	}
+
+	const data_t *ReadBytes(idx_t size) {
+		if (position + size > file.size || position + size < position) {
+			throw IOException("Snowflake result cache entry is corrupt");
+		}
+		auto result = file.data + position;
+		position += size;
+		return result;
+	}
+
+	uint64_t ReadInteger() {
+		uint64_t value;
+		memcpy(&value, ReadBytes(sizeof(uint64_t)), sizeof(uint64_t));
+		return value;
+	}
+
+	string ReadString() {
+		auto size = ReadInteger();
+		return string(const_char_ptr_cast(ReadBytes(size)), size);
+	}
+
+	void Align() {
+		auto remainder = position % RESULT_CACHE_ALIGNMENT;
+		if (remainder != 0) {
+			ReadBytes(RESULT_CACHE_ALIGNMENT - remainder);
+		}
+	}
+
+	const MappedResultFile &file;
+	idx_t position;
+};
+
+struct CachedSchemaData {
+	~CachedSchemaData() {
+		for (auto &child : children) {
+			if (child.release) {
+				child.release(&child);
+			}
+		}
+	}
+
+	string format;
+	string name;
+	string metadata;
+	vector<ArrowSchema> children;
+	vector<ArrowSchema *> child_pointers;
+};
+
+static void ReleaseCachedSchema(ArrowSchema *schema) {
+	delete static_cast<CachedSchemaData *>(schema->private_data);
+	schema->release = nullptr;
+}
+
+static void ReadSchema(ResultCacheCursor &cursor, ArrowSchema &schema) {
+	auto data = make_uniq<CachedSchemaData>();
+	data->format = cursor.ReadString();
+	data->name = cursor.ReadString();
+	auto metadata_size = cursor.ReadInteger();
+	bool has_metadata = metadata_size != RESULT_CACHE_NULL;
+	if (has_metadata) {
+		data->metadata = string(const_char_ptr_cast(cursor.ReadBytes(metadata_size)), metadata_size);
+	}
+	auto flags = cursor.ReadInteger();
+	auto child_count = cursor.ReadInteger();
+	data->children.resize(child_count);
+	for (auto &child : data->children) {
+		memset(&child, 0, sizeof(ArrowSchema));
+	}
+	for (auto &child : data->children) {
+		ReadSchema(cursor, child);
+		data->child_pointers.push_back(&child);
+	}
+
+	memset(&schema, 0, sizeof(ArrowSchema));
+	schema.format = data->format.c_str();
+	schema.name = data->name.c_str();
+	schema.metadata = has_metadata ? data->metadata.c_str() : nullptr;
+	schema.flags = static_cast<int64_t>(flags);
+	schema.n_children = NumericCast<int64_t>(child_count);
+	schema.children = data->child_pointers.data();
+	schema.private_data = data.release();
+	schema.release = ReleaseCachedSchema;
+}
+
+//! Keeps the mapping alive for as long as any batch read from it is referenced
+struct CachedArrayData {
+	~CachedArrayData() {
+		for (auto &child : children) {
+			if (child.release) {
+				child.release(&child);
+			}
+		}
+	}
+
+	shared_ptr<MappedResultFile> file;
+	vector<const void *> buffers;
+	//! Stored size of every buffer, 0 for missing ones
+	vector<idx_t> sizes;
+	vector<ArrowArray> children;
+	vector<ArrowArray *> child_pointers;
+};
+
+static void ReleaseCachedArray(ArrowArray *array) {
+	delete static_cast<CachedArrayData *>(array->private_data);
+	array->release = nullptr;
+}
+
+static void ReadArray(ResultCacheCursor &cursor, const shared_ptr<MappedResultFile> &file, ArrowArray &array) {
+	auto data = make_uniq<CachedArrayData>();
+	data->file = file;
+	auto length = cursor.ReadInteger();
+	auto null_count = cursor.ReadInteger();
+	auto offset = cursor.ReadInteger();
+	auto buffer_count = cursor.ReadInteger();
+	auto child_count = cursor.ReadInteger();
+	for (idx_t i = 0; i < buffer_count; i++) {
+		auto size = cursor.ReadInteger();
+		if (size == RESULT_CACHE_NULL) {
+			data->buffers.push_back(nullptr);
+			data->sizes.push_back(0);
+			continue;
+		}
+		cursor.Align();
+		// The buffers point straight into the mapping
+		data->buffers.push_back(cursor.ReadBytes(size));
+		data->sizes.push_back(size);
+	}
+	data->children.resize(child_count);
+	for (auto &child : data->children) {
+		memset(&child, 0, sizeof(ArrowArray));
+	}
+	for (auto &child : data->children) {
+		ReadArray(cursor, file, child);
+		data->child_pointers.push_back(&child);
+	}
+
+	memset(&array, 0, sizeof(ArrowArray));
+	array.length = NumericCast<int64_t>(length);
+	array.null_count = static_cast<int64_t>(null_count);
+	array.offset = NumericCast<int64_t>(offset);
+	array.n_buffers = NumericCast<int64_t>(buffer_count);
+	array.n_children = NumericCast<int64_t>(child_count);
+	array.buffers = data->buffers.data();
+	array.children = data->child_pointers.data();
+	array.private_data = data.release();
+	array.release = ReleaseCachedArray;
+}
+
+// Checks that offsets[start..end] ascend from 0 and end within limit
+template <class T>
+static bool ValidateOffsets(const void *buffer, idx_t start, idx_t end, idx_t limit) {
+	auto offsets = static_cast<const T *>(buffer);
+	if (offsets[start] < 0) {
+		return false;
+	}
+	for (idx_t i = start; i < end; i++) {
+		if (offsets[i] > offsets[i + 1]) {
+			return false;
+		}
+	}
+	return static_cast<idx_t>(offsets[end]) <= limit;
+}
+
+//! Checks a batch read from an entry against its schema before anything reads its buffers: the buffer and child
+//! counts, each buffer's size and the offsets of variable-size layouts. The mapping itself is bounds-checked by the
+//! cursor, so this catches entries that are truncated or damaged within the file.
+static bool ValidateArray(const ArrowSchema &schema, const ArrowArray &array) {
+	auto &data = *static_cast<const CachedArrayData *>(array.private_data);
+	if (!schema.format || array.n_children != schema.n_children || array.length < 0 || array.offset < 0 ||
+	    array.length > NumericLimits<int64_t>::Maximum() - array.offset) {
+		return false;
+	}
+	const string format(schema.format);
+	auto rows = NumericCast<idx_t>(array.offset + array.length);
+	auto start = NumericCast<idx_t>(array.offset);
+	bool is_string = format == "u" || format == "z" || format == "U" || format == "Z";
+	bool is_list = format == "+l" || format == "+m" || format == "+L";
+	bool large = format == "U" || format == "Z" || format == "+L";
+	if (is_string || is_list) {
+		// GetBufferSizes reads the last offset, so the offsets are checked first
+		idx_t expected_buffers = is_string ? 3 : 2;
+		if (array.n_buffers != NumericCast<int64_t>(expected_buffers)) {
+			return false;
+		}
+		if (array.buffers[1]) {
+			if (rows + 1 > data.sizes[1] / (large ? 8 : 4)) {
+				return false;
+			}
+			idx_t limit;
+			if (is_string) {
+				limit = data.sizes[2];
+			} else {
+				auto &child = *array.children[0];
+				if (child.length < 0 || child.offset < 0) {
+					return false;
+				}
+				limit = NumericCast<idx_t>(child.offset + child.length);
+			}
+			bool valid = large ? ValidateOffsets<int64_t>(array.buffers[1], start, rows, limit)
+			                   : ValidateOffsets<int32_t>(array.buffers[1], start, rows, limit);
+			if (!valid) {
+				return false;
+			}
+		} else if (rows > 0) {
+			return false;
+		}
+	}
+	vector<idx_t> sizes;
+	if (!GetBufferSizes(schema, array, sizes)) {
+		return false;
+	}
+	for (idx_t i = 0; i < sizes.size(); i++) {
+		if (!array.buffers[i]) {
+			// Only the validity buffer may be left out, and only without nulls
+			if ((i == 0 && array.null_count > 0) || (i > 0 && sizes[i] > 0)) {
+				return false;
+			}
+		} else if (data.sizes[i] < sizes[i]) {
+			return false;
+		}
+	}
+	// Struct children hold a value per row, fixed-size list children width values per row
+	idx_t child_rows = 0;
+	if (format == "+s") {
+		child_rows = rows;
+	} else if (StringUtil::StartsWith(format, "+w:")) {
+		child_rows = rows * std::stoull(format.substr(3));
+	}
+	for (int64_t i = 0; i < array.n_children; i++) {
+		auto &child = *array.children[i];
+		if (child.length < 0 || child.offset < 0 || NumericCast<idx_t>(child.offset + child.length) < child_rows) {
+			return false;
+		}
+		if (!ValidateArray(*schema.children[i], child)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+struct CachedStreamData {
+	shared_ptr<MappedResultFile> file;
+	idx_t schema_offset;
+	vector<uint64_t> batch_offsets;
+	idx_t next_batch = 0;
+	string last_error;
+};
+
+static int CachedStreamGetSchema(ArrowArrayStream *stream, ArrowSchema *out) {
+	auto &data = *static_cast<CachedStreamData *>(stream->private_data);
+	try {
+		ResultCacheCursor cursor(*data.file, data.schema_offset);
+		ReadSchema(cursor, *out);
+		return 0;
+	} catch (std::exception &ex) {
+		data.last_error = ex.what();
+		return EIO;
+	}
+}
+
+static int CachedStreamGetNext(ArrowArrayStream *stream, ArrowArray *out) {
+	auto &data = *static_cast<CachedStreamData *>(stream->private_data);
+	if (data.next_batch >= data.batch_offsets.size()) {
+		memset(out, 0, sizeof(ArrowArray));
+		return 0;
+	}
+	try {
+		ResultCacheCursor cursor(*data.file, data.batch_offsets[data.next_batch++]);
+		ReadArray(cursor, data.file, *out);
+		return 0;
+	} catch (std::exception &ex) {
+		data.last_error = ex.what();
+		return EIO;
+	}
+}
+
+static const char *CachedStreamGetLastError(ArrowArrayStream *stream) {
+	return static_cast<CachedStreamData *>(stream->private_data)->last_error.c_str();
+}
+
+static void CachedStreamRelease(ArrowArrayStream *stream) {
+	delete static_cast<CachedStreamData *>(stream->private_data);
+	stream->release = nullptr;
+}
+
+//===--------------------------------------------------------------------===//
+// Populating
+//===--------------------------------------------------------------------===//
+struct CachingStreamData {
+	unique_ptr<ArrowArrayStreamWrapper> source;
+	ArrowSchemaWrapper schema;
+	unique_ptr<ResultCacheWriter> writer;
+	SnowflakeResultCache *cache;
+};
+
+static int CachingStreamGetSchema(ArrowArrayStream *stream, ArrowSchema *out) {
+	auto &source = static_cast<CachingStreamData *>(stream->private_data)->source->arrow_array_stream;
+	return source.get_schema(&source, out);
+}
+
+static int CachingStreamGetNext(ArrowArrayStream *stream, ArrowArray *out) {
+	auto &data = *static_cast<CachingStreamData *>(stream->private_data);
+	auto &source = data.source->arrow_array_stream;
+	auto result = source.get_next(&source, out);
+	if (result != 0) {
+		data.writer.reset();
+		return result;
+	}
+	if (!data.writer) {
+		return 0;
+	}
+	try {
+		if (!out->release) {
+			data.writer->Commit();
+			data.writer.reset();
+			data.cache->Evict();
+		} else {
+			data.writer->Append(data.schema.arrow_schema, *out);
+			if (data.writer->Failed()) {
+				data.writer.reset();
+			}
+		}
+	} catch (std::exception &ex) {
+		// Caching is best effort, the query result itself is unaffected
+		DPRINT("SnowflakeResultCache: failed to write entry: %s\n", ex.what());
+		data.writer.reset();
+	}
+	return 0;
+}
+
+static const char *CachingStreamGetLastError(ArrowArrayStream *stream) {
+	auto &source = static_cast<CachingStreamData *>(stream->private_data)->source->arrow_array_stream;
+	return source.get_last_error(&source);
+}
+
+static void CachingStreamRelease(ArrowArrayStream *stream) {
+	delete static_cast<CachingStreamData *>(stream->private_data);
+	stream->release = nullptr;
+}
+
+static void CreateDirectories(const string &directory) {
+	for (idx_t pos = 1; pos <= directory.size(); pos++) {
+		if (pos == directory.size() || directory[pos] == '/') {
+			mkdir(directory.substr(0, pos).c_str(), 0700);
+		}
+	}
+}
+
+static bool ReadCreationTime(const string &path, uint64_t &created) {
+	auto file = fopen(path.c_str(), "rb");
+	if (!file) {
+		return false;
+	}
+	char header[sizeof(RESULT_CACHE_MAGIC) + 2 * sizeof(uint64_t)];
+	auto read = fread(header, 1, sizeof(header), file);
+	fclose(file);
+	if (read != sizeof(header) || memcmp(header, RESULT_CACHE_MAGIC, sizeof(RESULT_CACHE_MAGIC)) != 0) {
+		return false;
+	}
+	memcpy(&created, header + sizeof(RESULT_CACHE_MAGIC) + sizeof(uint64_t), sizeof(uint64_t));
+	return true;
+}
+
+#endif
+
+SnowflakeResultCache::SnowflakeResultCache(SnowflakeResultCacheOptions options_p) : options(std::move(options_p)) {
+}
+
+string SnowflakeResultCache::NormalizeQuery(const string &query) {
+	string result;
+	char quote = '\0';
+	bool pending_space = false;
+	for (idx_t i = 0; i < query.size(); i++) {
+		auto c = query[i];
+		if (quote != '\0') {
+			result += c;
+			if (c == '\\' && quote == '\'' && i + 1 < query.size()) {
+				result += query[++i];
+			} else if (c == quote) {
+				quote = '\0';
+			}
+			continue;
+		}
+		if (StringUtil::CharacterIsSpace(c)) {
+			pending_space = !result.empty();
+			continue;
+		}
+		if (pending_space) {
+			result += ' ';
+			pending_space = false;
+		}
+		if (c == '\'' || c == '"') {
+			quote = c;
+		}
+		result += c;
+	}
+	return result;
+}
+
+string SnowflakeResultCache::GetKey(const SnowflakeConfig &config, const string &query) {
+	// The warehouse only affects how fast a result is computed, not the result itself
+	return "account=" + config.account + ";user=" + config.username + ";database=" + config.database +
+	       ";role=" + config.role + ";use_high_precision=" + (config.use_high_precision ? "true" : "false") +
+	       ";query=" + NormalizeQuery(query);
+}
+
+string SnowflakeResultCache::GetPath(const string &key) const {
+	auto hash = Hash(key.c_str(), key.size());
+	return options.directory + "/" + StringUtil::Format("%016llx", static_cast<unsigned long long>(hash)) +
+	       RESULT_CACHE_EXTENSION;
+}
+
+unique_ptr<ArrowArrayStreamWrapper> SnowflakeResultCache::Lookup(const string &key) {
+#ifdef _WIN32
+	return nullptr;
+#else
+	auto path = GetPath(key);
+	auto fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return nullptr;
+	}
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+		close(fd);
+		return nullptr;
+	}
+	auto size = NumericCast<idx_t>(file_stat.st_size);
+	auto mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		return nullptr;
+	}
+	auto file = make_shared_ptr<MappedResultFile>(static_cast<const data_t *>(mapping), size);
+
+	auto data = make_uniq<CachedStreamData>();
+	data->file = file;
+	try {
+		ResultCacheCursor cursor(*file, 0);
+		auto magic = cursor.ReadBytes(sizeof(RESULT_CACHE_MAGIC));
+		if (memcmp(magic, RESULT_CACHE_MAGIC, sizeof(RESULT_CACHE_MAGIC)) != 0 ||
+		    cursor.ReadInteger() != RESULT_CACHE_VERSION) {
+			return nullptr;
+		}
+		auto created = cursor.ReadInteger();
+		if (created + options.ttl_seconds < CurrentUnixTime()) {
+			DPRINT("SnowflakeResultCache: entry %s expired\n", path.c_str());
+			return nullptr;
+		}
+		if (cursor.ReadString() != key) {
+			// Hash collision with a different query
+			return nullptr;
+		}
+		data->schema_offset = cursor.position;
+
+		ResultCacheCursor trailer(*file, size - sizeof(uint64_t) - sizeof(RESULT_CACHE_MAGIC));
+		auto index_offset = trailer.ReadInteger();
+		auto trailer_magic = trailer.ReadBytes(sizeof(RESULT_CACHE_MAGIC));
+		if (memcmp(trailer_magic, RESULT_CACHE_MAGIC, sizeof(RESULT_CACHE_MAGIC)) != 0) {
+			throw IOException("Snowflake result cache entry is truncated");
+		}
+		ResultCacheCursor index(*file, index_offset);
+		auto batch_count = index.ReadInteger();
+		for (idx_t i = 0; i < batch_count; i++) {
+			data->batch_offsets.push_back(index.ReadInteger());
+		}
+
+		// The batches point straight into the mapping, so every one is checked against the schema before the scan
+		// reads any of them
+		ArrowSchemaWrapper schema;
+		ResultCacheCursor schema_cursor(*file, data->schema_offset);
+		ReadSchema(schema_cursor, schema.arrow_schema);
+		for (auto batch_offset : data->batch_offsets) {
+			ArrowArrayWrapper batch;
+			ResultCacheCursor batch_cursor(*file, batch_offset);
+			ReadArray(batch_cursor, file, batch.arrow_array);
+			if (!ValidateArray(schema.arrow_schema, batch.arrow_array)) {
+				throw IOException("Snowflake result cache entry does not match its schema");
+			}
+		}
+	} catch (std::exception &ex) {
+		// Corrupt entries would fail every later lookup as well
+		DPRINT("SnowflakeResultCache: removing entry %s: %s\n", path.c_str(), ex.what());
+		std::remove(path.c_str());
+		return nullptr;
+	}
+	// Mark the entry as recently used for the LRU eviction
+	utime(path.c_str(), nullptr);
+	DPRINT("SnowflakeResultCache: serving %llu batches from %s\n", (unsigned long long)data->batch_offsets.size(),
+	       path.c_str());
+
+	auto result = make_uniq<ArrowArrayStreamWrapper>();
+	auto &stream = result->arrow_array_stream;
+	stream.get_schema = CachedStreamGetSchema;
+	stream.get_next = CachedStreamGetNext;
+	stream.get_last_error = CachedStreamGetLastError;
+	stream.release = CachedStreamRelease;
+	stream.private_data = data.release();
+	result->number_of_rows = -1;
+	return result;
+#endif
+}
+
+unique_ptr<ArrowArrayStreamWrapper> SnowflakeResultCache::Populate(const string &key,
+                                                                   unique_ptr<ArrowArrayStreamWrapper> stream) {
+#ifdef _WIN32
+	return stream;
+#else
+	auto data = make_uniq<CachingStreamData>();
+	auto &source = stream->arrow_array_stream;
+	if (source.get_schema(&source, &data->schema.arrow_schema) != 0) {
+		return stream;
+	}
+	CreateDirectories(options.directory);
+	auto writer = make_uniq<ResultCacheWriter>(options, GetPath(key));
+	if (!writer->Open(key, data->schema.arrow_schema)) {
+		return stream;
+	}
+	data->writer = std::move(writer);
+	data->cache = this;
+	auto number_of_rows = stream->number_of_rows;
+	data->source = std::move(stream);
+
+	auto result = make_uniq<ArrowArrayStreamWrapper>();
+	auto &caching_stream = result->arrow_array_stream;
+	caching_stream.get_schema = CachingStreamGetSchema;
+	caching_stream.get_next = CachingStreamGetNext;
+	caching_stream.get_last_error = CachingStreamGetLastError;
+	caching_stream.release = CachingStreamRelease;
+	caching_stream.private_data = data.release();
+	result->number_of_rows = number_of_rows;
+	return result;
+#endif
+}
+
+void SnowflakeResultCache::Evict() {
+#ifndef _WIN32
+	struct CacheEntry {
+		string path;
+		time_t last_used;
+		idx_t size;
+	};
+	auto dir = opendir(options.directory.c_str());
+	if (!dir) {
+		return;
+	}
+	auto now = CurrentUnixTime();
+	vector<CacheEntry> entries;
+	while (auto entry = readdir(dir)) {
+		string name(entry->d_name);
+		auto path = options.directory + "/" + name;
+		struct stat file_stat;
+		if (stat(path.c_str(), &file_stat) != 0) {
+			continue;
+		}
+		if (StringUtil::EndsWith(name, ".tmp")) {
+			// Left behind by a process that died while writing
+			if (NumericCast<uint64_t>(file_stat.st_mtime) + MaxValue<idx_t>(options.ttl_seconds, 3600) < now) {
+				std::remove(path.c_str());
+			}
+			continue;
+		}
+		if (!StringUtil::EndsWith(name, RESULT_CACHE_EXTENSION)) {
+			continue;
+		}
+		uint64_t created;
+		if (!ReadCreationTime(path, created) || created + options.ttl_seconds < now) {
+			std::remove(path.c_str());
+			continue;
+		}
+		entries.push_back(CacheEntry {path, file_stat.st_mtime, NumericCast<idx_t>(file_stat.st_size)});
+	}
+	closedir(dir);
+
+	std::sort(entries.begin(), entries.end(),
+	          [](const CacheEntry &a, const CacheEntry &b) { return a.last_used > b.last_used; });
+	idx_t total_size = 0;
+	for (auto &entry : entries) {
+		total_size += entry.size;
+		if (total_size > options.max_bytes) {
+			DPRINT("SnowflakeResultCache: evicting %s\n", entry.path.c_str());
+			std::remove(entry.path.c_str());
+		}
+	}
+#endif
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,69 @@
+#include "snowflake_result_reuse.hpp"
+#include "snowflake_debug.hpp"
+#include "snowflake_semantic_cache.hpp"
+#include "duckdb/main/client_context.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+// Snowflake purges query results after 24 hours
+static constexpr idx_t RESULT_RETENTION_SECONDS = 24 * 60 * 60;
+
+SnowflakeResultReuse &SnowflakeResultReuse::Get() {
+	static SnowflakeResultReuse instance;
+	return instance;
+}
+
+bool SnowflakeResultReuse::IsEnabled(ClientContext &context, idx_t &window_seconds) {
+	Value setting;
+	if (!context.TryGetCurrentSetting("snowflake_result_reuse", setting) || setting.IsNull() ||
+	    !BooleanValue::Get(setting)) {
+		return false;
+	}
+	window_seconds = 3600;
+	if (context.TryGetCurrentSetting("snowflake_result_reuse_window", setting) && !setting.IsNull()) {
+		window_seconds = UBigIntValue::Get(setting);
+	}
+	window_seconds = MinValue(window_seconds, RESULT_RETENTION_SECONDS);
+	return window_seconds > 0;
+}
+
+string SnowflakeResultReuse::GetResultScanQuery(const string &query_id) {
+	return "SELECT * FROM TABLE(RESULT_SCAN('" + query_id + "'))";
+}
+
+bool SnowflakeResultReuse::Find(const string &key, idx_t window_seconds, SnowflakeExecutedQuery &result) {
+	lock_guard<mutex> guard(lock);
+	auto entry = queries.find(key);
+	if (entry == queries.end()) {
+		return false;
+	}
+	if (entry->second.executed_at + window_seconds < SnowflakeSemanticCache::CurrentTime()) {
+		queries.erase(entry);
+		return false;
+	}
+	result = entry->second;
+	return true;
+}
+
+void SnowflakeResultReuse::Record(const string &key, SnowflakeExecutedQuery query, idx_t window_seconds) {
+	lock_guard<mutex> guard(lock);
+	auto now = SnowflakeSemanticCache::CurrentTime();
+	for (auto entry = queries.begin(); entry != queries.end();) {
+		if (entry->second.executed_at + window_seconds < now) {
+			entry = queries.erase(entry);
+		} else {
+			entry++;
+		}
+	}
+	DPRINT("SnowflakeResultReuse: recorded query ID %s\n", query.query_id.c_str());
+	queries[key] = std::move(query);
+}
+
+void SnowflakeResultReuse::Forget(const string &key) {
+	lock_guard<mutex> guard(lock);
+	queries.erase(key);
+}
+
+} // namespace snowflake
+} // namespace duckdb
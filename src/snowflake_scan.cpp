@@ -5,16 +5,160 @@
 #include "duckdb/common/string_util.hpp"
 #include "duckdb/parser/parsed_data/create_table_function_info.hpp"
 #include "duckdb/function/table/arrow.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
 #include "snowflake_client_manager.hpp"
 #include "snowflake_arrow_utils.hpp"
 #include "snowflake_config.hpp"
 #include "snowflake_secrets.hpp"
+#include "snowflake_types.hpp"
+#include "snowflake_json.hpp"
+#include "snowflake_result_cache.hpp"
+#include "snowflake_semantic_cache.hpp"
+#include "optimizer/snowflake_expression_translator.hpp"
+#include "duckdb/planner/expression/bound_conjunction_expression.hpp"
+#include "duckdb/planner/expression/bound_reference_expression.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/planner/table_filter.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
 #include <arrow-adbc/adbc.h>
 #include "snowflake_debug.hpp"
 
+#include <chrono>
+
 namespace duckdb {
 namespace snowflake {
 
+// Returns the Snowflake type name the driver attaches to a result column, or an empty string
+static string GetSnowflakeTypeName(const ArrowSchema &schema) {
+	if (!schema.metadata) {
+		return string();
+	}
+	// Arrow metadata: int32 pair count, followed by int32-length-prefixed keys and values
+	auto read_int = [](const char *&ptr) {
+		int32_t value;
+		memcpy(&value, ptr, sizeof(int32_t));
+		ptr += sizeof(int32_t);
+		return value;
+	};
+	auto ptr = schema.metadata;
+	auto pair_count = read_int(ptr);
+	for (int32_t i = 0; i < pair_count; i++) {
+		auto key_length = read_int(ptr);
+		string key(ptr, key_length);
+		ptr += key_length;
+		auto value_length = read_int(ptr);
+		string value(ptr, value_length);
+		ptr += value_length;
+		if (key == "logicalType" || key == "DATABASE_TYPE_NAME") {
+			return value;
+		}
+	}
+	return string();
+}
+
+// Types Snowflake may ship as text: semi-structured values as JSON, vectors as "[x, y, ...]" when the driver does
+// not return them as fixed-size lists
+static bool IsTextEncodedType(const string &type_name) {
+	auto base_type = StringUtil::Upper(type_name.substr(0, type_name.find('(')));
+	StringUtil::Trim(base_type);
+	return base_type == "VARIANT" || base_type == "OBJECT" || base_type == "ARRAY" || base_type == "MAP" ||
+	       base_type == "VECTOR";
+}
+
+void SnowflakeBindSchema(ClientContext &context, SnowflakeScanBindData &bind_data, const string &source,
+                         vector<string> &names, vector<LogicalType> &return_types, idx_t inference_rows) {
+	// Get the schema from Snowflake using ADBC's ExecuteSchema
+	// This executes the query with schema-only mode to get column information
+	SnowflakeGetArrowSchema(reinterpret_cast<ArrowArrayStream *>(bind_data.factory.get()),
+	                        bind_data.schema_root.arrow_schema);
+
+	// Use DuckDB's Arrow integration to populate the table type information
+	// This converts Arrow schema to DuckDB types and handles all type mappings
+	ArrowTableFunction::PopulateArrowTableType(DBConfig::GetConfig(context), bind_data.arrow_table,
+	                                           bind_data.schema_root, names, return_types);
+
+	// Snowflake ships semi-structured values as JSON text; expose them as JSON or, for structured types, as the
+	// matching nested type. The scan converts the text while decoding.
+	vector<idx_t> untyped_columns;
+	auto &arrow_schema = bind_data.schema_root.arrow_schema;
+	for (idx_t col_idx = 0; col_idx < return_types.size(); col_idx++) {
+		auto type_name = GetSnowflakeTypeName(*arrow_schema.children[col_idx]);
+		if (return_types[col_idx].id() != LogicalTypeId::VARCHAR || !IsTextEncodedType(type_name)) {
+			continue;
+		}
+		return_types[col_idx] = SnowflakeTypeToLogicalType(type_name);
+		DPRINT("SnowflakeBindSchema: column %s (%s) mapped to %s\n", names[col_idx].c_str(), type_name.c_str(),
+		       return_types[col_idx].ToString().c_str());
+		if (return_types[col_idx].IsJSONType()) {
+			untyped_columns.push_back(col_idx);
+		}
+	}
+
+	if (inference_rows > 0 && !untyped_columns.empty()) {
+		// Infer nested types from a sample of the documents
+		string select_list;
+		for (auto col_idx : untyped_columns) {
+			if (!select_list.empty()) {
+				select_list += ", ";
+			}
+			select_list += KeywordHelper::WriteQuoted(names[col_idx], '"');
+		}
+		auto sample_query =
+		    "SELECT " + select_list + " FROM " + source + " SAMPLE (" + to_string(inference_rows) + " ROWS)";
+		auto samples = bind_data.factory->connection->ExecuteAndGetStrings(context, sample_query, {});
+		for (idx_t i = 0; i < untyped_columns.size() && i < samples.size(); i++) {
+			auto inferred = SnowflakeJSONReader::InferType(samples[i]);
+			// Top-level strings stay JSON so they keep their quotes
+			if (inferred.id() != LogicalTypeId::VARCHAR) {
+				return_types[untyped_columns[i]] = inferred;
+			}
+		}
+	}
+	bind_data.all_types = return_types;
+	bind_data.query.source = source;
+	bind_data.query.column_names = names;
+}
+
+// Parses the sample parameter of snowflake_scan: '<p>%' or '<p> PERCENT' for p percent of the rows, '<n> ROWS' for
+// n rows, drawn by Snowflake from the query result
+static void SnowflakeParseSample(ClientContext &context, const string &spec, SnowflakeQueryBuilder &query) {
+	auto text = StringUtil::Lower(spec);
+	StringUtil::Trim(text);
+	bool rows = false;
+	if (StringUtil::EndsWith(text, "%")) {
+		text = text.substr(0, text.size() - 1);
+	} else if (StringUtil::EndsWith(text, "percent")) {
+		text = text.substr(0, text.size() - 7);
+	} else if (StringUtil::EndsWith(text, "rows")) {
+		text = text.substr(0, text.size() - 4);
+		rows = true;
+	} else {
+		throw BinderException("snowflake_scan sample must be '<percentage>%%' or '<count> ROWS', got '%s'", spec);
+	}
+	StringUtil::Trim(text);
+	Value size;
+	string error;
+	if (!Value(text).TryCastAs(context, rows ? LogicalType::UBIGINT : LogicalType::DOUBLE, size, &error)) {
+		throw BinderException("snowflake_scan sample size '%s' is not a number", text);
+	}
+	if (rows) {
+		auto row_count = UBigIntValue::Get(size);
+		if (row_count > SnowflakeQueryBuilder::MAX_SAMPLE_ROWS) {
+			throw BinderException("snowflake_scan sample must be at most %llu rows, got %s",
+			                      (unsigned long long)SnowflakeQueryBuilder::MAX_SAMPLE_ROWS, text);
+		}
+		query.SetRowSample(row_count);
+		return;
+	}
+	auto percentage = DoubleValue::Get(size);
+	if (percentage < 0 || percentage > 100) {
+		throw BinderException("snowflake_scan sample percentage must be between 0 and 100, got %s", text);
+	}
+	// Block sampling needs a table, the query result is sampled by rows
+	query.SetPercentageSample(percentage, false, optional_idx());
+}
+
 static unique_ptr<FunctionData> SnowflakeScanBind(ClientContext &context, TableFunctionBindInput &input,
                                                   vector<LogicalType> &return_types, vector<string> &names) {
 	DPRINT("SnowflakeScanBind invoked\n");
@@ -55,6 +199,17 @@ static unique_ptr<FunctionData> SnowflakeScanBind(ClientContext &context, TableF
 		throw BinderException("snowflake_scan requires exactly 2 parameters: (connection_string, query) or (query, profile)");
 	}
 
+	idx_t inference_rows = 0;
+	Value inference_setting;
+	if (context.TryGetCurrentSetting("snowflake_variant_inference_rows", inference_setting) &&
+	    !inference_setting.IsNull()) {
+		inference_rows = UBigIntValue::Get(inference_setting);
+	}
+	auto inference_param = input.named_parameters.find("variant_inference_rows");
+	if (inference_param != input.named_parameters.end()) {
+		inference_rows = UBigIntValue::Get(inference_param->second);
+	}
+
 	// Get client manager
 	auto &client_manager = SnowflakeClientManager::GetInstance();
 
@@ -72,40 +227,944 @@ static unique_ptr<FunctionData> SnowflakeScanBind(ClientContext &context, TableF
 	// Create the bind data that inherits from ArrowScanFunctionData
 	// This allows us to use DuckDB's native Arrow scan implementation
 	auto bind_data = make_uniq<SnowflakeScanBindData>(std::move(factory));
-	// TODO remove below line after implementing projection pushdown
-	bind_data->projection_pushdown_enabled = false;
-
-	// Get the schema from Snowflake using ADBC's ExecuteSchema
-	// This executes the query with schema-only mode to get column information
-	SnowflakeGetArrowSchema(reinterpret_cast<ArrowArrayStream *>(bind_data->factory.get()),
-	                        bind_data->schema_root.arrow_schema);
+	SnowflakeBindSchema(context, *bind_data, "(" + query + ")", names, return_types, inference_rows);
+	auto sample_param = input.named_parameters.find("sample");
+	if (sample_param != input.named_parameters.end() && !sample_param->second.IsNull()) {
+		SnowflakeParseSample(context, StringValue::Get(sample_param->second), bind_data->query);
+	}
 
-	// Use DuckDB's Arrow integration to populate the table type information
-	// This converts Arrow schema to DuckDB types and handles all type mappings
-	ArrowTableFunction::PopulateArrowTableType(DBConfig::GetConfig(context), bind_data->arrow_table,
-	                                           bind_data->schema_root, names, return_types);
-	bind_data->all_types = return_types;
+	// DuckDB knows nothing about the size of an arbitrary query's result; ask Snowflake's compiler
+	SnowflakeQueryEstimate estimate;
+	if (SnowflakeQueryEstimates::Get().GetEstimate(context, *connection, query, estimate)) {
+		SnowflakeQueryEstimates::CheckBytesScanned(context, estimate);
+		bind_data->estimated_cardinality = estimate.EstimateRows();
+	}
 
 	DPRINT("SnowflakeScanBind returning bind data\n");
 	return std::move(bind_data);
 }
 
+SnowflakeScanGlobalState::~SnowflakeScanGlobalState() {
+	batches->StopFetcher();
+}
+
+void SnowflakeScanBatches::StartFetcher(idx_t max_ready_units_p) {
+	max_ready_units = MaxValue<idx_t>(max_ready_units_p, 1);
+	fetcher_active = true;
+	// The fetcher keeps the stream alive for as long as it may still read from it
+	auto self = shared_from_this();
+	fetcher = std::thread([self]() { self->FetchBatches(); });
+}
+
+void SnowflakeScanBatches::StopFetcher() {
+	if (!fetcher_active) {
+		return;
+	}
+	{
+		lock_guard<mutex> guard(lock);
+		cancelled = true;
+	}
+	space_available.notify_all();
+	// A fetch on the network cannot be interrupted; the fetcher notices the cancellation once it returns
+	fetcher.detach();
+}
+
+void SnowflakeScanBatches::AddBatch(unique_ptr<ArrowArrayWrapper> batch) {
+	if (!batch->arrow_array.release) {
+		// End of stream, flush whatever rows are still waiting to fill a unit
+		done = true;
+		aligner.Finalize(ready_units);
+		return;
+	}
+	if (batch->arrow_array.length == 0) {
+		return;
+	}
+	aligner.Append(std::move(batch), ready_units);
+}
+
+void SnowflakeScanBatches::FetchBatches() {
+	try {
+		while (true) {
+			{
+				unique_lock<mutex> guard(lock);
+				space_available.wait(guard, [&]() { return cancelled || ready_units.size() < max_ready_units; });
+				if (cancelled) {
+					return;
+				}
+			}
+			// Network I/O happens outside the lock so workers keep decoding while the next batch arrives
+			auto batch = stream->GetNextChunk();
+
+			lock_guard<mutex> guard(lock);
+			AddBatch(std::move(batch));
+			units_available.notify_all();
+			if (done) {
+				return;
+			}
+		}
+	} catch (std::exception &ex) {
+		lock_guard<mutex> guard(lock);
+		fetch_error = ErrorData(ex);
+		done = true;
+		units_available.notify_all();
+	}
+}
+
+bool SnowflakeScanBatches::NextUnit(ClientContext &context, SnowflakeScanUnit &unit) {
+	unique_lock<mutex> guard(lock);
+	while (ready_units.empty() && !done) {
+		if (!fetcher_active) {
+			AddBatch(stream->GetNextChunk());
+			continue;
+		}
+		// Wake up regularly, so an interrupted query does not wait for a slow fetch
+		units_available.wait_for(guard, std::chrono::milliseconds(100));
+		if (context.interrupted) {
+			throw InterruptException();
+		}
+	}
+	if (fetch_error.HasError()) {
+		fetch_error.Throw();
+	}
+	if (ready_units.empty()) {
+		return false;
+	}
+	unit = std::move(ready_units.front());
+	ready_units.pop_front();
+	space_available.notify_one();
+	return true;
+}
+
+idx_t SnowflakeScanBatches::UnitCount() {
+	lock_guard<mutex> guard(lock);
+	return aligner.UnitCount();
+}
+
+template <class GET_TARGET>
+static void SnowflakeDecodeGeneric(const SnowflakeScanGlobalState &global_state,
+                                   SnowflakeScanLocalState &local_state, GET_TARGET &&decode_target) {
+	auto &unit = local_state.unit;
+	// Units are never coalesced when generic columns are present, so there is exactly one segment
+	D_ASSERT(unit.segments.size() == 1);
+	auto &segment = unit.segments[0];
+	if (local_state.chunk != segment.batch) {
+		local_state.Reset();
+		local_state.chunk = segment.batch;
+	}
+	local_state.chunk_offset = segment.offset;
+	local_state.column_ids.clear();
+	for (auto col_idx : global_state.generic_columns) {
+		local_state.column_ids.push_back(global_state.stream_column_ids[col_idx]);
+	}
+	local_state.generic_chunk.Reset();
+	local_state.generic_chunk.SetCardinality(unit.count);
+	ArrowTableFunction::ArrowToDuckDB(local_state, global_state.stream_types.GetColumns(), local_state.generic_chunk,
+	                                  0, false);
+	for (idx_t i = 0; i < global_state.generic_columns.size(); i++) {
+		decode_target(global_state.generic_columns[i]).Reference(local_state.generic_chunk.data[i]);
+	}
+}
+
+void SnowflakeDecodeUnit(const SnowflakeScanGlobalState &global_state, SnowflakeScanLocalState &local_state,
+                         DataChunk &output) {
+	auto &unit = local_state.unit;
+	auto &staging = local_state.staging_chunk;
+	// Columns that need a type conversion are decoded into the staging chunk first
+	auto decode_target = [&](idx_t col_idx) -> Vector & {
+		auto &staging_idx = global_state.staging_index[col_idx];
+		return staging_idx.IsValid() ? staging.data[staging_idx.GetIndex()] : output.data[col_idx];
+	};
+	if (!global_state.staging_types.empty()) {
+		staging.Reset();
+	}
+
+	idx_t out_offset = 0;
+	for (auto &segment : unit.segments) {
+		for (idx_t col_idx = 0; col_idx < output.ColumnCount(); col_idx++) {
+			auto kind = global_state.decoders[col_idx];
+			if (kind == SnowflakeDecoderKind::GENERIC) {
+				continue;
+			}
+			SnowflakeDecodeColumn(kind, segment, global_state.stream_column_ids[col_idx], decode_target(col_idx),
+			                      out_offset);
+		}
+		out_offset += segment.count;
+	}
+	output.SetCardinality(unit.count);
+
+	if (!global_state.generic_columns.empty()) {
+		SnowflakeDecodeGeneric(global_state, local_state, decode_target);
+	}
+
+	for (idx_t col_idx = 0; col_idx < output.ColumnCount(); col_idx++) {
+		auto &staging_idx = global_state.staging_index[col_idx];
+		if (!staging_idx.IsValid()) {
+			continue;
+		}
+		auto &source = staging.data[staging_idx.GetIndex()];
+		auto &result = output.data[col_idx];
+		if (source.GetType().id() == LogicalTypeId::VARCHAR) {
+			// Semi-structured values: parse the JSON text straight into the nested or scalar target type
+			SnowflakeJSONReader::Convert(source, result, unit.count);
+		} else {
+			VectorOperations::DefaultCast(source, result, unit.count);
+		}
+	}
+}
+
+void SnowflakeScanSnapshot::SetQueryId(string query_id_p) {
+	lock_guard<mutex> guard(lock);
+	query_id = std::move(query_id_p);
+}
+
+string SnowflakeScanSnapshot::GetQueryId() {
+	lock_guard<mutex> guard(lock);
+	return query_id;
+}
+
+bool SnowflakeScanBindData::CanPushFilter(column_t column_id) const {
+	if (IsRowIdColumnId(column_id)) {
+		return false;
+	}
+	auto &type = all_types[column_id];
+	if (type.IsJSONType() || type.IsNested() || IsCollated(column_id)) {
+		return false;
+	}
+	if (column_id >= query.column_names.size()) {
+		// Pushed paths are VARIANT unless cast to VARCHAR
+		return type.id() == LogicalTypeId::VARCHAR;
+	}
+	// Columns whose type differs from the one Snowflake ships (e.g. inferred from VARIANT) are converted locally
+	auto &arrow_columns = arrow_table.GetColumns();
+	auto arrow_column = arrow_columns.find(column_id);
+	return arrow_column != arrow_columns.end() && arrow_column->second->GetDuckType() == type;
+}
+
+bool SnowflakeScanBindData::IsCollated(column_t column_id) const {
+	return column_id < query.column_names.size() &&
+	       collated_columns.find(query.column_names[column_id]) != collated_columns.end();
+}
+
+// Chooses the decoders for the result stream of state, whose columns are column_ids in order
+static void SnowflakeInitDecoders(ClientContext &context, const SnowflakeScanBindData &bind_data,
+                                  SnowflakeScanGlobalState &state, const vector<column_t> &column_ids) {
+	// Decoders are chosen from the schema of the stream itself rather than the bind-time schema
+	state.batches->stream->GetSchema(state.stream_schema);
+	vector<string> stream_names;
+	vector<LogicalType> stream_logical_types;
+	ArrowTableFunction::PopulateArrowTableType(DBConfig::GetConfig(context), state.stream_types,
+	                                           state.stream_schema, stream_names, stream_logical_types);
+
+	for (idx_t col_idx = 0; col_idx < column_ids.size(); col_idx++) {
+		auto column_id = column_ids[col_idx];
+		auto stream_idx = col_idx;
+		if (stream_idx >= stream_logical_types.size()) {
+			throw InternalException("snowflake_scan: column %llu is not part of the Snowflake result", column_id);
+		}
+		auto &child_schema = *state.stream_schema.arrow_schema.children[stream_idx];
+		auto kind = GetSnowflakeDecoderKind(child_schema, stream_logical_types[stream_idx]);
+		state.stream_column_ids.push_back(stream_idx);
+		state.decoders.push_back(kind);
+		if (kind == SnowflakeDecoderKind::GENERIC) {
+			state.generic_columns.push_back(col_idx);
+			state.generic_types.push_back(stream_logical_types[stream_idx]);
+		}
+
+		// JSON shares VARCHAR's representation and is decoded in place; other type changes need a conversion
+		auto &stream_type = stream_logical_types[stream_idx];
+		auto output_type =
+		    IsRowIdColumnId(column_id) ? LogicalType(LogicalType::ROW_TYPE) : bind_data.all_types[column_id];
+		bool decode_in_place = output_type == stream_type ||
+		                       (output_type.IsJSONType() && stream_type.id() == LogicalTypeId::VARCHAR);
+		if (decode_in_place) {
+			state.staging_index.emplace_back();
+		} else {
+			state.staging_index.emplace_back(state.staging_types.size());
+			state.staging_types.push_back(stream_type);
+		}
+	}
+	state.batches->aligner = SnowflakeBatchAligner(state.generic_columns.empty());
+}
+
+static void SnowflakeInitLocalChunks(Allocator &allocator, const SnowflakeScanGlobalState &global_state,
+                                     SnowflakeScanLocalState &local_state) {
+	if (!global_state.generic_types.empty()) {
+		local_state.generic_chunk.Initialize(allocator, global_state.generic_types);
+	}
+	if (!global_state.staging_types.empty()) {
+		local_state.staging_chunk.Initialize(allocator, global_state.staging_types);
+	}
+}
+
+void SnowflakeScanQuery(ClientContext &context, const SnowflakeScanBindData &bind_data, const string &query,
+                        const vector<column_t> &column_ids, const std::function<void(DataChunk &)> &callback) {
+	DPRINT("SnowflakeScanQuery: query = '%s'\n", query.c_str());
+	SnowflakeScanGlobalState state;
+	auto &batches = *state.batches;
+	batches.factory = make_uniq<SnowflakeArrowStreamFactory>(bind_data.factory->connection, query);
+	ArrowStreamParameters parameters;
+	batches.stream = SnowflakeProduceArrowScan(reinterpret_cast<uintptr_t>(batches.factory.get()), parameters);
+	SnowflakeInitDecoders(context, bind_data, state, column_ids);
+	SnowflakeScanLocalState local_state(context);
+	SnowflakeInitLocalChunks(Allocator::Get(context), state, local_state);
+
+	vector<LogicalType> types;
+	for (auto column_id : column_ids) {
+		types.push_back(bind_data.all_types[column_id]);
+	}
+	DataChunk chunk;
+	chunk.Initialize(Allocator::Get(context), types);
+	while (batches.NextUnit(context, local_state.unit)) {
+		chunk.Reset();
+		SnowflakeDecodeUnit(state, local_state, chunk);
+		callback(chunk);
+	}
+}
+
+// Runs a query and decodes its entire result into a collection, keeping the order Snowflake returns the rows in
+static unique_ptr<ColumnDataCollection> SnowflakeMaterialize(ClientContext &context,
+                                                             const SnowflakeScanBindData &bind_data,
+                                                             const string &query, const vector<column_t> &column_ids) {
+	vector<LogicalType> types;
+	for (auto column_id : column_ids) {
+		types.push_back(bind_data.all_types[column_id]);
+	}
+	// Entries outlive the client context, so they do not use its allocator
+	auto result = make_uniq<ColumnDataCollection>(Allocator::DefaultAllocator(), types);
+	SnowflakeScanQuery(context, bind_data, query, column_ids, [&](DataChunk &chunk) { result->Append(chunk); });
+	return result;
+}
+
+shared_ptr<SnowflakeSemanticCacheEntry> SnowflakeTableReplica::GetData(ClientContext &context,
+                                                                    const SnowflakeScanBindData &bind_data) {
+	// Scans starting meanwhile wait for the copy instead of fetching the table again
+	lock_guard<mutex> guard(lock);
+	if (data) {
+		return data;
+	}
+	auto result = make_shared_ptr<SnowflakeSemanticCacheEntry>();
+	vector<column_t> column_ids;
+	for (idx_t col_idx = 0; col_idx < bind_data.all_types.size(); col_idx++) {
+		column_ids.push_back(col_idx);
+		result->columns.push_back(bind_data.query.GetColumnExpression(col_idx));
+		result->types.push_back(bind_data.all_types[col_idx]);
+	}
+	result->created_at = SnowflakeSemanticCache::CurrentTime();
+	result->data = SnowflakeMaterialize(context, bind_data, bind_data.query.Build(column_ids), column_ids);
+	DPRINT("SnowflakeTableReplica: copied %llu rows of %s into memory\n", (unsigned long long)result->data->Count(),
+	       bind_data.query.source.c_str());
+	data = std::move(result);
+	return data;
+}
+
+optional_idx SnowflakeTableReplica::GetCount() {
+	lock_guard<mutex> guard(lock);
+	return data ? optional_idx(data->data->Count()) : optional_idx();
+}
+
+struct SnowflakeSemanticCacheOptions {
+	idx_t ttl_seconds = 3600;
+	idx_t max_bytes = 256ULL << 20;
+};
+
+// Fetches the columns of a scan under its Snowflake-evaluated predicate and caches them, replacing old if given
+static shared_ptr<SnowflakeSemanticCacheEntry>
+SnowflakePopulateCacheEntry(ClientContext &context, const SnowflakeScanBindData &bind_data,
+                            const vector<column_t> &column_ids, const vector<string> &remote_predicates,
+                            const SnowflakeCachePredicate &predicate, const string &last_altered,
+                            const SnowflakeSemanticCacheOptions &options,
+                            optional_ptr<SnowflakeSemanticCacheEntry> old = nullptr) {
+	auto entry = make_shared_ptr<SnowflakeSemanticCacheEntry>();
+	for (auto column_id : column_ids) {
+		entry->columns.push_back(bind_data.query.GetColumnExpression(column_id));
+		entry->types.push_back(bind_data.all_types[column_id]);
+	}
+	entry->predicate = predicate;
+	entry->remote_predicates = remote_predicates;
+	entry->last_altered = last_altered;
+	entry->created_at = SnowflakeSemanticCache::CurrentTime();
+	entry->data =
+	    SnowflakeMaterialize(context, bind_data, bind_data.query.Build(column_ids, remote_predicates), column_ids);
+	DPRINT("SnowflakeSemanticCache: cached %llu rows of %s\n", (unsigned long long)entry->data->Count(),
+	       bind_data.query.source.c_str());
+	SnowflakeSemanticCache::Get().Insert(bind_data.semantic_cache_source, entry, old, options.max_bytes);
+	return entry;
+}
+
+// Refetches the rows of an entry together with the columns it lacks and returns the new entry, which replaces it.
+// Fetching the missing columns on their own would leave nothing to pair them with the cached rows by: positions
+// differ between executions, and the table may have changed since the entry was fetched.
+static shared_ptr<SnowflakeSemanticCacheEntry>
+SnowflakeExtendCacheEntry(ClientContext &context, const SnowflakeScanBindData &bind_data,
+                          const shared_ptr<SnowflakeSemanticCacheEntry> &entry, const vector<column_t> &missing_ids,
+                          const SnowflakeSemanticCacheOptions &options) {
+	// Cached columns this scan cannot express, e.g. paths pushed down by another query, are left out
+	vector<column_t> column_ids;
+	for (idx_t col_idx = 0; col_idx < entry->columns.size(); col_idx++) {
+		for (column_t column_id = 0; column_id < bind_data.all_types.size(); column_id++) {
+			if (bind_data.query.GetColumnExpression(column_id) == entry->columns[col_idx] &&
+			    bind_data.all_types[column_id] == entry->types[col_idx]) {
+				column_ids.push_back(column_id);
+				break;
+			}
+		}
+	}
+	column_ids.insert(column_ids.end(), missing_ids.begin(), missing_ids.end());
+	DPRINT("SnowflakeSemanticCache: refetching an entry of %s with %llu more columns\n",
+	       bind_data.query.source.c_str(), (unsigned long long)missing_ids.size());
+	return SnowflakePopulateCacheEntry(context, bind_data, column_ids, entry->remote_predicates, entry->predicate,
+	                                   entry->last_altered, options, entry.get());
+}
+
+// Answers a scan from the semantic cache, fetching whatever the cache cannot provide
+static void SnowflakeInitFromSemanticCache(ClientContext &context, const SnowflakeScanBindData &bind_data,
+                                           const vector<column_t> &column_ids, const vector<string> &remote_predicates,
+                                           const SnowflakeCachePredicate &predicate,
+                                           SnowflakeScanGlobalState &state) {
+	SnowflakeSemanticCacheOptions options;
+	Value setting;
+	if (context.TryGetCurrentSetting("snowflake_semantic_cache_ttl", setting) && !setting.IsNull()) {
+		options.ttl_seconds = UBigIntValue::Get(setting);
+	}
+	if (context.TryGetCurrentSetting("snowflake_semantic_cache_max_bytes", setting) && !setting.IsNull()) {
+		options.max_bytes = UBigIntValue::Get(setting);
+	}
+
+	vector<column_t> needed_ids;
+	vector<string> columns;
+	vector<LogicalType> types;
+	for (auto column_id : column_ids) {
+		if (IsRowIdColumnId(column_id) ||
+		    std::find(needed_ids.begin(), needed_ids.end(), column_id) != needed_ids.end()) {
+			continue;
+		}
+		needed_ids.push_back(column_id);
+		columns.push_back(bind_data.query.GetColumnExpression(column_id));
+		types.push_back(bind_data.all_types[column_id]);
+	}
+
+	// Read before the rows are fetched, so a change made while they are fetched makes the entry stale
+	auto &connection = bind_data.factory->connection;
+	auto last_altered = connection->GetLastAltered(context, bind_data.table_schema, bind_data.table_name);
+	auto entry = SnowflakeSemanticCache::Get().Find(bind_data.semantic_cache_source, columns, types, predicate,
+	                                                last_altered, options.ttl_seconds);
+	if (entry) {
+		vector<column_t> missing_ids;
+		for (idx_t i = 0; i < needed_ids.size(); i++) {
+			if (!entry->GetColumn(columns[i], types[i]).IsValid()) {
+				missing_ids.push_back(needed_ids[i]);
+			}
+		}
+		DPRINT("SnowflakeSemanticCache: hit for %s, %llu columns missing\n", bind_data.query.source.c_str(),
+		       (unsigned long long)missing_ids.size());
+		if (!missing_ids.empty()) {
+			entry = SnowflakeExtendCacheEntry(context, bind_data, entry, missing_ids, options);
+		}
+	}
+	if (!entry) {
+		entry = SnowflakePopulateCacheEntry(context, bind_data, needed_ids, remote_predicates, predicate, last_altered,
+		                                    options);
+	}
+
+	state.cache_entry = std::move(entry);
+	for (auto column_id : column_ids) {
+		if (IsRowIdColumnId(column_id)) {
+			state.cache_columns.emplace_back();
+			continue;
+		}
+		state.cache_columns.push_back(state.cache_entry->GetColumn(bind_data.query.GetColumnExpression(column_id),
+		                                                           bind_data.all_types[column_id]));
+	}
+}
+
+// Executes the query of a scan, picks up its execution ahead of time, or attaches to an identical query in flight.
+// Attached-table scans can instead read the stored result of an earlier execution of the same query with RESULT_SCAN,
+// as long as the table has not changed since.
+static unique_ptr<ArrowArrayStreamWrapper> SnowflakeExecuteScanQuery(ClientContext &context,
+                                                                     const SnowflakeScanBindData &bind_data,
+                                                                     const string &query,
+                                                                     SnowflakeScanGlobalState &state) {
+	auto &connection = bind_data.factory->connection;
+	ArrowStreamParameters parameters;
+	if (bind_data.semi_join_keys) {
+		// The query may read a temporary key table, which only exists in the session of the main connection
+		state.batches->factory = make_uniq<SnowflakeArrowStreamFactory>(connection, query);
+		return SnowflakeProduceArrowScan(reinterpret_cast<uintptr_t>(state.batches->factory.get()), parameters);
+	}
+	if (!bind_data.prefetch_queries.empty()) {
+		// An earlier branch of the same UNION ALL may have executed the query already; later branches are executed
+		// ahead while this one is read
+		auto &prefetches = SnowflakeScanPrefetches::Get(context);
+		auto stream = prefetches.Take(context, connection, query, state.batches->factory);
+		prefetches.Start(connection, bind_data.prefetch_queries, SnowflakeScanPrefetches::GetMaxQueries(context));
+		if (stream) {
+			return stream;
+		}
+	}
+	idx_t window_seconds = 0;
+	// RESULT_SCAN does not promise to return rows in the order of the original query, and would repeat a sample. The
+	// LAST_ALTERED of a view does not change with the tables it reads, so only base tables are reused.
+	bool reuse_results = bind_data.is_base_table && bind_data.query.order_by.empty() &&
+	                     bind_data.query.sample.empty() && SnowflakeResultReuse::IsEnabled(context, window_seconds);
+	// A scan another scan reads the snapshot of needs the ID of the query it reads the rows of
+	bool track_query_id = reuse_results || bind_data.record_snapshot;
+	auto key = SnowflakeResultCache::GetKey(connection->GetConfig(), query);
+	auto &reuse = SnowflakeResultReuse::Get();
+	string last_altered;
+	if (reuse_results) {
+		// Read before the query runs, so a change made while it runs prevents reuse; the LAST_ALTERED of the catalog
+		// listing may predate changes made since the table was attached
+		last_altered = connection->GetLastAltered(context, bind_data.table_schema, bind_data.table_name);
+		SnowflakeExecutedQuery previous;
+		if (reuse.Find(key, window_seconds, previous)) {
+			if (last_altered == previous.last_altered) {
+				DPRINT("SnowflakeResultReuse: reading the result of query %s\n", previous.query_id.c_str());
+				state.batches->factory = make_uniq<SnowflakeArrowStreamFactory>(
+				    connection, SnowflakeResultReuse::GetResultScanQuery(previous.query_id));
+				try {
+					auto stream = SnowflakeProduceArrowScan(
+					    reinterpret_cast<uintptr_t>(state.batches->factory.get()), parameters);
+					if (bind_data.record_snapshot) {
+						bind_data.record_snapshot->SetQueryId(previous.query_id);
+					}
+					return stream;
+				} catch (std::exception &ex) {
+					// The result may have been purged early, e.g. after a role change; run the query instead
+					DPRINT("SnowflakeResultReuse: RESULT_SCAN failed: %s\n", ex.what());
+				}
+			}
+			reuse.Forget(key);
+		}
+	}
+
+	// Identical queries running at the same time, e.g. from other connections, can share one execution; a scan
+	// recording its snapshot runs its own, as only the executing scan learns the query ID
+	unique_ptr<ArrowArrayStreamWrapper> stream;
+	string query_id;
+	idx_t max_buffered_rows;
+	if (!bind_data.record_snapshot && SnowflakeSharedScans::IsEnabled(context, max_buffered_rows)) {
+		stream = SnowflakeSharedScans::Get().Open(connection, key, query, max_buffered_rows, track_query_id, query_id);
+	}
+	if (!stream) {
+		state.batches->factory = make_uniq<SnowflakeArrowStreamFactory>(connection, query);
+		state.batches->factory->track_query_id = track_query_id;
+		stream = SnowflakeProduceArrowScan(reinterpret_cast<uintptr_t>(state.batches->factory.get()), parameters);
+		query_id = state.batches->factory->query_id;
+	}
+	if (bind_data.record_snapshot) {
+		bind_data.record_snapshot->SetQueryId(query_id);
+	}
+	// Scans that attached to a query in flight leave recording it to the scan that executed it
+	if (reuse_results && !query_id.empty()) {
+		SnowflakeExecutedQuery executed;
+		executed.query_id = std::move(query_id);
+		executed.executed_at = SnowflakeSemanticCache::CurrentTime();
+		executed.last_altered = std::move(last_altered);
+		reuse.Record(key, std::move(executed), window_seconds);
+	}
+	return stream;
+}
+
+// Scans reading every row of an attached table learn the statistics of the columns they read, unless the table
+// already has statistics for all of them
+static void SnowflakeInitStatisticsCollector(ClientContext &context, const SnowflakeScanBindData &bind_data,
+                                             const vector<column_t> &column_ids, SnowflakeScanGlobalState &state) {
+	bool gather;
+	bool learn;
+	idx_t ttl_seconds;
+	if (!bind_data.statistics || bind_data.query.limit.IsValid() || bind_data.query.distinct ||
+	    !bind_data.query.qualify.empty() || !bind_data.query.sample.empty() ||
+	    !SnowflakeTableStatistics::IsEnabled(context, gather, learn, ttl_seconds) || !learn) {
+		return;
+	}
+	vector<string> names;
+	vector<string> learned_names;
+	vector<LogicalType> types;
+	for (auto column_id : column_ids) {
+		// Row ids and columns Snowflake computes are not table columns
+		bool table_column = !IsRowIdColumnId(column_id) && column_id < bind_data.query.column_names.size();
+		names.push_back(table_column ? bind_data.query.column_names[column_id] : string());
+		types.push_back(table_column ? bind_data.all_types[column_id] : LogicalType(LogicalType::ROW_TYPE));
+		if (table_column) {
+			learned_names.push_back(names.back());
+		}
+	}
+	if (!bind_data.statistics->NeedsLearning(learned_names)) {
+		return;
+	}
+	// Taken before the query runs, so a change made while it runs keeps the statistics from being recorded
+	auto last_altered = bind_data.statistics->GetLastAltered(bind_data.table_last_altered);
+	state.statistics_collector =
+	    make_uniq<SnowflakeStatisticsCollector>(bind_data.statistics, std::move(last_altered), names, types);
+}
+
+static unique_ptr<GlobalTableFunctionState> SnowflakeScanInitGlobal(ClientContext &context,
+                                                                    TableFunctionInitInput &input) {
+	auto &bind_data = input.bind_data->Cast<SnowflakeScanBindData>();
+	auto result = make_uniq<SnowflakeScanGlobalState>();
+	result->max_threads = TaskScheduler::GetScheduler(context).NumberOfThreads();
+
+	// Filters DuckDB pushed into the scan are evaluated by Snowflake where possible and on the decoded chunks
+	// otherwise. Optional filters are only hints and are skipped.
+	vector<string> remote_predicates;
+	vector<unique_ptr<Expression>> local_filters;
+	vector<unique_ptr<Expression>> all_filters;
+	SnowflakeCachePredicate predicate;
+	if (input.filters) {
+		for (auto &entry : input.filters->filters) {
+			auto &filter = *entry.second;
+			if (SnowflakeExpressionTranslator::IsOptionalFilter(filter)) {
+				continue;
+			}
+			auto position = entry.first;
+			auto column_id = input.column_ids[position];
+			auto type =
+			    IsRowIdColumnId(column_id) ? LogicalType(LogicalType::ROW_TYPE) : bind_data.all_types[column_id];
+			BoundReferenceExpression column_ref(type, position);
+			all_filters.push_back(filter.ToExpression(column_ref));
+			string column;
+			string sql;
+			if (bind_data.CanPushFilter(column_id)) {
+				column = bind_data.query.GetColumnExpression(column_id);
+			}
+			if (!column.empty() && SnowflakeExpressionTranslator::TranslateFilter(filter, column, sql)) {
+				predicate.AddFilter(column, filter, sql);
+				remote_predicates.push_back(std::move(sql));
+			} else {
+				local_filters.push_back(filter.ToExpression(column_ref));
+			}
+		}
+	}
+
+	// The local side of a join was materialized before this scan starts; restrict the query to its join keys
+	bool semi_join = false;
+	if (bind_data.semi_join_keys) {
+		auto column = bind_data.query.GetColumnExpression(bind_data.semi_join_column);
+		auto sql = bind_data.semi_join_keys->GetPredicate(context, bind_data.factory->connection, column);
+		if (!sql.empty()) {
+			DPRINT("SnowflakeScanInitGlobal: semi-join predicate %s\n", sql.substr(0, 200).c_str());
+			remote_predicates.push_back(std::move(sql));
+			semi_join = true;
+		}
+	}
+
+	// Scans of attached base tables can be answered from the semantic cache, which needs at least one real column; a
+	// scan recording its snapshot has to run a query. Entries are checked against the LAST_ALTERED of the table, which
+	// does not change for a view when the tables it reads do.
+	Value semantic_cache;
+	bool use_semantic_cache = !bind_data.replica && !bind_data.semantic_cache_source.empty() &&
+	                          bind_data.is_base_table && bind_data.query.order_by.empty() &&
+	                          !bind_data.query.limit.IsValid() && bind_data.query.predicates.empty() &&
+	                          !bind_data.query.distinct && bind_data.query.qualify.empty() &&
+	                          bind_data.query.sample.empty() && !bind_data.semi_join_keys &&
+	                          !bind_data.record_snapshot &&
+	                          context.TryGetCurrentSetting("snowflake_semantic_cache", semantic_cache) &&
+	                          !semantic_cache.IsNull() && BooleanValue::Get(semantic_cache);
+	if (use_semantic_cache) {
+		use_semantic_cache = false;
+		for (auto column_id : input.column_ids) {
+			use_semantic_cache = use_semantic_cache || !IsRowIdColumnId(column_id);
+		}
+	}
+	if (bind_data.replica) {
+		// The local copy holds every table column in order; all filters are evaluated on it
+		result->cache_entry = bind_data.replica->GetData(context, bind_data);
+		for (auto column_id : input.column_ids) {
+			result->cache_columns.push_back(IsRowIdColumnId(column_id) ? optional_idx() : optional_idx(column_id));
+		}
+		local_filters = std::move(all_filters);
+	} else if (use_semantic_cache) {
+		SnowflakeInitFromSemanticCache(context, bind_data, input.column_ids, remote_predicates, predicate, *result);
+		// Cached rows only match the predicate they were fetched under, so every filter is evaluated locally
+		local_filters = std::move(all_filters);
+	}
+	if (!local_filters.empty()) {
+		if (local_filters.size() == 1) {
+			result->local_filter = std::move(local_filters[0]);
+		} else {
+			auto conjunction = make_uniq<BoundConjunctionExpression>(ExpressionType::CONJUNCTION_AND);
+			conjunction->children = std::move(local_filters);
+			result->local_filter = std::move(conjunction);
+		}
+	}
+	if (result->cache_entry) {
+		return std::move(result);
+	}
+
+	// Only the projected (and pushed-down) columns cross the wire
+	string query;
+	if (bind_data.read_snapshot) {
+		// Reads the table as the scan recording the snapshot saw it, if that scan ran a query
+		auto query_id = bind_data.read_snapshot->GetQueryId();
+		auto snapshot_query = bind_data.query;
+		if (!query_id.empty()) {
+			snapshot_query.source += " AT(STATEMENT => " + SnowflakeQueryBuilder::QuoteString(query_id) + ")";
+		}
+		query = snapshot_query.Build(input.column_ids, remote_predicates);
+	} else {
+		query = bind_data.query.Build(input.column_ids, remote_predicates);
+	}
+	DPRINT("SnowflakeScanInitGlobal: query = '%s'\n", query.c_str());
+
+	// The first scan of a query the plan runs repeatedly spools the result, later ones replay the spool. A scan
+	// that starts while the spool is still being filled runs the query itself.
+	Value spool_setting;
+	if (bind_data.spool && context.TryGetCurrentSetting("snowflake_scan_spool", spool_setting) &&
+	    !spool_setting.IsNull() && BooleanValue::Get(spool_setting)) {
+		vector<LogicalType> types;
+		for (auto column_id : input.column_ids) {
+			types.push_back(IsRowIdColumnId(column_id) ? LogicalType(LogicalType::ROW_TYPE)
+			                                           : bind_data.all_types[column_id]);
+		}
+		bool created;
+		auto spool = SnowflakeScanSpools::Get(context).GetOrCreate(
+		    context, SnowflakeResultCache::GetKey(bind_data.factory->connection->GetConfig(), query), types, created);
+		auto spooled = created ? nullptr : spool->GetResult();
+		if (spooled) {
+			DPRINT("SnowflakeScanInitGlobal: replaying %llu spooled rows\n",
+			       (unsigned long long)spooled->data->Count());
+			result->cache_entry = std::move(spooled);
+			for (idx_t col_idx = 0; col_idx < input.column_ids.size(); col_idx++) {
+				result->cache_columns.emplace_back(col_idx);
+			}
+			return std::move(result);
+		}
+		if (created) {
+			result->spool = std::move(spool);
+		}
+	}
+	SnowflakeResultCacheOptions cache_options;
+	unique_ptr<SnowflakeResultCache> cache;
+	string cache_key;
+	// Key tables are dropped after the query, so a semi-join query cannot be answered again later; a sample is
+	// drawn anew every time. Scans recording their snapshot need a query ID, and snapshots are not read twice.
+	if (!semi_join && bind_data.query.sample.empty() && !bind_data.record_snapshot && !bind_data.read_snapshot &&
+	    SnowflakeResultCacheOptions::FromSettings(context, cache_options)) {
+		cache = make_uniq<SnowflakeResultCache>(std::move(cache_options));
+		cache_key = SnowflakeResultCache::GetKey(bind_data.factory->connection->GetConfig(), query);
+		result->batches->stream = cache->Lookup(cache_key);
+	}
+	if (!result->batches->stream) {
+		// Results served by the result cache may predate the table's current state, so only fresh results teach
+		// statistics
+		if (remote_predicates.empty() && bind_data.query.predicates.empty() && !bind_data.semi_join_keys) {
+			SnowflakeInitStatisticsCollector(context, bind_data, input.column_ids, *result);
+		}
+		auto &batches = *result->batches;
+		batches.stream = SnowflakeExecuteScanQuery(context, bind_data, query, *result);
+		if (cache) {
+			batches.cache = std::move(cache);
+			batches.stream = batches.cache->Populate(cache_key, std::move(batches.stream));
+		}
+	}
+	SnowflakeInitDecoders(context, bind_data, *result, input.column_ids);
+
+	// Even when the query yields a single stream, decoding can be spread over all threads: one fetcher thread
+	// pulls the record batches and every worker converts the units it hands out. Each unit carries its batch
+	// index, so DuckDB only pays for re-ordering when the plan actually needs insertion order.
+	Value parallel_decode;
+	if (context.TryGetCurrentSetting("snowflake_parallel_decode", parallel_decode) && !parallel_decode.IsNull() &&
+	    BooleanValue::Get(parallel_decode) && result->max_threads > 1) {
+		Value prefetch;
+		idx_t max_ready_units = result->max_threads * 2;
+		if (context.TryGetCurrentSetting("snowflake_prefetch_units", prefetch) && !prefetch.IsNull()) {
+			max_ready_units = UBigIntValue::Get(prefetch);
+		}
+		result->batches->StartFetcher(max_ready_units);
+	}
+	DPRINT("SnowflakeScanInitGlobal: %zu columns, %zu generic, %zu converted\n", result->decoders.size(),
+	       result->generic_columns.size(), result->staging_types.size());
+	return std::move(result);
+}
+
+static unique_ptr<LocalTableFunctionState> SnowflakeScanInitLocal(ExecutionContext &context,
+                                                                  TableFunctionInitInput &input,
+                                                                  GlobalTableFunctionState *global_state_p) {
+	auto &global_state = global_state_p->Cast<SnowflakeScanGlobalState>();
+	auto result = make_uniq<SnowflakeScanLocalState>(context.client);
+	SnowflakeInitLocalChunks(Allocator::Get(context.client), global_state, *result);
+	if (global_state.cache_entry) {
+		result->cache_chunk.Initialize(Allocator::Get(context.client), global_state.cache_entry->types);
+	}
+	if (global_state.local_filter) {
+		result->filter_executor = make_uniq<ExpressionExecutor>(context.client, *global_state.local_filter);
+		result->filter_sel.Initialize(STANDARD_VECTOR_SIZE);
+	}
+	return std::move(result);
+}
+
+// Emits the next chunk of the semantic cache entry, returns false once all chunks have been handed out
+static bool SnowflakeScanCacheEntry(SnowflakeScanGlobalState &global_state, SnowflakeScanLocalState &local_state,
+                                    DataChunk &output) {
+	auto &data = *global_state.cache_entry->data;
+	auto chunk_idx = global_state.next_cache_chunk++;
+	if (chunk_idx >= data.ChunkCount()) {
+		return false;
+	}
+	local_state.cache_chunk.Reset();
+	data.FetchChunk(chunk_idx, local_state.cache_chunk);
+	for (idx_t col_idx = 0; col_idx < output.ColumnCount(); col_idx++) {
+		auto &cache_column = global_state.cache_columns[col_idx];
+		if (cache_column.IsValid()) {
+			output.data[col_idx].Reference(local_state.cache_chunk.data[cache_column.GetIndex()]);
+		} else {
+			output.data[col_idx].Reference(Value::BIGINT(0));
+		}
+	}
+	output.SetCardinality(local_state.cache_chunk.size());
+	local_state.batch_index = chunk_idx;
+	return true;
+}
+
+static void SnowflakeScanFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+	auto &global_state = data_p.global_state->Cast<SnowflakeScanGlobalState>();
+	auto &local_state = data_p.local_state->Cast<SnowflakeScanLocalState>();
+	while (true) {
+		if (global_state.cache_entry) {
+			if (!SnowflakeScanCacheEntry(global_state, local_state, output)) {
+				return;
+			}
+		} else {
+			if (!global_state.batches->NextUnit(context, local_state.unit)) {
+				if (global_state.spool) {
+					global_state.spool->SetUnitCount(global_state.batches->UnitCount());
+				}
+				if (global_state.statistics_collector) {
+					global_state.statistics_collector->SetUnitCount(global_state.batches->UnitCount());
+				}
+				return;
+			}
+			local_state.batch_index = local_state.unit.batch_index;
+			SnowflakeDecodeUnit(global_state, local_state, output);
+			// Statistics describe the table, so they are learned before local filters apply
+			if (global_state.statistics_collector) {
+				global_state.statistics_collector->Update(output);
+			}
+			if (global_state.spool) {
+				global_state.spool->Append(local_state.unit.batch_index, output);
+			}
+		}
+		if (!local_state.filter_executor) {
+			return;
+		}
+		auto count = local_state.filter_executor->SelectExpression(output, local_state.filter_sel);
+		if (count == output.size()) {
+			return;
+		}
+		if (count > 0) {
+			output.Slice(local_state.filter_sel, count);
+			return;
+		}
+		// An empty chunk would end the scan, continue with the next unit instead
+		output.Reset();
+	}
+}
+
+// Filter expressions DuckDB cannot turn into table filters (functions, comparisons between columns, OR over several
+// columns) are translated to Snowflake SQL where possible and applied by every query of the scan. The rest stay in
+// the plan and are evaluated locally.
+static void SnowflakeScanPushdownComplexFilter(ClientContext &context, LogicalGet &get, FunctionData *bind_data_p,
+                                               vector<unique_ptr<Expression>> &filters) {
+	auto &bind_data = bind_data_p->Cast<SnowflakeScanBindData>();
+	if (bind_data.replica) {
+		return;
+	}
+	auto &column_ids = get.GetColumnIds();
+	SnowflakeExpressionTranslator translator([&](const ColumnBinding &binding, string &result) {
+		if (binding.table_index != get.table_index || binding.column_index >= column_ids.size()) {
+			return false;
+		}
+		auto column_id = column_ids[binding.column_index].GetPrimaryIndex();
+		if (!bind_data.CanPushFilter(column_id)) {
+			return false;
+		}
+		result = bind_data.query.GetColumnExpression(column_id);
+		return true;
+	});
+	for (idx_t i = 0; i < filters.size(); i++) {
+		string sql;
+		if (SnowflakeExpressionTranslator::IsTableFilterCandidate(*filters[i]) ||
+		    !translator.Translate(*filters[i], sql)) {
+			continue;
+		}
+		DPRINT("SnowflakeScanPushdownComplexFilter: pushing %s\n", sql.c_str());
+		bind_data.query.predicates.push_back(std::move(sql));
+		filters.erase_at(i);
+		i--;
+	}
+}
+
+static unique_ptr<NodeStatistics> SnowflakeScanCardinality(ClientContext &context, const FunctionData *bind_data_p) {
+	auto &bind_data = bind_data_p->Cast<SnowflakeScanBindData>();
+	idx_t cardinality;
+	if (bind_data.replica && bind_data.replica->GetCount().IsValid()) {
+		cardinality = bind_data.replica->GetCount().GetIndex();
+	} else if (bind_data.statistics && bind_data.statistics->GetRowCount().IsValid()) {
+		// Counted by an earlier scan or statistics query, which is more recent than the catalog listing
+		cardinality = bind_data.statistics->GetRowCount().GetIndex();
+	} else if (bind_data.estimated_cardinality.IsValid()) {
+		cardinality = bind_data.estimated_cardinality.GetIndex();
+	} else {
+		return nullptr;
+	}
+	if (!bind_data.query.predicates.empty()) {
+		// DuckDB no longer sees the pushed-down filters; assume its default selectivity of 20%
+		cardinality = MaxValue<idx_t>(cardinality / 5, 1);
+	}
+	cardinality = MaxValue<idx_t>(idx_t(double(cardinality) * bind_data.query.sample_fraction), 1);
+	if (bind_data.query.sample_rows.IsValid()) {
+		cardinality = MinValue(cardinality, bind_data.query.sample_rows.GetIndex());
+	}
+	if (bind_data.query.limit.IsValid()) {
+		cardinality = MinValue(cardinality, bind_data.query.limit.GetIndex());
+	}
+	return make_uniq<NodeStatistics>(cardinality, cardinality);
+}
+
+static unique_ptr<BaseStatistics> SnowflakeScanStatistics(ClientContext &context, const FunctionData *bind_data_p,
+                                                          column_t column_id) {
+	auto &bind_data = bind_data_p->Cast<SnowflakeScanBindData>();
+	// Pushed columns are computed by Snowflake and have no statistics of their own
+	if (!bind_data.statistics || IsRowIdColumnId(column_id) || column_id >= bind_data.query.column_names.size()) {
+		return nullptr;
+	}
+	auto &names = bind_data.query.column_names;
+	vector<LogicalType> types(bind_data.all_types.begin(),
+	                          bind_data.all_types.begin() + NumericCast<int64_t>(names.size()));
+	return bind_data.statistics->GetColumn(context, names, types, column_id);
+}
+
+static OperatorPartitionData SnowflakeScanGetPartitionData(ClientContext &context,
+                                                           TableFunctionGetPartitionInput &input) {
+	if (input.partition_info.RequiresPartitionColumns()) {
+		throw InternalException("snowflake_scan::GetPartitionData: partition columns not supported");
+	}
+	auto &local_state = input.local_state->Cast<SnowflakeScanLocalState>();
+	return OperatorPartitionData(local_state.batch_index);
+}
+
 } // namespace snowflake
 
 TableFunction GetSnowflakeScanFunction() {
-	// Create a table function that uses DuckDB's native Arrow scan implementation
-	// We only provide our own bind function to set up the Snowflake connection
-	// All other operations (init_global, init_local, scan) use DuckDB's implementation
+	// snowflake_scan uses its own scan on top of DuckDB's Arrow schema handling: record batches are re-aligned to
+	// STANDARD_VECTOR_SIZE and decoded with per-type specialized decoders, falling back to DuckDB's Arrow
+	// conversion only for types the decoders do not cover
 	// Parameters: (connection_string, query) or (query, profile)
 	TableFunction snowflake_scan("snowflake_scan", {LogicalType::VARCHAR, LogicalType::VARCHAR},
-	                             ArrowTableFunction::ArrowScanFunction,   // Use DuckDB's scan
-	                             snowflake::SnowflakeScanBind,            // Our bind function
-	                             ArrowTableFunction::ArrowScanInitGlobal, // Use DuckDB's init
-	                             ArrowTableFunction::ArrowScanInitLocal); // Use DuckDB's init
-
-	// TODO Enable projection and filter pushdown for optimization
-	snowflake_scan.projection_pushdown = false;
-	snowflake_scan.filter_pushdown = false;
+	                             snowflake::SnowflakeScanFunction, snowflake::SnowflakeScanBind,
+	                             snowflake::SnowflakeScanInitGlobal, snowflake::SnowflakeScanInitLocal);
+	snowflake_scan.get_partition_data = snowflake::SnowflakeScanGetPartitionData;
+	snowflake_scan.cardinality = snowflake::SnowflakeScanCardinality;
+	snowflake_scan.statistics = snowflake::SnowflakeScanStatistics;
+	snowflake_scan.pushdown_complex_filter = snowflake::SnowflakeScanPushdownComplexFilter;
+	// Number of sampled rows used to infer nested types for VARIANT/OBJECT/ARRAY columns (0: expose them as JSON)
+	snowflake_scan.named_parameters["variant_inference_rows"] = LogicalType::UBIGINT;
+	// Sample Snowflake draws from the query result: '<percentage>%' or '<count> ROWS'
+	snowflake_scan.named_parameters["sample"] = LogicalType::VARCHAR;
+
+	snowflake_scan.projection_pushdown = true;
+	// Filters are sent to Snowflake where they translate and applied to the decoded chunks otherwise
+	snowflake_scan.filter_pushdown = true;
 
 	return snowflake_scan;
 }
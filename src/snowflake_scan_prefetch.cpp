@@ -0,0 +1,144 @@
+#include "snowflake_scan_prefetch.hpp"
+#include "snowflake_debug.hpp"
+#include "snowflake_result_cache.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/main/client_context.hpp"
+
+#include <chrono>
+#include <cstring>
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakeScanPrefetches &SnowflakeScanPrefetches::Get(ClientContext &context) {
+	return *context.registered_state->GetOrCreate<SnowflakeScanPrefetches>("snowflake_scan_prefetches");
+}
+
+idx_t SnowflakeScanPrefetches::GetMaxQueries(ClientContext &context) {
+	Value setting;
+	if (!context.TryGetCurrentSetting("snowflake_union_prefetch", setting) || setting.IsNull()) {
+		return 0;
+	}
+	return UBigIntValue::Get(setting);
+}
+
+unique_ptr<ArrowArrayStreamWrapper> SnowflakeScanPrefetches::Take(ClientContext &context,
+                                                                  const shared_ptr<SnowflakeClient> &connection,
+                                                                  const string &query,
+                                                                  unique_ptr<SnowflakeArrowStreamFactory> &factory) {
+	auto key = SnowflakeResultCache::GetKey(connection->GetConfig(), query);
+	shared_ptr<SnowflakePrefetchedQuery> prefetched;
+	{
+		lock_guard<mutex> guard(lock);
+		seen.insert(key);
+		auto entry = pending.find(key);
+		if (entry == pending.end()) {
+			return nullptr;
+		}
+		prefetched = std::move(entry->second);
+		pending.erase(entry);
+	}
+	unique_lock<mutex> guard(prefetched->lock);
+	// The wait is woken up now and then to notice an interrupt; the execution itself is cancelled when the query ends
+	while (!prefetched->executed.wait_for(guard, std::chrono::milliseconds(100), [&]() { return prefetched->done; })) {
+		if (context.interrupted) {
+			throw InterruptException();
+		}
+	}
+	if (!prefetched->stream) {
+		return nullptr;
+	}
+	DPRINT("SnowflakeScanPrefetches: reading the result executed ahead\n");
+	factory = std::move(prefetched->factory);
+	return std::move(prefetched->stream);
+}
+
+void SnowflakeScanPrefetches::Start(const shared_ptr<SnowflakeClient> &connection, const vector<string> &queries,
+                                    idx_t max_queries) {
+	lock_guard<mutex> guard(lock);
+	for (auto &query : queries) {
+		if (pending.size() >= max_queries) {
+			break;
+		}
+		auto key = SnowflakeResultCache::GetKey(connection->GetConfig(), query);
+		if (seen.find(key) != seen.end()) {
+			continue;
+		}
+		seen.insert(key);
+		auto prefetched = make_shared_ptr<SnowflakePrefetchedQuery>();
+		prefetched->factory = make_uniq<SnowflakeArrowStreamFactory>(connection, query);
+		pending[key] = prefetched;
+		started.push_back(prefetched);
+		DPRINT("SnowflakeScanPrefetches: executing ahead '%s'\n", query.c_str());
+		threads.emplace_back([prefetched]() {
+			auto &factory = *prefetched->factory;
+			ArrowStreamParameters parameters;
+			unique_ptr<ArrowArrayStreamWrapper> stream;
+			try {
+				{
+					// The statement is created under the lock, so the end of the query either cancels it or keeps
+					// it from being executed at all
+					lock_guard<mutex> guard(prefetched->lock);
+					if (prefetched->cancelled) {
+						throw InterruptException();
+					}
+					factory.pooled_connection = factory.connection->AcquirePooledConnection();
+					AdbcError error;
+					std::memset(&error, 0, sizeof(error));
+					if (AdbcStatementNew(factory.pooled_connection, &factory.statement, &error) != ADBC_STATUS_OK) {
+						throw IOException("Failed to create statement");
+					}
+					factory.statement_initialized = true;
+					if (AdbcStatementSetSqlQuery(&factory.statement, factory.query.c_str(), &error) != ADBC_STATUS_OK) {
+						if (error.release) {
+							error.release(&error);
+						}
+						throw IOException("Failed to set query");
+					}
+				}
+				stream = SnowflakeProduceArrowScan(reinterpret_cast<uintptr_t>(&factory), parameters);
+			} catch (std::exception &ex) {
+				// The scan executes the query itself, and reports the error if it fails again
+				DPRINT("SnowflakeScanPrefetches: execution failed: %s\n", ex.what());
+			}
+			lock_guard<mutex> guard(prefetched->lock);
+			prefetched->stream = std::move(stream);
+			prefetched->done = true;
+			prefetched->executed.notify_all();
+		});
+	}
+}
+
+SnowflakeScanPrefetches::~SnowflakeScanPrefetches() {
+	CancelAll();
+}
+
+void SnowflakeScanPrefetches::QueryEnd() {
+	CancelAll();
+}
+
+void SnowflakeScanPrefetches::CancelAll() {
+	lock_guard<mutex> guard(lock);
+	DPRINT("SnowflakeScanPrefetches: dropping %zu results executed ahead\n", pending.size());
+	for (auto &prefetched : started) {
+		lock_guard<mutex> query_guard(prefetched->lock);
+		prefetched->cancelled = true;
+		if (!prefetched->done && prefetched->factory && prefetched->factory->statement_initialized) {
+			AdbcError error;
+			std::memset(&error, 0, sizeof(error));
+			if (AdbcStatementCancel(&prefetched->factory->statement, &error) != ADBC_STATUS_OK && error.release) {
+				error.release(&error);
+			}
+		}
+	}
+	for (auto &thread : threads) {
+		thread.join();
+	}
+	threads.clear();
+	started.clear();
+	pending.clear();
+	seen.clear();
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,77 @@
+#include "snowflake_scan_spool.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/main/client_context.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakeScanSpool::SnowflakeScanSpool(ClientContext &context, const vector<LogicalType> &types)
+    : buffer_manager(BufferManager::GetBufferManager(context)) {
+	result = make_shared_ptr<SnowflakeSemanticCacheEntry>();
+	result->types = types;
+	result->data = make_uniq<ColumnDataCollection>(buffer_manager, types);
+	result->data->InitializeAppend(append_state);
+}
+
+void SnowflakeScanSpool::AppendInOrder(DataChunk &chunk) {
+	result->data->Append(append_state, chunk);
+	next_batch_index++;
+}
+
+void SnowflakeScanSpool::Append(idx_t batch_index, DataChunk &chunk) {
+	lock_guard<mutex> guard(lock);
+	if (batch_index != next_batch_index) {
+		auto unit = make_uniq<ColumnDataCollection>(buffer_manager, chunk.GetTypes());
+		unit->Append(chunk);
+		pending[batch_index] = std::move(unit);
+		return;
+	}
+	AppendInOrder(chunk);
+	while (!pending.empty() && pending.begin()->first == next_batch_index) {
+		for (auto &unit_chunk : pending.begin()->second->Chunks()) {
+			result->data->Append(append_state, unit_chunk);
+		}
+		next_batch_index++;
+		pending.erase(pending.begin());
+	}
+}
+
+void SnowflakeScanSpool::SetUnitCount(idx_t unit_count_p) {
+	lock_guard<mutex> guard(lock);
+	unit_count = unit_count_p;
+}
+
+shared_ptr<SnowflakeSemanticCacheEntry> SnowflakeScanSpool::GetResult() {
+	lock_guard<mutex> guard(lock);
+	if (!unit_count.IsValid() || next_batch_index != unit_count.GetIndex()) {
+		return nullptr;
+	}
+	return result;
+}
+
+SnowflakeScanSpools &SnowflakeScanSpools::Get(ClientContext &context) {
+	return *context.registered_state->GetOrCreate<SnowflakeScanSpools>("snowflake_scan_spools");
+}
+
+shared_ptr<SnowflakeScanSpool> SnowflakeScanSpools::GetOrCreate(ClientContext &context, const string &key,
+                                                                const vector<LogicalType> &types, bool &created) {
+	lock_guard<mutex> guard(lock);
+	auto entry = spools.find(key);
+	if (entry != spools.end()) {
+		created = false;
+		return entry->second;
+	}
+	created = true;
+	auto spool = make_shared_ptr<SnowflakeScanSpool>(context, types);
+	spools[key] = spool;
+	return spool;
+}
+
+void SnowflakeScanSpools::QueryEnd() {
+	lock_guard<mutex> guard(lock);
+	DPRINT("SnowflakeScanSpools: releasing %zu spools\n", spools.size());
+	spools.clear();
+}
+
+} // namespace snowflake
+} // namespace duckdb
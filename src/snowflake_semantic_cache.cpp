@@ -0,0 +1,222 @@
+#include "snowflake_semantic_cache.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/planner/filter/conjunction_filter.hpp"
+#include "duckdb/planner/filter/constant_filter.hpp"
+#include "duckdb/planner/table_filter.hpp"
+
+#include <chrono>
+
+namespace duckdb {
+namespace snowflake {
+
+bool SnowflakeColumnRange::Intersect(const TableFilter &filter) {
+	switch (filter.filter_type) {
+	case TableFilterType::IS_NOT_NULL:
+		not_null = true;
+		return true;
+	case TableFilterType::CONJUNCTION_AND: {
+		auto narrowed = *this;
+		for (auto &child : filter.Cast<ConjunctionAndFilter>().child_filters) {
+			if (!narrowed.Intersect(*child)) {
+				return false;
+			}
+		}
+		*this = std::move(narrowed);
+		return true;
+	}
+	case TableFilterType::CONSTANT_COMPARISON: {
+		auto &constant_filter = filter.Cast<ConstantFilter>();
+		auto &constant = constant_filter.constant;
+		if (constant.IsNull()) {
+			return false;
+		}
+		auto comparison = constant_filter.comparison_type;
+		bool lower_bound = comparison == ExpressionType::COMPARE_GREATERTHAN ||
+		                   comparison == ExpressionType::COMPARE_GREATERTHANOREQUALTO ||
+		                   comparison == ExpressionType::COMPARE_EQUAL;
+		bool upper_bound = comparison == ExpressionType::COMPARE_LESSTHAN ||
+		                   comparison == ExpressionType::COMPARE_LESSTHANOREQUALTO ||
+		                   comparison == ExpressionType::COMPARE_EQUAL;
+		if (!lower_bound && !upper_bound) {
+			return false;
+		}
+		bool inclusive = comparison != ExpressionType::COMPARE_GREATERTHAN &&
+		                 comparison != ExpressionType::COMPARE_LESSTHAN;
+		if (lower_bound && (lower.IsNull() || constant > lower || (constant == lower && !inclusive))) {
+			lower = constant;
+			lower_inclusive = inclusive;
+		}
+		if (upper_bound && (upper.IsNull() || constant < upper || (constant == upper && !inclusive))) {
+			upper = constant;
+			upper_inclusive = inclusive;
+		}
+		// Comparisons never hold for NULL
+		not_null = true;
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+bool SnowflakeColumnRange::Contains(const SnowflakeColumnRange &other) const {
+	if (not_null && !other.not_null) {
+		return false;
+	}
+	if (!lower.IsNull()) {
+		if (other.lower.IsNull() || other.lower.type() != lower.type() || other.lower < lower) {
+			return false;
+		}
+		if (other.lower == lower && !lower_inclusive && other.lower_inclusive) {
+			return false;
+		}
+	}
+	if (!upper.IsNull()) {
+		if (other.upper.IsNull() || other.upper.type() != upper.type() || other.upper > upper) {
+			return false;
+		}
+		if (other.upper == upper && !upper_inclusive && other.upper_inclusive) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void SnowflakeCachePredicate::AddFilter(const string &column, const TableFilter &filter, const string &sql) {
+	auto range = ranges[column];
+	if (range.Intersect(filter)) {
+		ranges[column] = std::move(range);
+		return;
+	}
+	if (ranges[column].lower.IsNull() && ranges[column].upper.IsNull() && !ranges[column].not_null) {
+		ranges.erase(column);
+	}
+	terms.insert(sql);
+}
+
+bool SnowflakeCachePredicate::Implies(const SnowflakeCachePredicate &other) const {
+	for (auto &entry : other.ranges) {
+		auto range = ranges.find(entry.first);
+		if (range == ranges.end() || !entry.second.Contains(range->second)) {
+			return false;
+		}
+	}
+	for (auto &term : other.terms) {
+		if (terms.find(term) == terms.end()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+optional_idx SnowflakeSemanticCacheEntry::GetColumn(const string &column, const LogicalType &type) const {
+	for (idx_t i = 0; i < columns.size(); i++) {
+		if (columns[i] == column && types[i] == type) {
+			return i;
+		}
+	}
+	return optional_idx();
+}
+
+SnowflakeSemanticCache &SnowflakeSemanticCache::Get() {
+	static SnowflakeSemanticCache instance;
+	return instance;
+}
+
+uint64_t SnowflakeSemanticCache::CurrentTime() {
+	return NumericCast<uint64_t>(
+	    std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+shared_ptr<SnowflakeSemanticCacheEntry> SnowflakeSemanticCache::Find(const string &source,
+                                                                     const vector<string> &columns,
+                                                                     const vector<LogicalType> &types,
+                                                                     const SnowflakeCachePredicate &predicate,
+                                                                     const string &last_altered,
+                                                                     idx_t ttl_seconds) {
+	lock_guard<mutex> guard(lock);
+	auto source_entries = entries.find(source);
+	if (source_entries == entries.end()) {
+		return nullptr;
+	}
+	auto now = CurrentTime();
+	auto &candidates = source_entries->second;
+	shared_ptr<SnowflakeSemanticCacheEntry> result;
+	idx_t result_columns = 0;
+	for (idx_t i = 0; i < candidates.size(); i++) {
+		auto &entry = candidates[i];
+		if (entry->created_at + ttl_seconds < now) {
+			DPRINT("SnowflakeSemanticCache: dropping expired entry for %s\n", source.c_str());
+			candidates.erase(candidates.begin() + NumericCast<int64_t>(i));
+			i--;
+			continue;
+		}
+		if (entry->last_altered != last_altered) {
+			DPRINT("SnowflakeSemanticCache: dropping entry for %s, the table changed since\n", source.c_str());
+			candidates.erase(candidates.begin() + NumericCast<int64_t>(i));
+			i--;
+			continue;
+		}
+		if (!predicate.Implies(entry->predicate)) {
+			continue;
+		}
+		idx_t covered = 0;
+		for (idx_t col_idx = 0; col_idx < columns.size(); col_idx++) {
+			if (entry->GetColumn(columns[col_idx], types[col_idx]).IsValid()) {
+				covered++;
+			}
+		}
+		if (!result || covered > result_columns) {
+			result = entry;
+			result_columns = covered;
+		}
+	}
+	if (result) {
+		result->last_used = now;
+	}
+	return result;
+}
+
+void SnowflakeSemanticCache::Insert(const string &source, shared_ptr<SnowflakeSemanticCacheEntry> entry,
+                                    optional_ptr<SnowflakeSemanticCacheEntry> old, idx_t max_bytes) {
+	lock_guard<mutex> guard(lock);
+	if (entry->data->SizeInBytes() > max_bytes) {
+		return;
+	}
+	entry->last_used = CurrentTime();
+	auto &source_entries = entries[source];
+	for (idx_t i = 0; i < source_entries.size(); i++) {
+		if (source_entries[i].get() == old.get()) {
+			source_entries.erase(source_entries.begin() + NumericCast<int64_t>(i));
+			break;
+		}
+	}
+	source_entries.push_back(std::move(entry));
+
+	// Evict least recently used entries across all tables until the cache fits
+	while (true) {
+		idx_t total_size = 0;
+		optional_ptr<vector<shared_ptr<SnowflakeSemanticCacheEntry>>> lru_entries;
+		idx_t lru_index = 0;
+		uint64_t lru_time = NumericLimits<uint64_t>::Maximum();
+		for (auto &cached : entries) {
+			for (idx_t i = 0; i < cached.second.size(); i++) {
+				auto &candidate = *cached.second[i];
+				total_size += candidate.data->SizeInBytes();
+				if (candidate.last_used < lru_time) {
+					lru_time = candidate.last_used;
+					lru_entries = &cached.second;
+					lru_index = i;
+				}
+			}
+		}
+		if (total_size <= max_bytes || !lru_entries) {
+			break;
+		}
+		DPRINT("SnowflakeSemanticCache: evicting an entry (%llu bytes cached)\n", (unsigned long long)total_size);
+		lru_entries->erase(lru_entries->begin() + NumericCast<int64_t>(lru_index));
+	}
+}
+
+} // namespace snowflake
+} // namespace duckdb
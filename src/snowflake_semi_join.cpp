@@ -0,0 +1,318 @@
+#include "snowflake_semi_join.hpp"
+#include "snowflake_client.hpp"
+#include "snowflake_debug.hpp"
+#include "snowflake_query_builder.hpp"
+#include "optimizer/snowflake_expression_translator.hpp"
+#include "duckdb/common/arrow/result_arrow_wrapper.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/common/types/column/column_data_collection.hpp"
+#include "duckdb/common/types/uuid.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/physical_plan_generator.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/materialized_query_result.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+
+namespace duckdb {
+namespace snowflake {
+
+// Up to this many keys are sent as an IN list, more are shipped to a temporary table
+static constexpr idx_t MAX_IN_LIST_KEYS = 1000;
+// Rows per record batch of the ingested key stream
+static constexpr idx_t INGEST_BATCH_ROWS = 100 * STANDARD_VECTOR_SIZE;
+static constexpr const char *KEY_COLUMN = "K";
+
+SnowflakeSemiJoinKeys::SnowflakeSemiJoinKeys(LogicalType type_p, idx_t max_keys)
+    : type(std::move(type_p)), max_keys(max_keys) {
+}
+
+bool SnowflakeSemiJoinKeys::IsSupportedType(const LogicalType &type) {
+	switch (type.id()) {
+	case LogicalTypeId::TINYINT:
+	case LogicalTypeId::SMALLINT:
+	case LogicalTypeId::INTEGER:
+	case LogicalTypeId::BIGINT:
+	case LogicalTypeId::UTINYINT:
+	case LogicalTypeId::USMALLINT:
+	case LogicalTypeId::UINTEGER:
+	case LogicalTypeId::DATE:
+		return true;
+	case LogicalTypeId::VARCHAR:
+		return !type.IsJSONType();
+	default:
+		return false;
+	}
+}
+
+void SnowflakeSemiJoinKeys::Reset() {
+	lock_guard<mutex> guard(lock);
+	complete = false;
+	overflow = false;
+	keys.clear();
+	table_name.clear();
+	ship_failed = false;
+}
+
+void SnowflakeSemiJoinKeys::SetKeys(value_set_t keys_p) {
+	lock_guard<mutex> guard(lock);
+	keys.assign(keys_p.begin(), keys_p.end());
+	complete = true;
+}
+
+void SnowflakeSemiJoinKeys::SetOverflow() {
+	lock_guard<mutex> guard(lock);
+	overflow = true;
+	complete = true;
+}
+
+string SnowflakeSemiJoinKeys::ShipKeys(ClientContext &context, const shared_ptr<SnowflakeClient> &client) {
+	auto uuid = StringUtil::Replace(UUID::ToString(UUID::GenerateRandomUUID()), "-", "");
+	auto name = "DUCKDB_JOIN_KEYS_" + StringUtil::Upper(uuid);
+	auto key_type = type.id() == LogicalTypeId::VARCHAR ? "VARCHAR"
+	                : type.id() == LogicalTypeId::DATE  ? "DATE"
+	                                                    : "NUMBER(38, 0)";
+	client->ExecuteAndGetStrings(context,
+	                             "CREATE TEMPORARY TABLE " + SnowflakeQueryBuilder::QuoteIdentifier(name) + " (" +
+	                                 SnowflakeQueryBuilder::QuoteIdentifier(KEY_COLUMN) + " " + key_type + ")",
+	                             {});
+	SnowflakeSemiJoinTables::Get(context).Add(client, name);
+
+	auto &allocator = Allocator::Get(context);
+	auto collection = make_uniq<ColumnDataCollection>(allocator, vector<LogicalType> {type});
+	DataChunk chunk;
+	chunk.Initialize(allocator, vector<LogicalType> {type});
+	for (auto &key : keys) {
+		chunk.SetValue(0, chunk.size(), key);
+		chunk.SetCardinality(chunk.size() + 1);
+		if (chunk.size() == STANDARD_VECTOR_SIZE) {
+			collection->Append(chunk);
+			chunk.Reset();
+		}
+	}
+	if (chunk.size() > 0) {
+		collection->Append(chunk);
+	}
+	auto result = make_uniq<MaterializedQueryResult>(StatementType::SELECT_STATEMENT, StatementProperties(),
+	                                                 vector<string> {KEY_COLUMN}, std::move(collection),
+	                                                 context.GetClientProperties());
+	// Releasing the stream deletes the wrapper; the driver releases it once ingested
+	auto wrapper = new ResultArrowArrayStreamWrapper(std::move(result), INGEST_BATCH_ROWS);
+	auto stream = wrapper->stream;
+	wrapper->stream.release = nullptr;
+	client->Ingest(name, stream);
+	DPRINT("SnowflakeSemiJoinKeys: shipped %zu keys to %s\n", keys.size(), name.c_str());
+	return name;
+}
+
+string SnowflakeSemiJoinKeys::GetPredicate(ClientContext &context, const shared_ptr<SnowflakeClient> &client,
+                                           const string &column) {
+	lock_guard<mutex> guard(lock);
+	if (!complete || overflow) {
+		return string();
+	}
+	if (keys.empty()) {
+		// The join cannot match any row
+		return "FALSE";
+	}
+	if (keys.size() <= MAX_IN_LIST_KEYS) {
+		vector<string> values;
+		for (auto &key : keys) {
+			string value;
+			if (!SnowflakeExpressionTranslator::TranslateConstant(key, value)) {
+				return string();
+			}
+			values.push_back(std::move(value));
+		}
+		return column + " IN (" + StringUtil::Join(values, ", ") + ")";
+	}
+	if (table_name.empty() && !ship_failed) {
+		try {
+			table_name = ShipKeys(context, client);
+		} catch (std::exception &ex) {
+			// E.g. no privilege to create tables in the session's schema; the join still filters locally
+			DPRINT("SnowflakeSemiJoinKeys: could not ship keys: %s\n", ex.what());
+			ship_failed = true;
+		}
+	}
+	if (table_name.empty()) {
+		return string();
+	}
+	return column + " IN (SELECT " + SnowflakeQueryBuilder::QuoteIdentifier(KEY_COLUMN) + " FROM " +
+	       SnowflakeQueryBuilder::QuoteIdentifier(table_name) + ")";
+}
+
+SnowflakeSemiJoinTables &SnowflakeSemiJoinTables::Get(ClientContext &context) {
+	return *context.registered_state->GetOrCreate<SnowflakeSemiJoinTables>("snowflake_semi_join_tables");
+}
+
+void SnowflakeSemiJoinTables::Add(shared_ptr<SnowflakeClient> client, string table_name) {
+	lock_guard<mutex> guard(lock);
+	tables.emplace_back(std::move(client), std::move(table_name));
+}
+
+void SnowflakeSemiJoinTables::QueryEnd(ClientContext &context) {
+	lock_guard<mutex> guard(lock);
+	for (auto &table : tables) {
+		try {
+			table.first->ExecuteAndGetStrings(
+			    context, "DROP TABLE IF EXISTS " + SnowflakeQueryBuilder::QuoteIdentifier(table.second), {});
+		} catch (std::exception &ex) {
+			// Temporary tables are dropped with the session at the latest
+			DPRINT("SnowflakeSemiJoinTables: could not drop %s: %s\n", table.second.c_str(), ex.what());
+		}
+	}
+	tables.clear();
+}
+
+LogicalSnowflakeKeyCollector::LogicalSnowflakeKeyCollector(shared_ptr<SnowflakeSemiJoinKeys> keys_p,
+                                                           unique_ptr<Expression> key)
+    : keys(std::move(keys_p)) {
+	expressions.push_back(std::move(key));
+}
+
+vector<ColumnBinding> LogicalSnowflakeKeyCollector::GetColumnBindings() {
+	return children[0]->GetColumnBindings();
+}
+
+void LogicalSnowflakeKeyCollector::ResolveTypes() {
+	types = children[0]->types;
+}
+
+PhysicalOperator &LogicalSnowflakeKeyCollector::CreatePlan(ClientContext &context, PhysicalPlanGenerator &planner) {
+	auto &child = planner.CreatePlan(*children[0]);
+	auto &collector = planner.Make<PhysicalSnowflakeKeyCollector>(types, std::move(expressions[0]), keys,
+	                                                              estimated_cardinality);
+	collector.children.push_back(child);
+	return collector;
+}
+
+string LogicalSnowflakeKeyCollector::GetExtensionName() const {
+	return "snowflake_key_collector";
+}
+
+class KeyCollectorGlobalSinkState : public GlobalSinkState {
+public:
+	KeyCollectorGlobalSinkState(ClientContext &context, const vector<LogicalType> &types)
+	    : rows(BufferManager::GetBufferManager(context), types) {
+	}
+
+	mutex lock;
+	ColumnDataCollection rows;
+	value_set_t keys;
+	bool overflow = false;
+};
+
+class KeyCollectorLocalSinkState : public LocalSinkState {
+public:
+	KeyCollectorLocalSinkState(ClientContext &context, const vector<LogicalType> &types, const Expression &key)
+	    : rows(BufferManager::GetBufferManager(context), types), executor(context, key) {
+		rows.InitializeAppend(append_state);
+		key_chunk.Initialize(Allocator::Get(context), vector<LogicalType> {key.return_type});
+	}
+
+	ColumnDataCollection rows;
+	ColumnDataAppendState append_state;
+	ExpressionExecutor executor;
+	DataChunk key_chunk;
+	value_set_t keys;
+	bool overflow = false;
+};
+
+class KeyCollectorGlobalSourceState : public GlobalSourceState {
+public:
+	ColumnDataScanState scan_state;
+};
+
+PhysicalSnowflakeKeyCollector::PhysicalSnowflakeKeyCollector(PhysicalPlan &physical_plan, vector<LogicalType> types,
+                                                             unique_ptr<Expression> key_p,
+                                                             shared_ptr<SnowflakeSemiJoinKeys> keys_p,
+                                                             idx_t estimated_cardinality)
+    : PhysicalOperator(physical_plan, PhysicalOperatorType::EXTENSION, std::move(types), estimated_cardinality),
+      key(std::move(key_p)), keys(std::move(keys_p)) {
+}
+
+unique_ptr<GlobalSinkState> PhysicalSnowflakeKeyCollector::GetGlobalSinkState(ClientContext &context) const {
+	keys->Reset();
+	return make_uniq<KeyCollectorGlobalSinkState>(context, types);
+}
+
+unique_ptr<LocalSinkState> PhysicalSnowflakeKeyCollector::GetLocalSinkState(ExecutionContext &context) const {
+	return make_uniq<KeyCollectorLocalSinkState>(context.client, types, *key);
+}
+
+SinkResultType PhysicalSnowflakeKeyCollector::Sink(ExecutionContext &context, DataChunk &chunk,
+                                                   OperatorSinkInput &input) const {
+	auto &local_state = input.local_state.Cast<KeyCollectorLocalSinkState>();
+	local_state.rows.Append(local_state.append_state, chunk);
+	if (local_state.overflow) {
+		return SinkResultType::NEED_MORE_INPUT;
+	}
+	local_state.key_chunk.Reset();
+	local_state.executor.Execute(chunk, local_state.key_chunk);
+	auto &key_vector = local_state.key_chunk.data[0];
+	for (idx_t i = 0; i < chunk.size(); i++) {
+		auto value = key_vector.GetValue(i);
+		// NULL keys never match
+		if (!value.IsNull()) {
+			local_state.keys.insert(std::move(value));
+		}
+	}
+	if (local_state.keys.size() > keys->GetMaxKeys()) {
+		local_state.overflow = true;
+		local_state.keys.clear();
+	}
+	return SinkResultType::NEED_MORE_INPUT;
+}
+
+SinkCombineResultType PhysicalSnowflakeKeyCollector::Combine(ExecutionContext &context,
+                                                             OperatorSinkCombineInput &input) const {
+	auto &global_state = input.global_state.Cast<KeyCollectorGlobalSinkState>();
+	auto &local_state = input.local_state.Cast<KeyCollectorLocalSinkState>();
+	lock_guard<mutex> guard(global_state.lock);
+	global_state.rows.Combine(local_state.rows);
+	global_state.overflow = global_state.overflow || local_state.overflow;
+	if (!global_state.overflow) {
+		for (auto &value : local_state.keys) {
+			global_state.keys.insert(value);
+		}
+		global_state.overflow = global_state.keys.size() > keys->GetMaxKeys();
+	}
+	if (global_state.overflow) {
+		global_state.keys.clear();
+	}
+	return SinkCombineResultType::FINISHED;
+}
+
+SinkFinalizeType PhysicalSnowflakeKeyCollector::Finalize(Pipeline &pipeline, Event &event, ClientContext &context,
+                                                         OperatorSinkFinalizeInput &input) const {
+	auto &global_state = input.global_state.Cast<KeyCollectorGlobalSinkState>();
+	if (global_state.overflow) {
+		DPRINT("PhysicalSnowflakeKeyCollector: more than %llu keys\n", (unsigned long long)keys->GetMaxKeys());
+		keys->SetOverflow();
+	} else {
+		DPRINT("PhysicalSnowflakeKeyCollector: collected %zu keys\n", global_state.keys.size());
+		keys->SetKeys(std::move(global_state.keys));
+	}
+	return SinkFinalizeType::READY;
+}
+
+unique_ptr<GlobalSourceState> PhysicalSnowflakeKeyCollector::GetGlobalSourceState(ClientContext &context) const {
+	auto result = make_uniq<KeyCollectorGlobalSourceState>();
+	sink_state->Cast<KeyCollectorGlobalSinkState>().rows.InitializeScan(result->scan_state);
+	return std::move(result);
+}
+
+SourceResultType PhysicalSnowflakeKeyCollector::GetData(ExecutionContext &context, DataChunk &chunk,
+                                                        OperatorSourceInput &input) const {
+	auto &rows = sink_state->Cast<KeyCollectorGlobalSinkState>().rows;
+	auto &source_state = input.global_state.Cast<KeyCollectorGlobalSourceState>();
+	rows.Scan(source_state.scan_state, chunk);
+	return chunk.size() == 0 ? SourceResultType::FINISHED : SourceResultType::HAVE_MORE_OUTPUT;
+}
+
+string PhysicalSnowflakeKeyCollector::GetName() const {
+	return "SNOWFLAKE_KEY_COLLECTOR";
+}
+
+} // namespace snowflake
+} // namespace duckdb
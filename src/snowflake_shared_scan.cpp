@@ -0,0 +1,259 @@
+#include "snowflake_shared_scan.hpp"
+#include "snowflake_arrow_utils.hpp"
+#include "snowflake_debug.hpp"
+#include "duckdb/common/exception.hpp"
+#include "duckdb/main/client_context.hpp"
+
+#include <cerrno>
+#include <chrono>
+
+namespace duckdb {
+namespace snowflake {
+
+// How long consumers ahead wait for a lagging one to read before they retain batches beyond the limit instead; a
+// consumer can lag indefinitely, e.g. the probe side of a join whose build side reads the same query
+static constexpr idx_t LAGGING_CONSUMER_WAIT_SECONDS = 10;
+
+void SnowflakeSharedScan::ReleaseReadBatches() {
+	if (joinable) {
+		return;
+	}
+	idx_t min_position = batches.size();
+	for (auto &position : positions) {
+		min_position = MinValue(min_position, position.second);
+	}
+	for (; released_batches < min_position; released_batches++) {
+		retained_rows -= NumericCast<idx_t>(batches[released_batches]->arrow_array.length);
+		batches[released_batches].reset();
+	}
+	changed.notify_all();
+}
+
+//===--------------------------------------------------------------------===//
+// Consumer stream
+//===--------------------------------------------------------------------===//
+struct SharedArrayData {
+	shared_ptr<ArrowArrayWrapper> batch;
+};
+
+static void ReleaseSharedArray(ArrowArray *array) {
+	delete static_cast<SharedArrayData *>(array->private_data);
+	array->release = nullptr;
+}
+
+// Hands out a batch without copying: the array refers to the buffers and children of the shared batch and keeps
+// it alive until released
+static void ShareArray(const shared_ptr<ArrowArrayWrapper> &batch, ArrowArray &out) {
+	out = batch->arrow_array;
+	auto data = new SharedArrayData();
+	data->batch = batch;
+	out.private_data = data;
+	out.release = ReleaseSharedArray;
+}
+
+struct SharedStreamData {
+	shared_ptr<SnowflakeSharedScan> scan;
+	idx_t consumer;
+	string last_error;
+};
+
+static int SharedStreamGetSchema(ArrowArrayStream *stream, ArrowSchema *out) {
+	auto &data = *static_cast<SharedStreamData *>(stream->private_data);
+	auto &scan = *data.scan;
+	unique_lock<mutex> guard(scan.lock);
+	scan.changed.wait(guard, [&]() { return !scan.fetching; });
+	auto &source = scan.source->arrow_array_stream;
+	return source.get_schema(&source, out);
+}
+
+static int SharedStreamGetNext(ArrowArrayStream *stream, ArrowArray *out) {
+	auto &data = *static_cast<SharedStreamData *>(stream->private_data);
+	auto &scan = *data.scan;
+	unique_lock<mutex> guard(scan.lock);
+	while (scan.positions[data.consumer] == scan.batches.size()) {
+		if (scan.finished) {
+			if (!scan.error.empty()) {
+				data.last_error = scan.error;
+				return EIO;
+			}
+			memset(out, 0, sizeof(ArrowArray));
+			return 0;
+		}
+		if (scan.fetching) {
+			// Another consumer is reading the next batch
+			scan.changed.wait(guard);
+			continue;
+		}
+		if (scan.capped && !scan.joinable && scan.retained_rows > scan.max_buffered_rows) {
+			// Every batch after the position of the slowest consumer is retained, let it catch up first
+			auto caught_up = scan.changed.wait_for(guard, std::chrono::seconds(LAGGING_CONSUMER_WAIT_SECONDS), [&]() {
+				return scan.retained_rows <= scan.max_buffered_rows || scan.fetching || scan.finished;
+			});
+			if (!caught_up) {
+				DPRINT("SnowflakeSharedScans: a consumer stopped reading, retaining more than %llu rows\n",
+				       (unsigned long long)scan.max_buffered_rows);
+				scan.capped = false;
+			}
+			continue;
+		}
+		// This consumer is the furthest ahead, read the next batch for everyone; the others only wait for it if
+		// they need the batch too
+		scan.fetching = true;
+		guard.unlock();
+		auto &source = scan.source->arrow_array_stream;
+		ArrowArray array;
+		memset(&array, 0, sizeof(ArrowArray));
+		auto result = source.get_next(&source, &array);
+		string error;
+		if (result != 0) {
+			auto last_error = source.get_last_error(&source);
+			error = last_error ? last_error : "Failed to read from the Snowflake result stream";
+		}
+		guard.lock();
+		scan.fetching = false;
+		scan.changed.notify_all();
+		if (result != 0 || !array.release) {
+			if (result != 0) {
+				scan.error = std::move(error);
+				data.last_error = scan.error;
+			}
+			scan.finished = true;
+			SnowflakeSharedScans::Get().Close(scan);
+			memset(out, 0, sizeof(ArrowArray));
+			return result;
+		}
+		auto batch = make_shared_ptr<ArrowArrayWrapper>();
+		batch->arrow_array = array;
+		scan.buffered_rows += NumericCast<idx_t>(array.length);
+		scan.retained_rows += NumericCast<idx_t>(array.length);
+		scan.batches.push_back(std::move(batch));
+		if (scan.joinable && scan.buffered_rows > scan.max_buffered_rows) {
+			DPRINT("SnowflakeSharedScans: %llu rows buffered, no longer accepting consumers\n",
+			       (unsigned long long)scan.buffered_rows);
+			SnowflakeSharedScans::Get().Close(scan);
+		}
+	}
+	auto &position = scan.positions[data.consumer];
+	ShareArray(scan.batches[position], *out);
+	position++;
+	scan.ReleaseReadBatches();
+	return 0;
+}
+
+static const char *SharedStreamGetLastError(ArrowArrayStream *stream) {
+	return static_cast<SharedStreamData *>(stream->private_data)->last_error.c_str();
+}
+
+static void SharedStreamRelease(ArrowArrayStream *stream) {
+	auto data = static_cast<SharedStreamData *>(stream->private_data);
+	{
+		lock_guard<mutex> guard(data->scan->lock);
+		data->scan->positions.erase(data->consumer);
+		data->scan->ReleaseReadBatches();
+	}
+	delete data;
+	stream->release = nullptr;
+}
+
+//===--------------------------------------------------------------------===//
+// Registry
+//===--------------------------------------------------------------------===//
+SnowflakeSharedScans &SnowflakeSharedScans::Get() {
+	static SnowflakeSharedScans instance;
+	return instance;
+}
+
+bool SnowflakeSharedScans::IsEnabled(ClientContext &context, idx_t &max_buffered_rows) {
+	Value setting;
+	if (!context.TryGetCurrentSetting("snowflake_shared_scans", setting) || setting.IsNull() ||
+	    !BooleanValue::Get(setting)) {
+		return false;
+	}
+	max_buffered_rows = 1000000;
+	if (context.TryGetCurrentSetting("snowflake_shared_scan_max_rows", setting) && !setting.IsNull()) {
+		max_buffered_rows = UBigIntValue::Get(setting);
+	}
+	return true;
+}
+
+void SnowflakeSharedScans::Close(SnowflakeSharedScan &scan) {
+	if (!scan.joinable) {
+		return;
+	}
+	scan.joinable = false;
+	{
+		lock_guard<mutex> guard(lock);
+		auto entry = scans.find(scan.key);
+		if (entry != scans.end() && entry->second.lock().get() == &scan) {
+			scans.erase(entry);
+		}
+	}
+	scan.ReleaseReadBatches();
+}
+
+unique_ptr<ArrowArrayStreamWrapper> SnowflakeSharedScans::Open(shared_ptr<SnowflakeClient> connection,
+                                                               const string &key, const string &query,
+                                                               idx_t max_buffered_rows, bool track_query_id,
+                                                               string &executed_query_id) {
+	shared_ptr<SnowflakeSharedScan> scan;
+	unique_lock<mutex> scan_guard;
+	bool leader = false;
+	{
+		lock_guard<mutex> guard(lock);
+		auto entry = scans.find(key);
+		if (entry != scans.end()) {
+			scan = entry->second.lock();
+		}
+		if (!scan) {
+			scan = make_shared_ptr<SnowflakeSharedScan>();
+			scan->key = key;
+			scan->max_buffered_rows = max_buffered_rows;
+			scans[key] = scan;
+			leader = true;
+			// Consumers that join while the query executes wait for it on this lock
+			scan_guard = unique_lock<mutex>(scan->lock);
+		}
+	}
+	if (leader) {
+		try {
+			scan->factory = make_uniq<SnowflakeArrowStreamFactory>(connection, query);
+			scan->factory->track_query_id = track_query_id;
+			ArrowStreamParameters parameters;
+			scan->source = SnowflakeProduceArrowScan(reinterpret_cast<uintptr_t>(scan->factory.get()), parameters);
+			executed_query_id = scan->factory->query_id;
+		} catch (std::exception &ex) {
+			scan->error = ex.what();
+			scan->finished = true;
+			Close(*scan);
+			throw;
+		}
+	} else {
+		scan_guard = unique_lock<mutex>(scan->lock);
+		if (!scan->source) {
+			throw IOException("Failed to execute Snowflake query: %s", scan->error);
+		}
+		if (!scan->joinable) {
+			return nullptr;
+		}
+		DPRINT("SnowflakeSharedScans: joining a query in flight, %llu batches to replay\n",
+		       (unsigned long long)scan->batches.size());
+	}
+
+	auto data = make_uniq<SharedStreamData>();
+	data->scan = scan;
+	data->consumer = scan->next_consumer++;
+	scan->positions[data->consumer] = 0;
+
+	auto result = make_uniq<ArrowArrayStreamWrapper>();
+	auto &stream = result->arrow_array_stream;
+	stream.get_schema = SharedStreamGetSchema;
+	stream.get_next = SharedStreamGetNext;
+	stream.get_last_error = SharedStreamGetLastError;
+	stream.release = SharedStreamRelease;
+	stream.private_data = data.release();
+	result->number_of_rows = scan->source->number_of_rows;
+	return result;
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -0,0 +1,475 @@
+#include "snowflake_statistics.hpp"
+#include "snowflake_client.hpp"
+#include "snowflake_debug.hpp"
+#include "snowflake_query_builder.hpp"
+#include "snowflake_semantic_cache.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/storage/statistics/numeric_stats.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+namespace snowflake {
+
+SnowflakeTableStatistics::SnowflakeTableStatistics(shared_ptr<SnowflakeClient> client_p, string schema_p,
+                                                   string table_name_p)
+    : client(std::move(client_p)), schema(std::move(schema_p)), table_name(std::move(table_name_p)) {
+}
+
+SnowflakeTableStatistics::~SnowflakeTableStatistics() {
+	{
+		lock_guard<mutex> guard(lock);
+		shutting_down = true;
+		if (gather_connection) {
+			AdbcError error;
+			std::memset(&error, 0, sizeof(error));
+			if (AdbcConnectionCancel(gather_connection, &error) != ADBC_STATUS_OK && error.release) {
+				error.release(&error);
+			}
+		}
+	}
+	if (gatherer.joinable()) {
+		gatherer.join();
+	}
+}
+
+bool SnowflakeTableStatistics::IsEnabled(ClientContext &context, bool &gather, bool &learn, idx_t &ttl_seconds) {
+	Value setting;
+	gather = context.TryGetCurrentSetting("snowflake_statistics", setting) && !setting.IsNull() &&
+	         BooleanValue::Get(setting);
+	learn = context.TryGetCurrentSetting("snowflake_scan_statistics", setting) && !setting.IsNull() &&
+	        BooleanValue::Get(setting);
+	ttl_seconds = 300;
+	if (context.TryGetCurrentSetting("snowflake_statistics_ttl", setting) && !setting.IsNull()) {
+		ttl_seconds = UBigIntValue::Get(setting);
+	}
+	return gather || learn;
+}
+
+// Columns whose statistics are limited to NULLs and distinct values: nested and semi-structured values have no
+// statistics DuckDB could use
+static bool HasStatistics(const LogicalType &type) {
+	return !type.IsNested() && !type.IsJSONType();
+}
+
+// Strings are left out because Snowflake collations can order them unlike DuckDB, floats because of NaN, timestamps
+// because of time zone conversions
+bool SnowflakeTableStatistics::HasMinMax(const LogicalType &type) {
+	switch (type.id()) {
+	case LogicalTypeId::TINYINT:
+	case LogicalTypeId::SMALLINT:
+	case LogicalTypeId::INTEGER:
+	case LogicalTypeId::BIGINT:
+	case LogicalTypeId::HUGEINT:
+	case LogicalTypeId::UTINYINT:
+	case LogicalTypeId::USMALLINT:
+	case LogicalTypeId::UINTEGER:
+	case LogicalTypeId::UBIGINT:
+	case LogicalTypeId::UHUGEINT:
+	case LogicalTypeId::DECIMAL:
+	case LogicalTypeId::DATE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static string MinMaxToVarchar(const string &aggregate, const string &column, const LogicalType &type) {
+	if (type.id() == LogicalTypeId::DATE) {
+		return "TO_VARCHAR(" + aggregate + "(" + column + "), 'YYYY-MM-DD')";
+	}
+	return "TO_VARCHAR(" + aggregate + "(" + column + "))";
+}
+
+static optional_idx ParseCount(const string &value) {
+	if (value.empty()) {
+		return optional_idx();
+	}
+	return optional_idx(std::stoull(value));
+}
+
+static Value ParseBound(const string &value, const LogicalType &type) {
+	Value result;
+	if (value.empty() || !Value(value).DefaultTryCastAs(type, result)) {
+		return Value();
+	}
+	return result;
+}
+
+// Statistics of a column from its null, valid and distinct counts and, if known, its min and max
+static unique_ptr<BaseStatistics> CreateStatistics(const LogicalType &type, idx_t row_count, idx_t valid_count,
+                                                   optional_idx distinct_count, const Value &min, const Value &max) {
+	auto stats = BaseStatistics::CreateUnknown(type);
+	if (valid_count == row_count) {
+		stats.Set(StatsInfo::CANNOT_HAVE_NULL_VALUES);
+	}
+	if (valid_count == 0) {
+		stats.Set(StatsInfo::CANNOT_HAVE_VALID_VALUES);
+	}
+	if (distinct_count.IsValid()) {
+		stats.SetDistinctCount(distinct_count.GetIndex());
+	}
+	if (SnowflakeTableStatistics::HasMinMax(type) && !min.IsNull() && !max.IsNull()) {
+		NumericStats::SetMin(stats, min);
+		NumericStats::SetMax(stats, max);
+	}
+	return stats.ToUnique();
+}
+
+void SnowflakeTableStatistics::Reset(string current_last_altered) {
+	columns.clear();
+	row_count = optional_idx();
+	gathered = false;
+	last_altered = std::move(current_last_altered);
+}
+
+void SnowflakeTableStatistics::Validate(ClientContext &context, idx_t ttl_seconds) {
+	auto now = SnowflakeSemanticCache::CurrentTime();
+	if (last_altered.empty() || now < checked_at + ttl_seconds) {
+		return;
+	}
+	string current_last_altered;
+	try {
+		current_last_altered = client->GetLastAltered(context, schema, table_name);
+	} catch (std::exception &ex) {
+		DPRINT("SnowflakeTableStatistics: could not check LAST_ALTERED of %s: %s\n", table_name.c_str(), ex.what());
+		Reset(string());
+		return;
+	}
+	if (current_last_altered != last_altered) {
+		DPRINT("SnowflakeTableStatistics: %s was altered at %s\n", table_name.c_str(), current_last_altered.c_str());
+		Reset(std::move(current_last_altered));
+	}
+	checked_at = now;
+}
+
+void SnowflakeTableStatistics::StartGather(const vector<string> &names, const vector<LogicalType> &types) {
+	// A previous gather has published its result, so its thread is about to finish
+	if (gatherer.joinable()) {
+		gatherer.join();
+	}
+	gathering = true;
+	// The aggregate reads the whole table and may outlast the planning query; the destructor joins the thread
+	gatherer = std::thread([this, names, types]() { Gather(names, types); });
+}
+
+void SnowflakeTableStatistics::Gather(const vector<string> &names, const vector<LogicalType> &types) {
+	// Every result column is a string; remember where each table column's aggregates start
+	vector<string> aggregates {"TO_VARCHAR(COUNT(*))"};
+	vector<optional_idx> first_aggregate;
+	for (idx_t col_idx = 0; col_idx < names.size(); col_idx++) {
+		if (!HasStatistics(types[col_idx])) {
+			first_aggregate.emplace_back();
+			continue;
+		}
+		first_aggregate.emplace_back(aggregates.size());
+		auto column = SnowflakeQueryBuilder::QuoteIdentifier(names[col_idx]);
+		aggregates.push_back("TO_VARCHAR(COUNT(" + column + "))");
+		aggregates.push_back("TO_VARCHAR(APPROX_COUNT_DISTINCT(" + column + "))");
+		if (SnowflakeTableStatistics::HasMinMax(types[col_idx])) {
+			aggregates.push_back(MinMaxToVarchar("MIN", column, types[col_idx]));
+			aggregates.push_back(MinMaxToVarchar("MAX", column, types[col_idx]));
+		}
+	}
+	auto query = "SELECT " + StringUtil::Join(aggregates, ", ") + " FROM " + client->GetConfig().database + "." +
+	             schema + "." + table_name;
+	DPRINT("SnowflakeTableStatistics: %s\n", query.c_str());
+
+	string gathered_last_altered;
+	vector<vector<string>> result;
+	AdbcConnection *adbc_connection = nullptr;
+	try {
+		{
+			lock_guard<mutex> guard(lock);
+			if (shutting_down) {
+				return;
+			}
+			adbc_connection = client->AcquirePooledConnection();
+			gather_connection = adbc_connection;
+		}
+		// Read before the query, so a change made meanwhile only causes another query
+		gathered_last_altered = client->GetLastAltered(*adbc_connection, schema, table_name);
+		result = client->ExecuteAndGetStrings(*adbc_connection, query, {});
+	} catch (std::exception &ex) {
+		// Planning goes on without statistics until the TTL has passed
+		DPRINT("SnowflakeTableStatistics: could not gather statistics of %s: %s\n", table_name.c_str(), ex.what());
+		lock_guard<mutex> guard(lock);
+		if (adbc_connection) {
+			client->ReleasePooledConnection(adbc_connection);
+		}
+		gather_connection = nullptr;
+		gathering = false;
+		failed_at = SnowflakeSemanticCache::CurrentTime();
+		return;
+	}
+
+	lock_guard<mutex> guard(lock);
+	client->ReleasePooledConnection(adbc_connection);
+	gather_connection = nullptr;
+	gathering = false;
+	if (gathered_last_altered != last_altered) {
+		Reset(std::move(gathered_last_altered));
+	}
+	gathered = true;
+	checked_at = SnowflakeSemanticCache::CurrentTime();
+	if (result.size() != aggregates.size() || result[0].size() != 1) {
+		return;
+	}
+	auto gathered_rows = ParseCount(result[0][0]);
+	if (!gathered_rows.IsValid()) {
+		return;
+	}
+	if (!row_count.IsValid()) {
+		row_count = gathered_rows;
+	}
+	for (idx_t col_idx = 0; col_idx < names.size(); col_idx++) {
+		// Statistics learned from a scan are exact and take precedence
+		if (!first_aggregate[col_idx].IsValid() || columns.find(names[col_idx]) != columns.end()) {
+			continue;
+		}
+		auto aggregate_idx = first_aggregate[col_idx].GetIndex();
+		auto &type = types[col_idx];
+		auto valid_count = ParseCount(result[aggregate_idx][0]);
+		if (!valid_count.IsValid()) {
+			continue;
+		}
+		Value min;
+		Value max;
+		if (SnowflakeTableStatistics::HasMinMax(type)) {
+			min = ParseBound(result[aggregate_idx + 2][0], type);
+			max = ParseBound(result[aggregate_idx + 3][0], type);
+		}
+		columns[names[col_idx]] = CreateStatistics(type, gathered_rows.GetIndex(), valid_count.GetIndex(),
+		                                           ParseCount(result[aggregate_idx + 1][0]), min, max);
+	}
+	DPRINT("SnowflakeTableStatistics: gathered statistics of %s (%llu rows)\n", table_name.c_str(),
+	       (unsigned long long)gathered_rows.GetIndex());
+}
+
+unique_ptr<BaseStatistics> SnowflakeTableStatistics::GetColumn(ClientContext &context, const vector<string> &names,
+                                                               const vector<LogicalType> &types,
+                                                               idx_t column_index) {
+	bool gather;
+	bool learn;
+	idx_t ttl_seconds;
+	if (!IsEnabled(context, gather, learn, ttl_seconds) || column_index >= names.size()) {
+		return nullptr;
+	}
+	lock_guard<mutex> guard(lock);
+	Validate(context, ttl_seconds);
+	auto entry = columns.find(names[column_index]);
+	if (entry == columns.end()) {
+		if (gather && !gathered && !gathering && SnowflakeSemanticCache::CurrentTime() >= failed_at + ttl_seconds) {
+			StartGather(names, types);
+		}
+		return nullptr;
+	}
+	// Statistics taken before a change of the table would let DuckDB prune rows that now match, so LAST_ALTERED is
+	// confirmed before the first statistics of a table are handed to a query
+	if (SnowflakeConfirmedStatistics::Get(context).Confirm(*this)) {
+		Validate(context, 0);
+		entry = columns.find(names[column_index]);
+	}
+	if (entry == columns.end() || entry->second->GetType() != types[column_index]) {
+		return nullptr;
+	}
+	return entry->second->ToUnique();
+}
+
+optional_idx SnowflakeTableStatistics::GetRowCount() {
+	lock_guard<mutex> guard(lock);
+	return row_count;
+}
+
+bool SnowflakeTableStatistics::NeedsLearning(const vector<string> &names) {
+	lock_guard<mutex> guard(lock);
+	for (auto &name : names) {
+		if (columns.find(name) == columns.end()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+string SnowflakeTableStatistics::GetLastAltered(const string &listed_last_altered) {
+	lock_guard<mutex> guard(lock);
+	return last_altered.empty() ? listed_last_altered : last_altered;
+}
+
+void SnowflakeTableStatistics::Learn(const string &scan_last_altered, vector<string> names,
+                                     vector<unique_ptr<BaseStatistics>> stats, idx_t scanned_rows) {
+	lock_guard<mutex> guard(lock);
+	if (last_altered.empty()) {
+		// Possibly an outdated catalog listing: have the next plan confirm it
+		last_altered = scan_last_altered;
+		checked_at = 0;
+	} else if (scan_last_altered != last_altered) {
+		// The table changed while the statistics were taken
+		return;
+	}
+	for (idx_t i = 0; i < names.size(); i++) {
+		columns[names[i]] = std::move(stats[i]);
+	}
+	row_count = scanned_rows;
+	DPRINT("SnowflakeTableStatistics: learned statistics of %llu columns of %s\n", (unsigned long long)names.size(),
+	       table_name.c_str());
+}
+
+SnowflakeConfirmedStatistics &SnowflakeConfirmedStatistics::Get(ClientContext &context) {
+	return *context.registered_state->GetOrCreate<SnowflakeConfirmedStatistics>("snowflake_confirmed_statistics");
+}
+
+bool SnowflakeConfirmedStatistics::Confirm(const SnowflakeTableStatistics &statistics) {
+	lock_guard<mutex> guard(lock);
+	return confirmed.insert(&statistics).second;
+}
+
+void SnowflakeConfirmedStatistics::QueryEnd() {
+	lock_guard<mutex> guard(lock);
+	confirmed.clear();
+}
+
+SnowflakeStatisticsCollector::SnowflakeStatisticsCollector(shared_ptr<SnowflakeTableStatistics> statistics_p,
+                                                           string last_altered_p, const vector<string> &names,
+                                                           const vector<LogicalType> &types)
+    : statistics(std::move(statistics_p)), last_altered(std::move(last_altered_p)) {
+	for (idx_t col_idx = 0; col_idx < names.size(); col_idx++) {
+		if (names[col_idx].empty() || !HasStatistics(types[col_idx])) {
+			continue;
+		}
+		LearnedColumn column;
+		column.output_index = col_idx;
+		column.name = names[col_idx];
+		column.type = types[col_idx];
+		columns.push_back(std::move(column));
+	}
+}
+
+// Counts the valid rows of input and finds the rows holding its smallest and largest value
+template <class T>
+static idx_t ScanOrderedColumn(Vector &input, idx_t count, optional_idx &min_row, optional_idx &max_row) {
+	UnifiedVectorFormat format;
+	input.ToUnifiedFormat(count, format);
+	auto data = UnifiedVectorFormat::GetData<T>(format);
+	idx_t valid_count = 0;
+	T min_value = T();
+	T max_value = T();
+	for (idx_t row = 0; row < count; row++) {
+		auto idx = format.sel->get_index(row);
+		if (!format.validity.RowIsValid(idx)) {
+			continue;
+		}
+		if (valid_count == 0 || data[idx] < min_value) {
+			min_value = data[idx];
+			min_row = row;
+		}
+		if (valid_count == 0 || data[idx] > max_value) {
+			max_value = data[idx];
+			max_row = row;
+		}
+		valid_count++;
+	}
+	return valid_count;
+}
+
+static idx_t ScanColumn(Vector &input, idx_t count, const LogicalType &type, optional_idx &min_row,
+                        optional_idx &max_row) {
+	if (SnowflakeTableStatistics::HasMinMax(type)) {
+		switch (type.InternalType()) {
+		case PhysicalType::INT8:
+			return ScanOrderedColumn<int8_t>(input, count, min_row, max_row);
+		case PhysicalType::INT16:
+			return ScanOrderedColumn<int16_t>(input, count, min_row, max_row);
+		case PhysicalType::INT32:
+			return ScanOrderedColumn<int32_t>(input, count, min_row, max_row);
+		case PhysicalType::INT64:
+			return ScanOrderedColumn<int64_t>(input, count, min_row, max_row);
+		case PhysicalType::INT128:
+			return ScanOrderedColumn<hugeint_t>(input, count, min_row, max_row);
+		case PhysicalType::UINT8:
+			return ScanOrderedColumn<uint8_t>(input, count, min_row, max_row);
+		case PhysicalType::UINT16:
+			return ScanOrderedColumn<uint16_t>(input, count, min_row, max_row);
+		case PhysicalType::UINT32:
+			return ScanOrderedColumn<uint32_t>(input, count, min_row, max_row);
+		case PhysicalType::UINT64:
+			return ScanOrderedColumn<uint64_t>(input, count, min_row, max_row);
+		case PhysicalType::UINT128:
+			return ScanOrderedColumn<uhugeint_t>(input, count, min_row, max_row);
+		default:
+			break;
+		}
+	}
+	UnifiedVectorFormat format;
+	input.ToUnifiedFormat(count, format);
+	if (format.validity.AllValid()) {
+		return count;
+	}
+	idx_t valid_count = 0;
+	for (idx_t row = 0; row < count; row++) {
+		valid_count += format.validity.RowIsValid(format.sel->get_index(row));
+	}
+	return valid_count;
+}
+
+void SnowflakeStatisticsCollector::Update(DataChunk &chunk) {
+	// The chunk is summarized without the lock, only the summaries are merged under it
+	auto count = chunk.size();
+	vector<idx_t> valid_counts;
+	vector<Value> mins;
+	vector<Value> maxs;
+	vector<HyperLogLog> sketches(columns.size());
+	Vector hashes(LogicalType::HASH, count);
+	for (idx_t i = 0; i < columns.size(); i++) {
+		auto &column = columns[i];
+		auto &input = chunk.data[column.output_index];
+		optional_idx min_row;
+		optional_idx max_row;
+		valid_counts.push_back(ScanColumn(input, count, column.type, min_row, max_row));
+		mins.push_back(min_row.IsValid() ? input.GetValue(min_row.GetIndex()) : Value());
+		maxs.push_back(max_row.IsValid() ? input.GetValue(max_row.GetIndex()) : Value());
+		sketches[i].Update(input, hashes, count);
+	}
+
+	lock_guard<mutex> guard(lock);
+	for (idx_t i = 0; i < columns.size(); i++) {
+		auto &column = columns[i];
+		column.valid_count += valid_counts[i];
+		if (!mins[i].IsNull() && (column.min.IsNull() || mins[i] < column.min)) {
+			column.min = std::move(mins[i]);
+		}
+		if (!maxs[i].IsNull() && (column.max.IsNull() || maxs[i] > column.max)) {
+			column.max = std::move(maxs[i]);
+		}
+		column.distinct.Merge(sketches[i]);
+	}
+	row_count += count;
+	units_seen++;
+	PublishIfComplete();
+}
+
+void SnowflakeStatisticsCollector::SetUnitCount(idx_t unit_count_p) {
+	lock_guard<mutex> guard(lock);
+	unit_count = unit_count_p;
+	PublishIfComplete();
+}
+
+void SnowflakeStatisticsCollector::PublishIfComplete() {
+	if (published || !unit_count.IsValid() || units_seen < unit_count.GetIndex()) {
+		return;
+	}
+	published = true;
+	vector<string> names;
+	vector<unique_ptr<BaseStatistics>> stats;
+	for (auto &column : columns) {
+		names.push_back(column.name);
+		// The sketch can overestimate, but a column has no more distinct values than valid rows
+		auto distinct_count = MinValue<idx_t>(column.distinct.Count(), column.valid_count);
+		stats.push_back(
+		    CreateStatistics(column.type, row_count, column.valid_count, distinct_count, column.min, column.max));
+	}
+	statistics->Learn(last_altered, std::move(names), std::move(stats), row_count);
+}
+
+} // namespace snowflake
+} // namespace duckdb
@@ -4,6 +4,73 @@
 
 namespace duckdb {
 	namespace snowflake {
+		static string TrimTypeString(string str) {
+			StringUtil::Trim(str);
+			return str;
+		}
+
+		// Splits the parameter list of a structured type on its top-level commas
+		static vector<string> SplitTypeParameters(const string &params) {
+			vector<string> result;
+			idx_t depth = 0;
+			idx_t start = 0;
+			for (idx_t i = 0; i < params.size(); i++) {
+				if (params[i] == '(') {
+					depth++;
+				} else if (params[i] == ')') {
+					depth--;
+				} else if (params[i] == ',' && depth == 0) {
+					result.push_back(TrimTypeString(params.substr(start, i - start)));
+					start = i + 1;
+				}
+			}
+			result.push_back(TrimTypeString(params.substr(start)));
+			return result;
+		}
+
+		// Maps Snowflake's semi-structured and structured types. Untyped VARIANT, OBJECT and ARRAY values are exposed
+		// as JSON; structured OBJECT(...), ARRAY(...) and MAP(...) types become STRUCT, LIST and MAP
+		static LogicalType ConvertSemiStructured(const string &base_type, const string &snowflake_type_str) {
+			auto open_pos = snowflake_type_str.find('(');
+			auto close_pos = snowflake_type_str.rfind(')');
+			if (base_type == "VARIANT" || open_pos == std::string::npos) {
+				return LogicalType::JSON();
+			}
+			if (close_pos == std::string::npos || close_pos < open_pos) {
+				throw InvalidInputException("Expected closing ')' for %s type: %s", base_type, snowflake_type_str);
+			}
+			auto params = SplitTypeParameters(snowflake_type_str.substr(open_pos + 1, close_pos - open_pos - 1));
+
+			if (base_type == "ARRAY") {
+				return LogicalType::LIST(SnowflakeTypeToLogicalType(params[0]));
+			}
+			if (base_type == "MAP") {
+				if (params.size() != 2) {
+					throw InvalidInputException("MAP type requires a key and a value type: %s", snowflake_type_str);
+				}
+				return LogicalType::MAP(SnowflakeTypeToLogicalType(params[0]), SnowflakeTypeToLogicalType(params[1]));
+			}
+			// OBJECT(field_name TYPE [NOT NULL], ...)
+			child_list_t<LogicalType> children;
+			for (auto &field : params) {
+				auto space_pos = field.find(' ');
+				if (space_pos == std::string::npos) {
+					throw InvalidInputException("Invalid OBJECT field definition '%s' in type: %s", field,
+					                            snowflake_type_str);
+				}
+				auto field_name = field.substr(0, space_pos);
+				auto field_type = TrimTypeString(field.substr(space_pos + 1));
+				if (StringUtil::EndsWith(StringUtil::Upper(field_type), " NOT NULL")) {
+					field_type = field_type.substr(0, field_type.size() - 9);
+				}
+				if (field_name.size() >= 2 && field_name.front() == '"' && field_name.back() == '"') {
+					field_name = field_name.substr(1, field_name.size() - 2);
+				}
+				children.emplace_back(field_name, SnowflakeTypeToLogicalType(field_type));
+			}
+			return LogicalType::STRUCT(std::move(children));
+		}
+
 		LogicalType SnowflakeTypeToLogicalType(const std::string& snowflake_type_str) {
 			string normalized_type = StringUtil::Upper(snowflake_type_str);
 			normalized_type = StringUtil::Replace(normalized_type, " ", "");
@@ -11,6 +78,41 @@ namespace duckdb {
 			auto paren_pos = normalized_type.find('(');
 			string base_type = normalized_type.substr(0, paren_pos);
 
+			// Semi-structured types are parsed from the original string since OBJECT field names contain spaces
+			if (base_type == "VARIANT" || base_type == "OBJECT" || base_type == "ARRAY" || base_type == "MAP") {
+				return ConvertSemiStructured(base_type, TrimTypeString(snowflake_type_str));
+			}
+
+			// VECTOR(FLOAT|INT, N) maps to a fixed-size DuckDB array
+			if (base_type == "VECTOR") {
+				auto close_paren_pos = normalized_type.find(')');
+				auto comma_pos = normalized_type.find(',');
+				if (paren_pos == std::string::npos || close_paren_pos == std::string::npos ||
+				    comma_pos == std::string::npos || comma_pos > close_paren_pos) {
+					throw InvalidInputException("Expected VECTOR(<type>, <dimension>): " + snowflake_type_str);
+				}
+				auto element_type = normalized_type.substr(paren_pos + 1, comma_pos - paren_pos - 1);
+				auto dimension_str = normalized_type.substr(comma_pos + 1, close_paren_pos - comma_pos - 1);
+				idx_t dimension;
+				try {
+					dimension = std::stoull(dimension_str);
+				} catch (const std::exception &e) {
+					throw ConversionException("Invalid dimension '%s' in type: %s", dimension_str, snowflake_type_str);
+				}
+				if (dimension == 0 || dimension > ArrayType::MAX_ARRAY_SIZE) {
+					throw ConversionException("VECTOR dimension %llu out of range in type: %s", dimension,
+					                          snowflake_type_str);
+				}
+				if (element_type == "FLOAT") {
+					return LogicalType::ARRAY(LogicalType::FLOAT, dimension);
+				}
+				if (element_type == "INT") {
+					return LogicalType::ARRAY(LogicalType::INTEGER, dimension);
+				}
+				throw ConversionException("Unsupported VECTOR element type '%s' in type: %s", element_type,
+				                          snowflake_type_str);
+			}
+
 			if (base_type.find("INT") != std::string::npos) {
 				if (base_type == "TINYINT") {
 					return LogicalType::TINYINT;
@@ -6,8 +6,9 @@
 namespace duckdb {
 namespace snowflake {
 
-SnowflakeCatalog::SnowflakeCatalog(AttachedDatabase &db_p, const SnowflakeConfig &config)
-    : Catalog(db_p), client(SnowflakeClientManager::GetInstance().GetConnection(config)),
+SnowflakeCatalog::SnowflakeCatalog(AttachedDatabase &db_p, const SnowflakeConfig &config,
+                                   const SnowflakeOptions &options)
+    : Catalog(db_p), client(SnowflakeClientManager::GetInstance().GetConnection(config)), options(options),
       schemas(*this, client) {
 	DPRINT("SnowflakeCatalog constructor called\n");
 	if (!client || !client->IsConnected()) {
@@ -56,7 +57,15 @@ void SnowflakeCatalog::DropSchema(ClientContext &context, DropInfo &info) {
 }
 
 DatabaseSize SnowflakeCatalog::GetDatabaseSize(ClientContext &context) {
-	throw NotImplementedException("Snowflake catalog does not support getting database size");
+	// Block statistics do not apply, only the storage Snowflake reports for the database's tables
+	DatabaseSize result;
+	auto query = "SELECT TO_VARCHAR(COALESCE(SUM(bytes), 0)) FROM " + client->GetConfig().database +
+	             ".information_schema.tables";
+	auto sizes = client->ExecuteAndGetStrings(context, query, {});
+	if (!sizes.empty() && !sizes[0].empty() && !sizes[0][0].empty()) {
+		result.bytes = std::stoull(sizes[0][0]);
+	}
+	return result;
 }
 
 bool SnowflakeCatalog::InMemory() {
@@ -49,8 +49,21 @@ static unique_ptr<Catalog> SnowflakeAttach(StorageExtensionInfo *storage_info, C
 		throw NotImplementedException("Snowflake currently only supports read-only access");
 	}
 
+	SnowflakeOptions options;
+	options.access_mode = access_mode;
+	for (auto &entry : info.options) {
+		auto option = StringUtil::Lower(entry.first);
+		if (option == "replicate_max_rows") {
+			options.replicate_max_rows = entry.second.GetValue<uint64_t>();
+		} else if (option == "replicate_max_bytes") {
+			options.replicate_max_bytes = entry.second.GetValue<uint64_t>();
+		} else if (option == "replicate_ttl") {
+			options.replicate_ttl_seconds = entry.second.GetValue<uint64_t>();
+		}
+	}
+
 	DPRINT("Creating SnowflakeCatalog\n");
-	return make_uniq<SnowflakeCatalog>(db, config);
+	return make_uniq<SnowflakeCatalog>(db, config, options);
 }
 
 SnowflakeStorageExtension::SnowflakeStorageExtension() {
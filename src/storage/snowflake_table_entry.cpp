@@ -3,6 +3,7 @@
 #include "snowflake_client_manager.hpp"
 #include "snowflake_scan.hpp"
 #include "snowflake_arrow_utils.hpp"
+#include "storage/snowflake_catalog.hpp"
 #include "duckdb/storage/table_storage_info.hpp"
 #include "duckdb/function/table/arrow.hpp"
 
@@ -14,7 +15,8 @@ TableFunction SnowflakeTableEntry::GetScanFunction(ClientContext &context, uniqu
 	       schema.name.c_str(), name.c_str());
 
 	auto &config = client->GetConfig();
-	string query = "SELECT * FROM " + config.database + "." + schema.name + "." + name;
+	string table_ref = config.database + "." + schema.name + "." + name;
+	string query = "SELECT * FROM " + table_ref;
 	DPRINT("SnowflakeTableEntry: Query = '%s'\n", query.c_str());
 
 	// TODO consider maintaining a thread-safe pool of connections in client, so we can use the client within
@@ -26,20 +28,51 @@ TableFunction SnowflakeTableEntry::GetScanFunction(ClientContext &context, uniqu
 	DPRINT("SnowflakeTableEntry: Created factory at %p\n", (void *)factory.get());
 
 	auto snowflake_bind_data = make_uniq<SnowflakeScanBindData>(std::move(factory));
-	// TODO remove below line after implementing projection pushdown
-	snowflake_bind_data->projection_pushdown_enabled = false;
 
-	DPRINT("SnowflakeTableEntry: About to call SnowflakeGetArrowSchema\n");
-	SnowflakeGetArrowSchema(reinterpret_cast<ArrowArrayStream *>(snowflake_bind_data->factory.get()),
-	                        snowflake_bind_data->schema_root.arrow_schema);
-	DPRINT("SnowflakeTableEntry: SnowflakeGetArrowSchema completed\n");
+	// Small tables are scanned from their local copy, which needs no round trip to resolve the schema either; the
+	// first scan that executes fetches it
+	auto local_copy = columns_loaded && IsReplicated() ? GetReplica(context) : nullptr;
+	if (local_copy) {
+		DPRINT("SnowflakeTableEntry: Scanning the local copy of %s\n", table_ref.c_str());
+		snowflake_bind_data->all_types = columns.GetColumnTypes();
+		snowflake_bind_data->query.source = table_ref;
+		snowflake_bind_data->query.column_names = columns.GetColumnNames();
+		snowflake_bind_data->replica = std::move(local_copy);
+		bind_data = std::move(snowflake_bind_data);
+		return GetSnowflakeScanFunction();
+	}
 
 	vector<string> names;
 	vector<LogicalType> return_types;
 
-	ArrowTableFunction::PopulateArrowTableType(DBConfig::GetConfig(context), snowflake_bind_data->arrow_table,
-	                                           snowflake_bind_data->schema_root, names, return_types);
-	snowflake_bind_data->all_types = return_types;
+	// Nested types are only inferred the first time; later scans keep the column types the catalog already exposes
+	idx_t inference_rows = 0;
+	Value inference_setting;
+	if (!columns_loaded && context.TryGetCurrentSetting("snowflake_variant_inference_rows", inference_setting) &&
+	    !inference_setting.IsNull()) {
+		inference_rows = UBigIntValue::Get(inference_setting);
+	}
+	DPRINT("SnowflakeTableEntry: About to resolve the result schema\n");
+	SnowflakeBindSchema(context, *snowflake_bind_data, table_ref, names, return_types, inference_rows);
+	DPRINT("SnowflakeTableEntry: Result schema resolved\n");
+	if (columns_loaded) {
+		snowflake_bind_data->all_types = columns.GetColumnTypes();
+	}
+	// Table scans only differ in columns and filters, which the semantic cache can reason about
+	snowflake_bind_data->semantic_cache_source = SnowflakeResultCache::GetKey(config, table_ref);
+	snowflake_bind_data->table_schema = schema.name;
+	snowflake_bind_data->table_name = name;
+	snowflake_bind_data->table_last_altered = metadata.last_altered;
+	snowflake_bind_data->is_base_table = metadata.IsBaseTable();
+	snowflake_bind_data->estimated_cardinality = metadata.row_count;
+	snowflake_bind_data->statistics = statistics;
+	snowflake_bind_data->collated_columns = GetCollatedColumns(context);
+	// Only late materialization splits scans on the key, so the lookup is skipped unless it is enabled
+	Value late_materialization;
+	if (context.TryGetCurrentSetting("snowflake_late_materialization", late_materialization) &&
+	    !late_materialization.IsNull() && BooleanValue::Get(late_materialization)) {
+		snowflake_bind_data->primary_key = GetPrimaryKey(context);
+	}
 
 	// Populate columns if not already loaded (first time accessing this table)
 	if (!columns_loaded) {
@@ -49,6 +82,9 @@ TableFunction SnowflakeTableEntry::GetScanFunction(ClientContext &context, uniqu
 		}
 		columns_loaded = true;
 	}
+	if (IsReplicated()) {
+		snowflake_bind_data->replica = GetReplica(context);
+	}
 
 	DPRINT("SnowflakeTableEntry: Setting bind_data at %p\n", (void *)snowflake_bind_data.get());
 	bind_data = std::move(snowflake_bind_data);
@@ -57,14 +93,103 @@ TableFunction SnowflakeTableEntry::GetScanFunction(ClientContext &context, uniqu
 	return GetSnowflakeScanFunction();
 }
 
+bool SnowflakeTableEntry::IsReplicated() const {
+	auto &options = catalog.Cast<SnowflakeCatalog>().GetOptions();
+	if (options.replicate_max_rows == 0 && options.replicate_max_bytes == 0) {
+		return false;
+	}
+	if (options.replicate_max_rows > 0 &&
+	    (!metadata.row_count.IsValid() || metadata.row_count.GetIndex() > options.replicate_max_rows)) {
+		return false;
+	}
+	if (options.replicate_max_bytes > 0 &&
+	    (!metadata.bytes.IsValid() || metadata.bytes.GetIndex() > options.replicate_max_bytes)) {
+		return false;
+	}
+	return true;
+}
+
+shared_ptr<SnowflakeTableReplica> SnowflakeTableEntry::GetReplica(ClientContext &context) {
+	lock_guard<mutex> guard(replica_lock);
+	auto now = SnowflakeSemanticCache::CurrentTime();
+	if (!replica) {
+		// The recorded LAST_ALTERED predates the fetch, so a change made meanwhile only causes an extra refetch
+		replica = make_shared_ptr<SnowflakeTableReplica>();
+		replica_checked_at = now;
+		return replica;
+	}
+	auto ttl_seconds = catalog.Cast<SnowflakeCatalog>().GetOptions().replicate_ttl_seconds;
+	if (now < replica_checked_at + ttl_seconds) {
+		return replica;
+	}
+	string last_altered;
+	try {
+		last_altered = client->GetLastAltered(context, schema.name, name);
+	} catch (std::exception &ex) {
+		// Let the regular scan report whatever went wrong
+		DPRINT("SnowflakeTableEntry: could not check LAST_ALTERED of %s: %s\n", name.c_str(), ex.what());
+		replica.reset();
+		return nullptr;
+	}
+	if (last_altered != replica_last_altered) {
+		DPRINT("SnowflakeTableEntry: %s was altered at %s, dropping its local copy\n", name.c_str(),
+		       last_altered.c_str());
+		replica = make_shared_ptr<SnowflakeTableReplica>();
+		replica_last_altered = last_altered;
+	}
+	replica_checked_at = now;
+	return replica;
+}
+
+vector<string> SnowflakeTableEntry::GetPrimaryKey(ClientContext &context) {
+	lock_guard<mutex> guard(primary_key_lock);
+	if (!primary_key_loaded) {
+		try {
+			primary_key = client->GetPrimaryKey(context, schema.name, name);
+		} catch (std::exception &ex) {
+			// Without a known key the table is scanned as usual
+			DPRINT("SnowflakeTableEntry: could not look up the primary key of %s: %s\n", name.c_str(), ex.what());
+			primary_key.clear();
+		}
+		primary_key_loaded = true;
+	}
+	return primary_key;
+}
+
+case_insensitive_set_t SnowflakeTableEntry::GetCollatedColumns(ClientContext &context) {
+	lock_guard<mutex> guard(collation_lock);
+	if (!collations_loaded) {
+		try {
+			for (auto &column : client->GetTableInfo(context, schema.name, name)) {
+				if (!column.collation.empty()) {
+					DPRINT("SnowflakeTableEntry: %s.%s is collated as %s\n", name.c_str(), column.name.c_str(),
+					       column.collation.c_str());
+					collated_columns.insert(column.name);
+				}
+			}
+		} catch (std::exception &ex) {
+			// Without the column listing the table is scanned as before; collations are rarely set
+			DPRINT("SnowflakeTableEntry: could not look up the collations of %s: %s\n", name.c_str(), ex.what());
+			collated_columns.clear();
+		}
+		collations_loaded = true;
+	}
+	return collated_columns;
+}
+
 unique_ptr<BaseStatistics> SnowflakeTableEntry::GetStatistics(ClientContext &context, column_t column_id) {
-	// TODO get statistics from snowflake
-	throw NotImplementedException("Snowflake does not support getting statistics for tables");
+	if (!columns_loaded || IsRowIdColumnId(column_id)) {
+		return nullptr;
+	}
+	return statistics->GetColumn(context, columns.GetColumnNames(), columns.GetColumnTypes(), column_id);
 }
 
 TableStorageInfo SnowflakeTableEntry::GetStorageInfo(ClientContext &context) {
 	TableStorageInfo result;
-	result.cardinality = 100000; // TODO get actual storage info from snowflake
+	// Row counts come with the catalog listing; views have none
+	if (metadata.row_count.IsValid()) {
+		result.cardinality = metadata.row_count.GetIndex();
+	}
 	result.index_info = vector<IndexInfo>();
 	return result;
 }
@@ -5,19 +5,19 @@
 namespace duckdb {
 namespace snowflake {
 void SnowflakeTableSet::LoadEntries(ClientContext &context) {
-	auto table_names = client->ListTables(context, schema_name);
+	auto tables = client->ListTables(context, schema_name);
 
-	for (const auto &table_name : table_names) {
+	for (auto &table : tables) {
 		CreateTableInfo info;
-		info.table = table_name;
+		info.table = table.name;
 		info.schema = schema_name;
 		info.catalog = schema.catalog.GetName();
 		info.on_conflict = OnCreateConflict::IGNORE_ON_CONFLICT;
 		info.temporary = false;
 
-		auto table_entry = make_uniq<SnowflakeTableEntry>(schema.catalog, schema, info, client);
+		auto table_entry = make_uniq<SnowflakeTableEntry>(schema.catalog, schema, info, client, table);
 
-		entries[table_name] = std::move(table_entry);
+		entries[table.name] = std::move(table_entry);
 	}
 }
 } // namespace snowflake
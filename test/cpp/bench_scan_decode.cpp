@@ -0,0 +1,214 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include "duckdb.hpp"
+#include "duckdb/common/arrow/arrow_wrapper.hpp"
+#include "duckdb/function/table/arrow.hpp"
+#include "duckdb/main/connection.hpp"
+#include "snowflake_decoder.hpp"
+
+using namespace duckdb;
+using namespace duckdb::snowflake;
+
+// Decode-throughput benchmark for the Snowflake scan: converts the same synthetic record batches once with
+// DuckDB's generic ArrowToDuckDB path and once with the specialized Snowflake decoders.
+// The batch sizes are deliberately irregular to mimic what Snowflake returns.
+
+struct OwnedColumn {
+    std::vector<uint8_t> validity;
+    std::vector<uint8_t> data;
+    std::vector<int32_t> offsets;
+    const void *buffers[3];
+    ArrowArray array;
+};
+
+struct OwnedBatch {
+    std::vector<std::unique_ptr<OwnedColumn>> columns;
+    std::vector<ArrowArray *> children;
+};
+
+static void ReleaseChild(ArrowArray *array) {
+    array->release = nullptr;
+}
+
+static void ReleaseBatch(ArrowArray *array) {
+    delete static_cast<OwnedBatch *>(array->private_data);
+    array->release = nullptr;
+}
+
+static void ReleaseSchema(ArrowSchema *schema) {
+    for (int64_t i = 0; i < schema->n_children; i++) {
+        delete schema->children[i];
+    }
+    delete[] schema->children;
+    schema->release = nullptr;
+}
+
+static ArrowSchema *MakeField(const char *format, const char *name) {
+    auto field = new ArrowSchema();
+    std::memset(field, 0, sizeof(*field));
+    field->format = format;
+    field->name = name;
+    field->flags = ARROW_FLAG_NULLABLE;
+    field->release = [](ArrowSchema *schema) { schema->release = nullptr; };
+    return field;
+}
+
+static void MakeSchema(ArrowSchema &schema) {
+    std::memset(&schema, 0, sizeof(schema));
+    schema.format = "+s";
+    schema.n_children = 3;
+    schema.children = new ArrowSchema *[3];
+    schema.children[0] = MakeField("l", "id");
+    schema.children[1] = MakeField("g", "amount");
+    schema.children[2] = MakeField("u", "name");
+    schema.release = ReleaseSchema;
+}
+
+static void FinishColumn(OwnedColumn &column, int64_t length, int64_t null_count, int64_t n_buffers) {
+    std::memset(&column.array, 0, sizeof(column.array));
+    column.buffers[0] = null_count > 0 ? column.validity.data() : nullptr;
+    column.buffers[1] = n_buffers == 3 ? static_cast<const void *>(column.offsets.data()) : column.data.data();
+    column.buffers[2] = column.data.data();
+    column.array.length = length;
+    column.array.null_count = null_count;
+    column.array.n_buffers = n_buffers;
+    column.array.buffers = column.buffers;
+    column.array.release = ReleaseChild;
+}
+
+static shared_ptr<ArrowArrayWrapper> MakeBatch(int64_t length, bool with_nulls, std::mt19937 &rng) {
+    auto owned = new OwnedBatch();
+    int64_t null_count = 0;
+    for (int col = 0; col < 3; col++) {
+        owned->columns.push_back(std::unique_ptr<OwnedColumn>(new OwnedColumn()));
+    }
+    auto &validity = owned->columns[0]->validity;
+    validity.assign((length + 7) / 8, 0xFF);
+    if (with_nulls) {
+        for (int64_t row = 0; row < length; row += 17) {
+            validity[row / 8] &= ~(1 << (row % 8));
+            null_count++;
+        }
+    }
+
+    auto &ids = *owned->columns[0];
+    ids.data.resize(length * sizeof(int64_t));
+    auto &amounts = *owned->columns[1];
+    amounts.data.resize(length * sizeof(double));
+    auto &names = *owned->columns[2];
+    names.offsets.push_back(0);
+    for (int64_t row = 0; row < length; row++) {
+        reinterpret_cast<int64_t *>(ids.data.data())[row] = static_cast<int64_t>(rng());
+        reinterpret_cast<double *>(amounts.data.data())[row] = static_cast<double>(rng()) / 7.0;
+        auto name = "customer_name_" + std::to_string(rng() % 100000);
+        names.data.insert(names.data.end(), name.begin(), name.end());
+        names.offsets.push_back(static_cast<int32_t>(names.data.size()));
+    }
+    amounts.validity = validity;
+    names.validity = validity;
+    FinishColumn(ids, length, null_count, 2);
+    FinishColumn(amounts, length, null_count, 2);
+    FinishColumn(names, length, null_count, 3);
+
+    auto result = make_shared_ptr<ArrowArrayWrapper>();
+    auto &array = result->arrow_array;
+    std::memset(&array, 0, sizeof(array));
+    for (auto &column : owned->columns) {
+        owned->children.push_back(&column->array);
+    }
+    array.length = length;
+    array.n_children = 3;
+    array.children = owned->children.data();
+    array.private_data = owned;
+    array.release = ReleaseBatch;
+    return result;
+}
+
+int main() {
+    const int64_t total_rows = 20000000;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int64_t> batch_size(1, 60000);
+
+    std::vector<shared_ptr<ArrowArrayWrapper>> batches;
+    int64_t rows = 0;
+    while (rows < total_rows) {
+        auto length = std::min(batch_size(rng), total_rows - rows);
+        // Roughly half of the batches contain NULLs, the other half take the no-validity fast path
+        batches.push_back(MakeBatch(length, batches.size() % 2 == 0, rng));
+        rows += length;
+    }
+    std::cout << "Decoding " << rows << " rows in " << batches.size() << " batches" << std::endl;
+
+    DuckDB db;
+    Connection con(db);
+    auto &context = *con.context;
+
+    ArrowSchemaWrapper schema;
+    MakeSchema(schema.arrow_schema);
+    ArrowTableType arrow_table;
+    vector<string> names;
+    vector<LogicalType> types;
+    ArrowTableFunction::PopulateArrowTableType(DBConfig::GetConfig(context), arrow_table, schema, names, types);
+
+    DataChunk output;
+    output.Initialize(Allocator::DefaultAllocator(), types);
+
+    // Generic path: every batch is cut into chunks by DuckDB's Arrow conversion, small batches stay small
+    auto start = std::chrono::steady_clock::now();
+    idx_t generic_chunks = 0;
+    for (auto &batch : batches) {
+        ArrowScanLocalState state(batch, context);
+        state.column_ids = {0, 1, 2};
+        auto length = NumericCast<idx_t>(batch->arrow_array.length);
+        while (state.chunk_offset < length) {
+            auto count = MinValue<idx_t>(STANDARD_VECTOR_SIZE, length - state.chunk_offset);
+            output.Reset();
+            output.SetCardinality(count);
+            ArrowTableFunction::ArrowToDuckDB(state, arrow_table.GetColumns(), output, 0, false);
+            state.chunk_offset += count;
+            generic_chunks++;
+        }
+    }
+    auto generic_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Snowflake path: batches are re-aligned to STANDARD_VECTOR_SIZE and decoded by the specialized decoders
+    vector<SnowflakeDecoderKind> decoders;
+    for (idx_t col_idx = 0; col_idx < types.size(); col_idx++) {
+        decoders.push_back(GetSnowflakeDecoderKind(*schema.arrow_schema.children[col_idx], types[col_idx]));
+    }
+    start = std::chrono::steady_clock::now();
+    idx_t snowflake_chunks = 0;
+    SnowflakeBatchAligner aligner;
+    std::deque<SnowflakeScanUnit> units;
+    auto decode_units = [&]() {
+        while (!units.empty()) {
+            auto &unit = units.front();
+            output.Reset();
+            idx_t out_offset = 0;
+            for (auto &segment : unit.segments) {
+                for (idx_t col_idx = 0; col_idx < decoders.size(); col_idx++) {
+                    SnowflakeDecodeColumn(decoders[col_idx], segment, col_idx, output.data[col_idx], out_offset);
+                }
+                out_offset += segment.count;
+            }
+            output.SetCardinality(unit.count);
+            units.pop_front();
+            snowflake_chunks++;
+        }
+    };
+    for (auto &batch : batches) {
+        aligner.Append(batch, units);
+        decode_units();
+    }
+    aligner.Finalize(units);
+    decode_units();
+    auto snowflake_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "generic ArrowToDuckDB:   " << generic_ms << " ms, " << generic_chunks << " chunks, "
+              << (rows / generic_ms / 1000.0) << " M rows/s" << std::endl;
+    std::cout << "snowflake decoders:      " << snowflake_ms << " ms, " << snowflake_chunks << " chunks, "
+              << (rows / snowflake_ms / 1000.0) << " M rows/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <iostream>
+#include "duckdb.hpp"
+#include "duckdb/planner/filter/conjunction_filter.hpp"
+#include "duckdb/planner/filter/constant_filter.hpp"
+#include "duckdb/planner/filter/null_filter.hpp"
+#include "snowflake_semantic_cache.hpp"
+
+using namespace duckdb;
+using namespace duckdb::snowflake;
+
+// Offline checks of SnowflakeCachePredicate::Implies, which decides whether a scan can be answered from a cached
+// entry. No Snowflake connection is needed.
+
+static int failures = 0;
+
+static void Check(const std::string &name, bool actual, bool expected) {
+    if (actual != expected) {
+        std::cerr << "FAIL: " << name << ": expected " << (expected ? "true" : "false") << std::endl;
+        failures++;
+    } else {
+        std::cout << "ok: " << name << std::endl;
+    }
+}
+
+static unique_ptr<TableFilter> Compare(ExpressionType comparison, const Value &constant) {
+    return make_uniq<ConstantFilter>(comparison, constant);
+}
+
+static SnowflakeCachePredicate Predicate(const std::string &column, const TableFilter &filter,
+                                         const std::string &sql) {
+    SnowflakeCachePredicate predicate;
+    predicate.AddFilter(column, filter, sql);
+    return predicate;
+}
+
+int main() {
+    auto gt5 = Compare(ExpressionType::COMPARE_GREATERTHAN, Value::INTEGER(5));
+    auto ge5 = Compare(ExpressionType::COMPARE_GREATERTHANOREQUALTO, Value::INTEGER(5));
+    auto gt10 = Compare(ExpressionType::COMPARE_GREATERTHAN, Value::INTEGER(10));
+    auto lt10 = Compare(ExpressionType::COMPARE_LESSTHAN, Value::INTEGER(10));
+    auto le10 = Compare(ExpressionType::COMPARE_LESSTHANOREQUALTO, Value::INTEGER(10));
+    auto eq7 = Compare(ExpressionType::COMPARE_EQUAL, Value::INTEGER(7));
+    auto gt5_bigint = Compare(ExpressionType::COMPARE_GREATERTHAN, Value::BIGINT(5));
+    auto ne7 = Compare(ExpressionType::COMPARE_NOTEQUAL, Value::INTEGER(7));
+    IsNotNullFilter not_null;
+
+    auto x_gt5 = Predicate("X", *gt5, "X > 5");
+    auto x_ge5 = Predicate("X", *ge5, "X >= 5");
+    auto x_gt10 = Predicate("X", *gt10, "X > 10");
+    auto x_lt10 = Predicate("X", *lt10, "X < 10");
+    auto x_le10 = Predicate("X", *le10, "X <= 10");
+    auto x_eq7 = Predicate("X", *eq7, "X = 7");
+    auto x_not_null = Predicate("X", not_null, "X IS NOT NULL");
+    auto x_gt5_bigint = Predicate("X", *gt5_bigint, "X > 5");
+    auto x_ne7 = Predicate("X", *ne7, "X <> 7");
+    SnowflakeCachePredicate everything;
+
+    // Narrower ranges imply wider ones, not the other way around
+    Check("x > 10 implies x > 5", x_gt10.Implies(x_gt5), true);
+    Check("x > 5 does not imply x > 10", x_gt5.Implies(x_gt10), false);
+    Check("x > 5 implies itself", x_gt5.Implies(x_gt5), true);
+
+    // Inclusive and exclusive bounds on the same constant
+    Check("x > 5 implies x >= 5", x_gt5.Implies(x_ge5), true);
+    Check("x >= 5 does not imply x > 5", x_ge5.Implies(x_gt5), false);
+    Check("x < 10 implies x <= 10", x_lt10.Implies(x_le10), true);
+    Check("x <= 10 does not imply x < 10", x_le10.Implies(x_lt10), false);
+
+    // Equality is a range with both bounds
+    SnowflakeCachePredicate x_between;
+    x_between.AddFilter("X", *ge5, "X >= 5");
+    x_between.AddFilter("X", *le10, "X <= 10");
+    Check("x = 7 implies 5 <= x <= 10", x_eq7.Implies(x_between), true);
+    Check("5 <= x <= 10 does not imply x = 7", x_between.Implies(x_eq7), false);
+
+    // A conjunction narrows the range like separate filters do
+    ConjunctionAndFilter x_gt5_and_lt10;
+    x_gt5_and_lt10.child_filters.push_back(Compare(ExpressionType::COMPARE_GREATERTHAN, Value::INTEGER(5)));
+    x_gt5_and_lt10.child_filters.push_back(Compare(ExpressionType::COMPARE_LESSTHAN, Value::INTEGER(10)));
+    auto x_in_range = Predicate("X", x_gt5_and_lt10, "X > 5 AND X < 10");
+    Check("5 < x < 10 implies x >= 5", x_in_range.Implies(x_ge5), true);
+    Check("5 < x < 10 implies x <= 10", x_in_range.Implies(x_le10), true);
+    Check("x > 5 does not imply 5 < x < 10", x_gt5.Implies(x_in_range), false);
+
+    // Comparisons never hold for NULL
+    Check("x > 5 implies x IS NOT NULL", x_gt5.Implies(x_not_null), true);
+    Check("x IS NOT NULL does not imply x > 5", x_not_null.Implies(x_gt5), false);
+
+    // An entry fetched without a predicate holds every row
+    Check("x > 5 implies no predicate", x_gt5.Implies(everything), true);
+    Check("no predicate implies itself", everything.Implies(everything), true);
+    Check("no predicate does not imply x > 5", everything.Implies(x_gt5), false);
+
+    // Bounds of different types are not compared
+    Check("x > 5 (BIGINT) does not imply x > 5 (INTEGER)", x_gt5_bigint.Implies(x_gt5), false);
+
+    // Filters on other columns only narrow the scan further
+    auto x_gt10_y_eq7 = x_gt10;
+    x_gt10_y_eq7.AddFilter("Y", *eq7, "Y = 7");
+    Check("x > 10 AND y = 7 implies x > 5", x_gt10_y_eq7.Implies(x_gt5), true);
+    Check("x > 10 does not imply y = 7", x_gt10.Implies(Predicate("Y", *eq7, "Y = 7")), false);
+
+    // Filters that are not ranges are only matched textually
+    Check("x <> 7 implies itself", x_ne7.Implies(x_ne7), true);
+    Check("x > 5 does not imply x <> 7", x_gt5.Implies(x_ne7), false);
+    auto x_ne7_gt10 = x_ne7;
+    x_ne7_gt10.AddFilter("X", *gt10, "X > 10");
+    Check("x <> 7 AND x > 10 implies x <> 7", x_ne7_gt10.Implies(x_ne7), true);
+    Check("x <> 7 AND x > 10 implies x > 5", x_ne7_gt10.Implies(x_gt5), true);
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}